@@ -0,0 +1,284 @@
+/// @file
+/// @brief Simulator throughput benchmark
+///
+/// Runs the nusim simulation loop without ROS communication: physics (forward
+/// kinematics and detect_collision()) at the nusim rate, and the fake sensors
+/// (fill_basic_sensor_obstacles() and the simulated lidar) at 5 Hz, for worlds with
+/// increasing obstacle counts and lidars with increasing beam counts. Reports the
+/// per-call cost of each component and the simulated seconds per wall-clock second
+/// as JSON.
+///
+/// USAGE:
+///   sim_bench [--obstacles N1,N2,...] [--beams N1,N2,...] [--duration SECONDS]
+///             [--seed S] [--out FILE]
+///     --obstacles: comma separated obstacle counts (default 0,10,100,1000,10000)
+///     --beams: comma separated lidar beam counts (default 360,1440,5760)
+///     --duration: simulated seconds per configuration (default 60)
+///     --seed: seed of the random number generator (default 0)
+///     --out: JSON output file (default sim_bench.json)
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nusim/utils.hpp"
+#include "turtlelib/benchmark.hpp"
+#include "turtlelib/diff_drive.hpp"
+#include "turtlelib/lidar.hpp"
+#include "turtlelib/rigid2d.hpp"
+#include "turtlelib/world.hpp"
+
+using turtlelib::Vector2D;
+
+/// @cond
+namespace
+{
+
+// Same defaults as the nusim node and config/basic_world.yaml
+constexpr int RATE = 200;
+constexpr double SENSOR_PERIOD = 0.2;
+constexpr double OBSTACLES_R = 0.038;
+constexpr double COLLISION_RADIUS = 0.105;
+constexpr double BASIC_MAX_RANGE = 1.0;
+constexpr double BASIC_SENSOR_VARIANCE = 0.001;
+constexpr double LIDAR_MAX_RANGE = 3.5;
+constexpr double LIDAR_VARIANCE = 0.001;
+
+// Obstacles are spread uniformly at a constant density so the number in sensor range stays
+// realistic as the world grows
+constexpr double OBSTACLE_DENSITY = 1.0;   // obstacles per square meter
+
+// Wheel speeds (rad/s) which drive the robot in a wide circle
+constexpr double LEFT_SPEED = 4.0;
+constexpr double RIGHT_SPEED = 5.0;
+
+std::vector<Vector2D> generate_obstacles(size_t n, uint32_t seed)
+{
+  turtlelib::WorldParams params;
+  params.x_length = std::sqrt(n / OBSTACLE_DENSITY);
+  params.y_length = params.x_length;
+  params.obstacle_radius = OBSTACLES_R;
+  params.density = OBSTACLE_DENSITY;
+  params.min_spacing = 0.0;
+  params.start_clearance = 0.0;
+  params.seed = seed;
+  return turtlelib::generate_world(params).obstacles;
+}
+
+/// @brief results for one obstacle count / beam count pair
+struct SimResult
+{
+  size_t obstacles = 0;
+  size_t beams = 0;
+  size_t steps = 0;
+  size_t collisions = 0;
+  turtlelib::SampleStats kinematics_us;
+  turtlelib::SampleStats collision_us;
+  turtlelib::SampleStats basic_sensor_us;
+  turtlelib::SampleStats lidar_us;
+  double wall_s = 0.0;
+};
+
+SimResult run_sim(
+  const std::vector<Vector2D> & obstacles, size_t beams, double duration_s,
+  std::mt19937 & rng)
+{
+  SimResult res;
+  res.obstacles = obstacles.size();
+  res.beams = beams;
+
+  // fill_basic_sensor_obstacles() takes the obstacles as separate coordinates
+  std::vector<double> obstacles_x;
+  std::vector<double> obstacles_y;
+  for (const auto & ob : obstacles) {
+    obstacles_x.push_back(ob.x);
+    obstacles_y.push_back(ob.y);
+  }
+
+  turtlelib::LidarParams lidar;
+  lidar.num_beams = beams;
+  lidar.angle_increment = 2.0 * turtlelib::PI / beams;
+  lidar.max_range = LIDAR_MAX_RANGE;
+  lidar.noise_stddev = LIDAR_VARIANCE;
+  std::vector<float> ranges;
+
+  turtlelib::DiffDrive ddrive;
+  turtlelib::Pose2D true_pose{0.0, 0.0, 0.0};
+  turtlelib::WheelState wheel_angles{0.0, 0.0};
+
+  const size_t n_steps = static_cast<size_t>(duration_s * RATE);
+  const size_t sensor_every = static_cast<size_t>(SENSOR_PERIOD * RATE);
+
+  const turtlelib::Stopwatch wall;
+  for (size_t step = 0; step < n_steps; step++) {
+    turtlelib::Stopwatch sw;
+    wheel_angles.left += LEFT_SPEED / RATE;
+    wheel_angles.right += RIGHT_SPEED / RATE;
+    true_pose = ddrive.forward_kinematics(true_pose, wheel_angles);
+    res.kinematics_us.add(sw.elapsed_us());
+
+    sw.reset();
+    if (detect_collision(true_pose, obstacles, OBSTACLES_R, COLLISION_RADIUS)) {
+      res.collisions++;
+    }
+    res.collision_us.add(sw.elapsed_us());
+
+    if (step % sensor_every == 0) {
+      sw.reset();
+      visualization_msgs::msg::MarkerArray fake_sensor_marker_arr;
+      fill_basic_sensor_obstacles(
+        fake_sensor_marker_arr, obstacles_x, obstacles_y,
+        OBSTACLES_R, true_pose, BASIC_MAX_RANGE, BASIC_SENSOR_VARIANCE);
+      res.basic_sensor_us.add(sw.elapsed_us());
+
+      sw.reset();
+      turtlelib::simulate_lidar(true_pose, obstacles, OBSTACLES_R, lidar, rng, ranges);
+      res.lidar_us.add(sw.elapsed_us());
+    }
+    res.steps++;
+  }
+  res.wall_s = wall.elapsed_s();
+  return res;
+}
+
+/// @brief simulated seconds per wall-clock second of a component
+/// @param stats per-call times of the component in microseconds
+/// @param sim_s the simulated time covered by the calls
+double realtime_factor(const turtlelib::SampleStats & stats, double sim_s)
+{
+  if (stats.total() <= 0.0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return sim_s / (stats.total() * 1e-6);
+}
+
+std::vector<size_t> parse_counts(const std::string & arg)
+{
+  std::vector<size_t> counts;
+  std::stringstream ss(arg);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    counts.push_back(std::stoul(item));
+  }
+  return counts;
+}
+
+}
+/// @endcond
+
+/// @brief runs the simulator throughput benchmark
+int main(int argc, char * argv[])
+{
+  std::vector<size_t> obstacle_counts{0, 10, 100, 1000, 10000};
+  std::vector<size_t> beam_counts{360, 1440, 5760};
+  double duration_s = 60.0;
+  unsigned int seed = 0;
+  std::string out_path = "sim_bench.json";
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--obstacles" and i + 1 < argc) {
+      obstacle_counts = parse_counts(argv[++i]);
+    } else if (arg == "--beams" and i + 1 < argc) {
+      beam_counts = parse_counts(argv[++i]);
+    } else if (arg == "--duration" and i + 1 < argc) {
+      duration_s = std::stod(argv[++i]);
+    } else if (arg == "--seed" and i + 1 < argc) {
+      seed = std::stoul(argv[++i]);
+    } else if (arg == "--out" and i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      std::cerr << "usage: sim_bench [--obstacles N1,N2,...] [--beams N1,N2,...]"
+                << " [--duration SECONDS] [--seed S] [--out FILE]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::mt19937 rng{seed};
+  std::ofstream out(out_path);
+  turtlelib::JsonWriter json(out);
+
+  // the simulation is single threaded, so one instance can run per hardware thread
+  const size_t cores = std::thread::hardware_concurrency();
+
+  json.begin_object();
+  json.key("benchmark");
+  json.value("nusim_throughput");
+  json.key("rate_hz");
+  json.value(RATE);
+  json.key("sensor_period_s");
+  json.value(SENSOR_PERIOD);
+  json.key("duration_s");
+  json.value(duration_s);
+  json.key("hardware_threads");
+  json.value(cores);
+  json.key("seed");
+  json.value(static_cast<size_t>(seed));
+  json.key("configurations");
+  json.begin_array();
+
+  for (const auto n : obstacle_counts) {
+    const std::vector<Vector2D> obstacles =
+      n > 0 ? generate_obstacles(n, seed) : std::vector<Vector2D>{};
+    for (const auto beams : beam_counts) {
+      std::cout << "Simulating " << n << " obstacles with " << beams << " beams" << std::endl;
+      const SimResult res = run_sim(obstacles, beams, duration_s, rng);
+      const double sim_s = static_cast<double>(res.steps) / RATE;
+      const double rtf = res.wall_s > 0.0 ? sim_s / res.wall_s : 0.0;
+
+      json.begin_object();
+      json.key("obstacles");
+      json.value(res.obstacles);
+      json.key("beams");
+      json.value(res.beams);
+      json.key("steps");
+      json.value(res.steps);
+      json.key("collisions");
+      json.value(res.collisions);
+      json.key("sim_s");
+      json.value(sim_s);
+      json.key("wall_s");
+      json.value(res.wall_s);
+      json.key("sim_s_per_wall_s");
+      json.value(rtf);
+      json.key("parallel_sims_realtime");
+      json.value(static_cast<size_t>(std::floor(rtf * cores)));
+      json.key("components_us");
+      json.begin_object();
+      json.key("kinematics");
+      json.value(res.kinematics_us);
+      json.key("detect_collision");
+      json.value(res.collision_us);
+      json.key("basic_sensor");
+      json.value(res.basic_sensor_us);
+      json.key("lidar");
+      json.value(res.lidar_us);
+      json.end_object();
+      json.key("components_sim_s_per_wall_s");
+      json.begin_object();
+      json.key("kinematics");
+      json.value(realtime_factor(res.kinematics_us, sim_s));
+      json.key("detect_collision");
+      json.value(realtime_factor(res.collision_us, sim_s));
+      json.key("basic_sensor");
+      json.value(realtime_factor(res.basic_sensor_us, sim_s));
+      json.key("lidar");
+      json.value(realtime_factor(res.lidar_us, sim_s));
+      json.end_object();
+      json.end_object();
+    }
+  }
+
+  json.end_array();
+  json.end_object();
+  out << std::endl;
+
+  std::cout << "Wrote simulator benchmark results to " << out_path << std::endl;
+  return 0;
+}
@@ -48,9 +48,29 @@ void fill_basic_sensor_obstacles(
   double obstacles_r, const turtlelib::Pose2D & true_pose,
   double max_range, double basic_sensor_variance);
 
+/// @brief checks for collisions between the robot and the obstacles and, if there
+/// is one, moves the robot out of the obstacle along the line between their centers,
+/// so it slides along the tangent line between the two collision circles
+///
+/// Credit to https://flatredball.com/documentation/tutorials/math/circle-collision/ which
+/// which provides a description of similar motion, "Circle Move Collision"
+/// @param pose the true pose of the robot, updated if there is a collision
+/// @param obstacles the centers of the obstacles
+/// @param obstacles_r the radius of the obstacles
+/// @param collision_radius the radius of the robot's collision circle
+/// @return true if the robot collided with an obstacle
+bool detect_collision(
+  turtlelib::Pose2D & pose, const std::vector<turtlelib::Vector2D> & obstacles,
+  double obstacles_r, double collision_radius);
+
 /// @brief gets a random number, ensuring you are only seeding the
 /// random number generator once
 /// Credit: Matt Elwin https://nu-msr.github.io/navigation_site/lectures/gaussian.html
 std::mt19937 & get_random();
 
+/// @brief reseeds the random number generator returned by get_random,
+/// so a simulation run can be reproduced exactly
+/// @param seed the new seed
+void seed_random(unsigned int seed);
+
 #endif
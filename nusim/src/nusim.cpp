@@ -8,12 +8,35 @@
 ///     obstacles/x (std::vector<double>): Array of x locations of obstacles
 ///     obstacles/y (std::vector<double>): Array of y locations of obstacles
 ///     obstacles/r (double): Radius of the obtacles
+///     moving_obstacles/x (std::vector<double>): Array of x start locations of moving obstacles
+///     moving_obstacles/y (std::vector<double>): Array of y start locations of moving obstacles
+///     moving_obstacles/goal_x (std::vector<double>): x locations the moving obstacles patrol
+///         back and forth to, or empty for random walks
+///     moving_obstacles/goal_y (std::vector<double>): y locations the moving obstacles patrol
+///         back and forth to, or empty for random walks
+///     moving_obstacles/speed (double): speed of the moving obstacles in m/s
+///     moving_obstacles/turn_stddev (double): standard deviation of the heading change of
+///         the random walks in rad per square root of a second
+///     seed (int): seed of the random number generator, or -1 to seed it randomly
+///     scan_record_file (std::string): if set, every fake lidar scan is appended to this
+///         scan log (see turtlelib/scan_log.hpp) with the true pose and obstacles, for
+///         tuning the landmark detector offline (default "", no recording)
+///     gyro_noise (double): standard deviation of the simulated yaw gyro noise in rad/s
+///     gyro_bias (double): constant bias of the simulated yaw gyro in rad/s
+///     resource_period (double): seconds between reports of the CPU time, memory, and
+///         message rates of the node on /diagnostics, 0 to disable (default 5.0)
 /// PUBLISHES:
 ///     nusim/timestep (std_msgs/msg/UInt64): simulation timestep
 ///     nusim/obstacles (visualization_msgs/msg/MarkerArray): array of Marker messages
+///     nusim/moving_obstacles (visualization_msgs/msg/MarkerArray): current locations of the
+///         moving obstacles
 ///		/red/sensor_data (nuturtlebot_msgs/msg/SensorData): wheel encoder values
 ///		/scan (sensor_msgs/msg/LaserScan): fake lidar sensor
 ///		/fake_sensor (visualization_msgs/msg/MarkerArray): fake basic sensor that detects obstacles
+///		/red/imu (sensor_msgs/msg/Imu): true yaw rate of the robot, unaffected by wheel slip,
+///		    from a simulated gyro with bias and noise
+///		/diagnostics (diagnostic_msgs/msg/DiagnosticArray): CPU time of the node and its
+///		    threads, its memory, and the rates of its topics, every resource_period
 /// SUBSCRIBES:
 ///     /red/wheel_cmd (nuturtlebot_msgs/msg/WheelCommands): integer valued wheel command speeds
 /// SERVERS:
@@ -22,6 +45,7 @@
 /// CLIENTS:
 ///     None
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <functional>
@@ -38,13 +62,20 @@
 #include "nusim/srv/teleport.hpp"
 #include "nuturtlebot_msgs/msg/sensor_data.hpp"
 #include "nuturtlebot_msgs/msg/wheel_commands.hpp"
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
 
 #include "geometry_msgs/msg/transform_stamped.hpp"
 #include "geometry_msgs/msg/pose2_d.hpp"
 #include "nav_msgs/msg/path.hpp"
+#include "sensor_msgs/msg/imu.hpp"
 #include "sensor_msgs/msg/laser_scan.hpp"
 
 #include "turtlelib/diff_drive.hpp"
+#include "turtlelib/lidar.hpp"
+#include "turtlelib/moving_obstacles.hpp"
+#include "turtlelib/resource_monitor.hpp"
+#include "turtlelib/resource_status.hpp"
+#include "turtlelib/scan_log.hpp"
 
 #include "tf2/LinearMath/Quaternion.h"
 #include "tf2_ros/transform_broadcaster.h"
@@ -78,6 +109,12 @@ public:
     declare_parameter<std::vector<double>>("obstacles/x", obstacles_x);
     declare_parameter<std::vector<double>>("obstacles/y", obstacles_y);
     declare_parameter<double>("obstacles/r", obstacles_r);
+    declare_parameter<std::vector<double>>("moving_obstacles/x", std::vector<double>{});
+    declare_parameter<std::vector<double>>("moving_obstacles/y", std::vector<double>{});
+    declare_parameter<std::vector<double>>("moving_obstacles/goal_x", std::vector<double>{});
+    declare_parameter<std::vector<double>>("moving_obstacles/goal_y", std::vector<double>{});
+    declare_parameter<double>("moving_obstacles/speed", MOVING_SPEED);
+    declare_parameter<double>("moving_obstacles/turn_stddev", MOVING_TURN_STDDEV);
     declare_parameter<double>("motor_cmd_per_rad_sec", MOTOR_CMD_PER_RAD_SEC);
     declare_parameter<int>("motor_cmd_max", MOTOR_CMD_MAX);
     declare_parameter<double>("encoder_ticks_per_rad", ENCODER_TICKS_PER_RAD);
@@ -93,12 +130,20 @@ public:
     declare_parameter<double>("lidar_increment", LIDAR_INCREMENT);
     declare_parameter<double>("lidar_variance", LIDAR_VARIANCE);
     declare_parameter<bool>("draw_only", DRAW_ONLY);
+    declare_parameter<int>("seed", SEED);
+    declare_parameter<std::string>("scan_record_file", "");
+    declare_parameter<double>("gyro_noise", GYRO_NOISE);
+    declare_parameter<double>("gyro_bias", GYRO_BIAS);
+    declare_parameter<double>("resource_period", RESOURCE_PERIOD);
 
     // Get parameters
     obstacles_r = get_parameter("obstacles/r").get_value<double>();
     obstacles_x = get_parameter("obstacles/x").get_value<std::vector<double>>();
     obstacles_y = get_parameter("obstacles/y").get_value<std::vector<double>>();
     assert(obstacles_x.size() == obstacles_y.size());
+    for (size_t i = 0; i < obstacles_x.size(); i++) {
+      obstacles.push_back(turtlelib::Vector2D{obstacles_x.at(i), obstacles_y.at(i)});
+    }
     MOTOR_CMD_PER_RAD_SEC = get_parameter("motor_cmd_per_rad_sec").get_value<double>();
     MOTOR_CMD_MAX = get_parameter("motor_cmd_max").get_value<int>();
     ENCODER_TICKS_PER_RAD = get_parameter("encoder_ticks_per_rad").get_value<double>();
@@ -116,6 +161,22 @@ public:
     LIDAR_INCREMENT = get_parameter("lidar_increment").get_value<double>();
     LIDAR_VARIANCE = get_parameter("lidar_variance").get_value<double>();
     DRAW_ONLY = get_parameter("draw_only").get_value<bool>();
+    SEED = get_parameter("seed").get_value<int>();
+    const auto scan_record_file = get_parameter("scan_record_file").get_value<std::string>();
+    GYRO_NOISE = get_parameter("gyro_noise").get_value<double>();
+    GYRO_BIAS = get_parameter("gyro_bias").get_value<double>();
+    RESOURCE_PERIOD = get_parameter("resource_period").get_value<double>();
+    X_LENGTH = get_parameter("wall_x_length").get_value<double>();
+    Y_LENGTH = get_parameter("wall_y_length").get_value<double>();
+    MOVING_SPEED = get_parameter("moving_obstacles/speed").get_value<double>();
+    MOVING_TURN_STDDEV = get_parameter("moving_obstacles/turn_stddev").get_value<double>();
+
+    // Fixed seed for reproducible runs
+    if (SEED >= 0) {
+      seed_random(static_cast<unsigned int>(SEED));
+    }
+
+    init_moving_obstacles();
 
     // Check for required parameters
     if (turtlelib::almost_equal(MOTOR_CMD_PER_RAD_SEC, 0.0)) {
@@ -133,6 +194,11 @@ public:
       throw std::runtime_error("encoder_ticks_per_rad parameter missing");
     }
 
+    if (RESOURCE_PERIOD < 0.0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "resource_period cannot be negative");
+      throw std::runtime_error("resource_period cannot be negative");
+    }
+
     /// @brief timestep publisher (std_msgs/msg/UInt64)
     timestep_pub = create_publisher<std_msgs::msg::UInt64>("~/timestep", 10);
 
@@ -140,6 +206,10 @@ public:
     marker_arr_pub = create_publisher<visualization_msgs::msg::MarkerArray>(
       "~/obstacles", 10);
 
+    /// @brief moving obstacle marker publisher (visualization_msgs/msg/MarkerArray)
+    moving_marker_arr_pub = create_publisher<visualization_msgs::msg::MarkerArray>(
+      "~/moving_obstacles", 10);
+
     /// @brief marker publisher for fake basic sensor (visualization_msgs/msg/MarkerArray)
     fake_sensor_marker_arr_pub = create_publisher<visualization_msgs::msg::MarkerArray>(
       "/fake_sensor", 10);
@@ -152,10 +222,28 @@ public:
     sensor_data_pub = create_publisher<nuturtlebot_msgs::msg::SensorData>(
       "red/sensor_data", 10);
 
+    /// @brief red/imu publisher with the yaw rate from the simulated gyro
+    imu_pub = create_publisher<sensor_msgs::msg::Imu>("red/imu", 10);
+
     /// @brief publishes the path (nav_msgs/Path)
     path_pub = create_publisher<nav_msgs::msg::Path>(
       "/nusim/path", 10);
 
+    /// @brief publishes the resources used by the node (diagnostic_msgs/msg/DiagnosticArray)
+    diagnostics_pub = create_publisher<diagnostic_msgs::msg::DiagnosticArray>(
+      "/diagnostics", 10);
+
+    wheel_cmd_count = resources.add_subscription("red/wheel_cmd");
+    timestep_count = resources.add_publisher("~/timestep");
+    tf_count = resources.add_publisher("/tf");
+    sensor_data_count = resources.add_publisher("red/sensor_data");
+    imu_count = resources.add_publisher("red/imu");
+    path_count = resources.add_publisher("/nusim/path");
+    marker_arr_count = resources.add_publisher("~/obstacles");
+    moving_marker_arr_count = resources.add_publisher("~/moving_obstacles");
+    fake_sensor_count = resources.add_publisher("/fake_sensor");
+    fake_lidar_count = resources.add_publisher("/scan");
+
     /// @brief subscription ot wheel_cmd to get the commanded
     /// integer values which detemines the wheel velocities
     wheel_cmd_sub = create_subscription<nuturtlebot_msgs::msg::WheelCommands>(
@@ -189,6 +277,12 @@ public:
       200ms,
       std::bind(&Nusim::fake_sensors_timer_callback, this));
 
+    if (RESOURCE_PERIOD > 0.0) {
+      resource_timer = create_wall_timer(
+        std::chrono::milliseconds((int)(1000 * RESOURCE_PERIOD)),
+        std::bind(&Nusim::resource_timer_callback, this));
+    }
+
     // Ground truth pose of the robot known only to the simulator
     // Initial values are passed as parameters to the node
     true_pose.x = X0;
@@ -199,10 +293,27 @@ public:
     fill_obstacles(marker_arr, obstacles_x, obstacles_y, obstacles_r);
     fill_walls(marker_arr, X_LENGTH, Y_LENGTH);
 
+    // moving obstacles are drawn in yellow, and only their positions change afterwards
+    std::vector<double> moving_x, moving_y;
+    for (const auto & p : moving_obstacles.positions()) {
+      moving_x.push_back(p.x);
+      moving_y.push_back(p.y);
+    }
+    fill_obstacles(moving_marker_arr, moving_x, moving_y, obstacles_r);
+    for (auto & marker : moving_marker_arr.markers) {
+      marker.color.g = 1.0;
+    }
+
     // Define parent and child frame id's
     world_red_tf.header.frame_id = "nusim/world";
     world_red_tf.child_frame_id = "red/base_footprint";
 
+    // The simulated IMU only measures the yaw rate
+    imu_msg.header.frame_id = "red/base_footprint";
+    imu_msg.orientation_covariance.at(0) = -1.0;
+    imu_msg.linear_acceleration_covariance.at(0) = -1.0;
+    imu_msg.angular_velocity_covariance.at(8) = GYRO_NOISE * GYRO_NOISE;
+
     // Define frame for path message
     path_msg.header.frame_id = "/nusim/world";
 
@@ -218,17 +329,47 @@ public:
     for (size_t i = 0; i < 360; i++) {
       fake_lidar_msg.ranges.push_back(0.0);
     }
+
+    // Fake lidar simulation parameters
+    lidar_params.num_beams = fake_lidar_msg.ranges.size();
+
+    // Record the scans with their ground truth
+    if (not scan_record_file.empty()) {
+      scan_record.open(scan_record_file, std::ios::binary);
+      if (not scan_record) {
+        RCLCPP_ERROR_STREAM(get_logger(), "Cannot open " << scan_record_file);
+        throw std::runtime_error("Cannot open " + scan_record_file);
+      }
+      turtlelib::write_scan_log_header(scan_record, obstacles_r);
+      recorded_scan.angle_min = fake_lidar_msg.angle_min;
+      recorded_scan.angle_increment = fake_lidar_msg.angle_increment;
+    }
+    lidar_params.angle_increment = turtlelib::deg2rad(LIDAR_INCREMENT);
+    lidar_params.min_range = LIDAR_MIN_RANGE;
+    lidar_params.max_range = LIDAR_MAX_RANGE;
+    lidar_params.noise_stddev = LIDAR_VARIANCE;
   }
 
 private:
   // Obstacles location and geometry
   std::vector<double> obstacles_x;
   std::vector<double> obstacles_y;
+  std::vector<turtlelib::Vector2D> obstacles;
   double obstacles_r = 0.0;
 
+  // Moving obstacles. Their positions are kept at the tail of obstacles, after the
+  // static ones, so the lidar and the collision checker see both
+  turtlelib::MovingObstacles moving_obstacles;
+  size_t n_static_obstacles = 0;
+  double MOVING_SPEED = 0.2;            // m/s
+  double MOVING_TURN_STDDEV = 1.0;      // rad/sqrt(s)
+
   // When true, just draws obstacles and doesn't simulate anything
   bool DRAW_ONLY = false;
 
+  // Seed of the random number generator, negative for a random seed
+  int SEED = -1;
+
   // Initial position of the simulated robot
   double X0 = 0.0;
   double Y0 = 0.0;
@@ -260,6 +401,30 @@ private:
   double LIDAR_MIN_RANGE = 0.160;       // meters
   double LIDAR_MAX_RANGE = 8.0;         // meters
   double LIDAR_VARIANCE = 0.0;
+  turtlelib::LidarParams lidar_params;
+
+  // Simulated yaw gyro
+  double GYRO_NOISE = 0.0;              // rad/s
+  double GYRO_BIAS = 0.0;               // rad/s
+  std::vector<float> scan_ranges;
+
+  // CPU time, memory, and message rates of the node
+  double RESOURCE_PERIOD = 5.0;         // seconds
+  turtlelib::ResourceMonitor resources;
+  size_t wheel_cmd_count = 0;
+  size_t timestep_count = 0;
+  size_t tf_count = 0;
+  size_t sensor_data_count = 0;
+  size_t imu_count = 0;
+  size_t path_count = 0;
+  size_t marker_arr_count = 0;
+  size_t moving_marker_arr_count = 0;
+  size_t fake_sensor_count = 0;
+  size_t fake_lidar_count = 0;
+
+  // Recording of the fake lidar scans
+  std::ofstream scan_record;
+  turtlelib::RecordedScan recorded_scan;
 
   // Noise variables and params
   double left_noise = 0.0;
@@ -288,10 +453,13 @@ private:
   // Publishers
   rclcpp::Publisher<std_msgs::msg::UInt64>::SharedPtr timestep_pub;
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr marker_arr_pub;
+  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr moving_marker_arr_pub;
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr fake_sensor_marker_arr_pub;
   rclcpp::Publisher<nuturtlebot_msgs::msg::SensorData>::SharedPtr sensor_data_pub;
   rclcpp::Publisher<nav_msgs::msg::Path>::SharedPtr path_pub;
   rclcpp::Publisher<sensor_msgs::msg::LaserScan>::SharedPtr fake_lidar_pub;
+  rclcpp::Publisher<sensor_msgs::msg::Imu>::SharedPtr imu_pub;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub;
 
   // Subscribers
   rclcpp::Subscription<nuturtlebot_msgs::msg::WheelCommands>::SharedPtr wheel_cmd_sub;
@@ -299,6 +467,7 @@ private:
   // Timers
   rclcpp::TimerBase::SharedPtr _timer;
   rclcpp::TimerBase::SharedPtr _fake_sensor_timer;
+  rclcpp::TimerBase::SharedPtr resource_timer;
 
   // Services
   rclcpp::Service<std_srvs::srv::Empty>::SharedPtr _reset_service;
@@ -311,103 +480,90 @@ private:
   geometry_msgs::msg::TransformStamped world_red_tf;
   nuturtlebot_msgs::msg::SensorData sensor_data;
   visualization_msgs::msg::MarkerArray marker_arr;
+  visualization_msgs::msg::MarkerArray moving_marker_arr;
   nav_msgs::msg::Path path_msg;
   sensor_msgs::msg::LaserScan fake_lidar_msg;
+  sensor_msgs::msg::Imu imu_msg;
 
-  /// @brief Checks if there is a collision between the robot and an obstacle assuming there
-  /// will only ever be a collision with one obstacle at a time and updates the robot pose
-  ///
-  /// Credit to https://flatredball.com/documentation/tutorials/math/circle-collision/ which
-  /// which provides a description of similar motion, "Circle Move Collision"
-  void detect_collision()
+  /// @brief reads the moving obstacle parameters and appends the starting locations of
+  /// the moving obstacles to the static ones
+  void init_moving_obstacles()
   {
-    if (obstacles_x.size() > 0) {
-      for (size_t i = 0; i < obstacles_x.size(); i++) {
-        turtlelib::Vector2D p1{obstacles_x.at(i), obstacles_y.at(i)};
-        turtlelib::Vector2D p2{true_pose.x, true_pose.y};
-        auto d = turtlelib::distance(p1, p2);
-        auto dc = d - (obstacles_r + COLLISION_RADIUS);
-        if (dc <= 0.0) {
-          auto collision_angle =
-            std::atan2((true_pose.y - obstacles_y.at(i)), (true_pose.x - obstacles_x.at(i)));
-          const auto distance_to_move = obstacles_r + COLLISION_RADIUS;
-
-          // This makes the robot bump into the obstacle and move along the tangent
-          // line between the two collision circles
-          true_pose.x = obstacles_x.at(i) + std::cos(collision_angle) * distance_to_move;
-          true_pose.y = obstacles_y.at(i) + std::sin(collision_angle) * distance_to_move;
-        }
+    const auto start_x = get_parameter("moving_obstacles/x").get_value<std::vector<double>>();
+    const auto start_y = get_parameter("moving_obstacles/y").get_value<std::vector<double>>();
+    const auto goal_x = get_parameter("moving_obstacles/goal_x").get_value<std::vector<double>>();
+    const auto goal_y = get_parameter("moving_obstacles/goal_y").get_value<std::vector<double>>();
+    if (start_x.size() != start_y.size()) {
+      RCLCPP_ERROR_STREAM(
+        get_logger(), "moving_obstacles/x and moving_obstacles/y differ in size");
+      throw std::runtime_error("moving_obstacles/x and moving_obstacles/y differ in size");
+    }
+    const bool patrol = not goal_x.empty() or not goal_y.empty();
+    if (patrol and (goal_x.size() != start_x.size() or goal_y.size() != start_x.size())) {
+      RCLCPP_ERROR_STREAM(
+        get_logger(), "moving_obstacles/goal_x and moving_obstacles/goal_y must have one goal "
+          "for each moving obstacle");
+      throw std::runtime_error("moving_obstacles goals do not match the moving obstacles");
+    }
+
+    turtlelib::MovingObstacleParams params;
+    params.speed = MOVING_SPEED;
+    params.turn_stddev = MOVING_TURN_STDDEV;
+    params.x_length = X_LENGTH;
+    params.y_length = Y_LENGTH;
+    params.margin = obstacles_r;
+    try {
+      moving_obstacles = turtlelib::MovingObstacles(params);
+    } catch (const std::invalid_argument & e) {
+      RCLCPP_ERROR_STREAM(get_logger(), e.what());
+      throw std::runtime_error(e.what());
+    }
+
+    std::uniform_real_distribution<> heading_d(-turtlelib::PI, turtlelib::PI);
+    for (size_t i = 0; i < start_x.size(); i++) {
+      const turtlelib::Vector2D start{start_x.at(i), start_y.at(i)};
+      if (patrol) {
+        moving_obstacles.add_patrol(start, turtlelib::Vector2D{goal_x.at(i), goal_y.at(i)});
+      } else {
+        moving_obstacles.add_random_walk(start, heading_d(get_random()));
       }
     }
+
+    n_static_obstacles = obstacles.size();
+    obstacles.insert(
+      obstacles.end(), moving_obstacles.positions().begin(), moving_obstacles.positions().end());
   }
 
-  /// @brief Fake lidar scanner. Scans once in 360 degrees with 1 deg resolution
-  void fake_scan()
+  /// @brief moves the moving obstacles by one time step, overwriting their positions
+  /// in obstacles and in their markers
+  void step_moving_obstacles()
   {
-
-    std::vector<double> ranges_out(360, 0.0);
-    std::vector<std::tuple<double, double>> hits;
-
-    // Create Gaussian noise on the range values
-    double noise_r = 0.0;
-    std::normal_distribution<> d(0.0, LIDAR_VARIANCE);
-
-    for (size_t ang = 0; ang < 360; ang++) {
-      // Slope of the current lidar ray
-      const auto m = std::tan(turtlelib::deg2rad(ang));
-      for (size_t i = 0; i < obstacles_x.size(); i++) {
-
-        // Get the obstacle in the body frame of the robot
-        const turtlelib::Vector2D wb_vec{true_pose.x, true_pose.y};
-        const turtlelib::Transform2D Twb(wb_vec, true_pose.theta);
-        const turtlelib::Vector2D wo_vec{obstacles_x.at(i), obstacles_y.at(i)};
-        const turtlelib::Transform2D Two(wo_vec);
-        const turtlelib::Transform2D Tbo = Twb.inv() * Two;
-
-        // Obstacle center in the body frame
-        const double h = Tbo.translation().x;
-        const double k = Tbo.translation().y;
-
-        // if the current angle is not in the same quadrant as the obstacle,
-        // there must not be an intersection
-        if (not turtlelib::check_quadrant(h, k, turtlelib::deg2rad(ang))) {
-          continue;
-        }
-
-        // Quadratic formula terms
-        const double a = 1 + std::pow(m, 2.0);
-        const double b = -(2 * h + 2 * m * k);
-        const double c = std::pow(h, 2.0) + std::pow(k, 2.0) - std::pow(obstacles_r, 2.0);
-        const double descrim = std::pow(b, 2.0) - (4 * a * c);
-
-        // If real (descriminant is non-negative), there is an intesection
-        if (descrim >= 0) {
-          // (x1,y1) and (x2,y2) are the two points of intersection
-          const double x1 = (-b + std::sqrt(descrim)) / (2 * a);
-          const double x2 = (-b - std::sqrt(descrim)) / (2 * a);
-          const double y1 = m * x1;
-          const double y2 = m * x2;
-
-          const double d1 = std::sqrt(std::pow(x1, 2.0) + std::pow(y1, 2.0));
-          const double d2 = std::sqrt(std::pow(x2, 2.0) + std::pow(y2, 2.0));
-          const double dmin = std::min(d1, d2);
-          if (dmin >= LIDAR_MIN_RANGE && dmin <= LIDAR_MAX_RANGE) {
-            // if valid intersection, store the distance and the angle
-            hits.push_back(std::tuple<double, double>(dmin, ang));
-          }
-        }
-      }
+    if (moving_obstacles.size() == 0) {
+      return;
     }
-    for (size_t i = 0; i < hits.size(); i++) {
-      const double dist = std::get<0>(hits.at(i));
-      const double ang = std::get<1>(hits.at(i));
-      if (LIDAR_VARIANCE > 0.0) {
-        noise_r = d(get_random());
-      }
-      ranges_out.at(ang) = dist + noise_r;
+    moving_obstacles.step(1.0 / RATE, get_random());
+    const auto & positions = moving_obstacles.positions();
+    std::copy(positions.begin(), positions.end(), obstacles.begin() + n_static_obstacles);
+    for (size_t i = 0; i < positions.size(); i++) {
+      moving_marker_arr.markers.at(i).pose.position.x = positions.at(i).x;
+      moving_marker_arr.markers.at(i).pose.position.y = positions.at(i).y;
     }
-    for (size_t i = 0; i < ranges_out.size(); i++) {
-      fake_lidar_msg.ranges.at(i) = ranges_out.at(i);
+  }
+
+  /// @brief Fake lidar scanner. Scans once in 360 degrees, the nearest obstacle
+  /// along each beam occluding the ones behind it
+  void fake_scan()
+  {
+    turtlelib::simulate_lidar(
+      true_pose, obstacles, obstacles_r, lidar_params, get_random(), scan_ranges);
+    std::copy(scan_ranges.begin(), scan_ranges.end(), fake_lidar_msg.ranges.begin());
+
+    if (scan_record.is_open()) {
+      recorded_scan.stamp = get_clock()->now().seconds();
+      recorded_scan.pose = true_pose;
+      recorded_scan.ranges = scan_ranges;
+      recorded_scan.obstacles = obstacles;
+      turtlelib::write_recorded_scan(scan_record, recorded_scan);
     }
   }
 
@@ -415,6 +571,8 @@ private:
   /// WheelCommands, converts them to speeds in rad/s, with and without noise + slipping
   void wheel_cmd_callback(const nuturtlebot_msgs::msg::WheelCommands & wheel_cmd)
   {
+    resources.count(wheel_cmd_count);
+
     // Define normal noise distribution with zero mean and input_noise variance
     std::normal_distribution<> left_noise_d(0.0, INPUT_NOISE);
     std::normal_distribution<> right_noise_d(0.0, INPUT_NOISE);
@@ -444,6 +602,21 @@ private:
     }
   }
 
+  /// @brief publishes a reading of the simulated yaw gyro
+  /// @param yaw_rate the true yaw rate of the robot in rad/s
+  void publish_gyro(double yaw_rate)
+  {
+    double noise = 0.0;
+    if (GYRO_NOISE > 0.0) {
+      std::normal_distribution<> gyro_noise_d(0.0, GYRO_NOISE);
+      noise = gyro_noise_d(get_random());
+    }
+    imu_msg.header.stamp = get_clock()->now();
+    imu_msg.angular_velocity.z = yaw_rate + GYRO_BIAS + noise;
+    imu_pub->publish(imu_msg);
+    resources.count(imu_count);
+  }
+
   /// @brief ~/reset service callback function:
   /// resets the timestep variable to 0 and resets the
   /// turtlebot pose to its initial location
@@ -492,15 +665,20 @@ private:
       sensor_data.right_encoder = (int)(slippy_wheel_angles.right * ENCODER_TICKS_PER_RAD);
 
       // Use new wheel angles with forward kinematics to obtain new pose of red robot
+      const double theta_before = true_pose.theta;
       true_pose = ddrive.forward_kinematics(true_pose, true_wheel_angles);
 
+      // Move the moving obstacles along their trajectories
+      step_moving_obstacles();
+
       // Check if there is a collision and update pose accordingly
-      detect_collision();
+      detect_collision(true_pose, obstacles, obstacles_r, COLLISION_RADIUS);
 
       // Publish timestep
       auto timestep_message = std_msgs::msg::UInt64();
       timestep_message.data = step++;
       timestep_pub->publish(timestep_message);
+      resources.count(timestep_count);
 
       // Set the translation of the red robot
       world_red_tf.transform.translation.x = true_pose.x;
@@ -517,9 +695,14 @@ private:
       // Stamp and broadcast the transform
       world_red_tf.header.stamp = get_clock()->now();
       tf_broadcaster->sendTransform(world_red_tf);
+      resources.count(tf_count);
 
       // Publish sensor data
       sensor_data_pub->publish(sensor_data);
+      resources.count(sensor_data_count);
+
+      // The gyro measures the true rotation, which the slipping wheels do not
+      publish_gyro(turtlelib::normalize_angle(true_pose.theta - theta_before) * RATE);
 
       // Publish path at a slower rate than the loop
       constexpr int PATH_PUB_RATE = 100;
@@ -538,6 +721,7 @@ private:
         path_msg.header.stamp = get_clock()->now();
         path_msg.poses.push_back(temp_pose);
         path_pub->publish(path_msg);
+        resources.count(path_count);
       } else {
         count++;
       }
@@ -545,6 +729,11 @@ private:
 
     // Publish MarkerArray of obstacles
     marker_arr_pub->publish(marker_arr);
+    resources.count(marker_arr_count);
+    if (not moving_marker_arr.markers.empty()) {
+      moving_marker_arr_pub->publish(moving_marker_arr);
+      resources.count(moving_marker_arr_count);
+    }
   }
 
   /// @brief timer callback for fake sensor:
@@ -558,10 +747,12 @@ private:
       obstacles_r, true_pose, BASIC_MAX_RANGE, BASIC_SENSOR_VARIANCE);
 
     fake_sensor_marker_arr_pub->publish(fake_sensor_marker_arr);
+    resources.count(fake_sensor_count);
 
     fake_scan();
     fake_lidar_msg.header.stamp = get_clock()->now();
     fake_lidar_pub->publish(fake_lidar_msg);
+    resources.count(fake_lidar_count);
 
     if (SAVE_TO_CSV) {
       auto t1 = std::chrono::system_clock::now();
@@ -573,6 +764,16 @@ private:
       nusim_log_file << true_pose.y << "\n";
     }
   }
+
+  /// @brief publishes the CPU time, memory, and message rates of the node since the
+  /// last call as diagnostics
+  void resource_timer_callback()
+  {
+    diagnostic_msgs::msg::DiagnosticArray diagnostics;
+    diagnostics.header.stamp = get_clock()->now();
+    diagnostics.status.push_back(turtlelib::resource_status(resources.report(), get_name()));
+    diagnostics_pub->publish(diagnostics);
+  }
 };
 
 /// @brief the main function to run the nusim node
@@ -1,4 +1,5 @@
 #include "nusim/utils.hpp"
+#include <cmath>
 
 void fill_obstacles(
   visualization_msgs::msg::MarkerArray & marker_arr,
@@ -96,6 +97,33 @@ void fill_walls(visualization_msgs::msg::MarkerArray & marker_arr, double X_LENG
   }
 }
 
+bool detect_collision(
+  turtlelib::Pose2D & pose, const std::vector<turtlelib::Vector2D> & obstacles,
+  double obstacles_r, double collision_radius)
+{
+  const double distance_to_move = obstacles_r + collision_radius;
+  bool collided = false;
+  for (const auto & obstacle : obstacles) {
+    // cheap bounding box rejection before computing the distance
+    if (std::abs(pose.x - obstacle.x) > distance_to_move or
+      std::abs(pose.y - obstacle.y) > distance_to_move)
+    {
+      continue;
+    }
+    const auto d = turtlelib::distance(obstacle, turtlelib::Vector2D{pose.x, pose.y});
+    if (d - distance_to_move <= 0.0) {
+      const auto collision_angle = std::atan2((pose.y - obstacle.y), (pose.x - obstacle.x));
+
+      // This makes the robot bump into the obstacle and move along the tangent
+      // line between the two collision circles
+      pose.x = obstacle.x + std::cos(collision_angle) * distance_to_move;
+      pose.y = obstacle.y + std::sin(collision_angle) * distance_to_move;
+      collided = true;
+    }
+  }
+  return collided;
+}
+
 std::mt19937 & get_random()
 {
   // Credit Matt Elwin: https://nu-msr.github.io/navigation_site/lectures/gaussian.html
@@ -108,6 +136,11 @@ std::mt19937 & get_random()
   return mt;
 }
 
+void seed_random(unsigned int seed)
+{
+  get_random().seed(seed);
+}
+
 void fill_basic_sensor_obstacles(
   visualization_msgs::msg::MarkerArray & marker_arr,
   const std::vector<double> & obstacles_x, const std::vector<double> & obstacles_y,
@@ -129,21 +162,26 @@ void fill_basic_sensor_obstacles(
   // Create normal distribution for random numbers
   std::normal_distribution<> d(0.0, basic_sensor_variance);
 
+  // All markers of one reading share the same stamp
+  const auto stamp = rclcpp::Clock{}.now();
+
+  // Transform from the world to the body frame, the same for every obstacle
+  const turtlelib::Transform2D T_BW =
+    turtlelib::Transform2D(turtlelib::Vector2D{true_pose.x, true_pose.y}, true_pose.theta).inv();
+
   // Creates a marker obstacle at each specified location
   size_t i = 0;
   for (i = 0; i < obstacles_x.size(); i++) {
     // Create a Vector2D for the current obstacle (x,y)
     turtlelib::Vector2D _v{obstacles_x.at(i), obstacles_y.at(i)};
 
-    // Get the transforms so we can publish the obstacles in the body frame
-    turtlelib::Transform2D T_WO(_v);
-    turtlelib::Transform2D T_WB(turtlelib::Vector2D{true_pose.x, true_pose.y}, true_pose.theta);
-    auto T_BO = T_WB.inv() * T_WO;
-    double ob_x_in_body = T_BO.translation().x;
-    double ob_y_in_body = T_BO.translation().y;
+    // Get the obstacle in the body frame
+    const turtlelib::Vector2D ob_in_body = T_BW(_v);
+    double ob_x_in_body = ob_in_body.x;
+    double ob_y_in_body = ob_in_body.y;
 
     marker_msg.header.frame_id = "red/base_footprint";
-    marker_msg.header.stamp = rclcpp::Clock{}.now();
+    marker_msg.header.stamp = stamp;
     marker_msg.id = last_id + (i + 1);
     marker_msg.type = visualization_msgs::msg::Marker::CYLINDER;
 
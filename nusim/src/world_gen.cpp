@@ -0,0 +1,99 @@
+/// \file
+/// \brief world_gen: generates reproducible worlds for nusim, benchmarks, and Monte Carlo runs
+///
+/// Writes the generated obstacles and walls as a nusim parameter file, which can be passed
+/// to the nusim node in place of config/basic_world.yaml, and/or as a compact binary file.
+///
+/// USAGE:
+///   world_gen [--x-length M] [--y-length M] [--density D] [--radius M]
+///             [--clustering F] [--clusters N] [--cluster-radius M] [--spacing M]
+///             [--corridors N] [--corridor-width M] [--corridor-length M]
+///             [--start-clearance M] [--seed S] [--yaml FILE] [--bin FILE]
+///     --x-length, --y-length: size of the arena inside the walls (default 5 x 5)
+///     --density: random obstacles per square meter (default 0.5)
+///     --radius: obstacle radius (default 0.038)
+///     --clustering: fraction of random obstacles placed in clusters (default 0)
+///     --clusters: number of clusters, 0 for one per 10 obstacles (default 0)
+///     --cluster-radius: radius of a cluster (default 0.5)
+///     --spacing: minimum distance between obstacles (default 0.3)
+///     --corridors: number of corridors built from rows of obstacles (default 0)
+///     --corridor-width: distance between the walls of a corridor (default 1)
+///     --corridor-length: length of a corridor, 0 for half the arena (default 0)
+///     --start-clearance: obstacle free radius around the origin (default 0.5)
+///     --seed: seed of the random number generator (default 0)
+///     --yaml: nusim parameter file to write
+///     --bin: binary world file to write
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "turtlelib/world.hpp"
+
+/// @brief generates a world and writes it to the requested files
+int main(int argc, char * argv[])
+{
+  turtlelib::WorldParams params;
+  std::string yaml_path;
+  std::string bin_path;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "missing value for " << arg << std::endl;
+      return 1;
+    }
+    const std::string val = argv[++i];
+    if (arg == "--x-length") {
+      params.x_length = std::stod(val);
+    } else if (arg == "--y-length") {
+      params.y_length = std::stod(val);
+    } else if (arg == "--density") {
+      params.density = std::stod(val);
+    } else if (arg == "--radius") {
+      params.obstacle_radius = std::stod(val);
+    } else if (arg == "--clustering") {
+      params.clustering = std::stod(val);
+    } else if (arg == "--clusters") {
+      params.clusters = std::stoul(val);
+    } else if (arg == "--cluster-radius") {
+      params.cluster_radius = std::stod(val);
+    } else if (arg == "--spacing") {
+      params.min_spacing = std::stod(val);
+    } else if (arg == "--corridors") {
+      params.corridors = std::stoul(val);
+    } else if (arg == "--corridor-width") {
+      params.corridor_width = std::stod(val);
+    } else if (arg == "--corridor-length") {
+      params.corridor_length = std::stod(val);
+    } else if (arg == "--start-clearance") {
+      params.start_clearance = std::stod(val);
+    } else if (arg == "--seed") {
+      params.seed = std::stoul(val);
+    } else if (arg == "--yaml") {
+      yaml_path = val;
+    } else if (arg == "--bin") {
+      bin_path = val;
+    } else {
+      std::cerr << "unknown option " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  const turtlelib::World world = turtlelib::generate_world(params);
+
+  if (yaml_path.empty() and bin_path.empty()) {
+    turtlelib::write_world_yaml(world, std::cout);
+  }
+  if (not yaml_path.empty()) {
+    std::ofstream yaml(yaml_path);
+    turtlelib::write_world_yaml(world, yaml);
+    std::cerr << "Wrote " << world.obstacles.size() << " obstacles to " << yaml_path << std::endl;
+  }
+  if (not bin_path.empty()) {
+    std::ofstream bin(bin_path, std::ios::binary);
+    turtlelib::write_world_binary(world, bin);
+    std::cerr << "Wrote " << world.obstacles.size() << " obstacles to " << bin_path << std::endl;
+  }
+  return 0;
+}
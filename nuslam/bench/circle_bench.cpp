@@ -0,0 +1,268 @@
+/// @file
+/// @brief Circle fitting benchmark
+///
+/// Generates a corpus of synthetic LIDAR arcs (varying arc length, point count,
+/// noise, and outlier fraction) plus straight-line distractors, then measures the
+/// time and accuracy of Cluster construction, fit_circle(), and both is_circle()
+/// classifiers on every case. Results are written as JSON.
+///
+/// USAGE:
+///   circle_bench [--trials N] [--seed S] [--out FILE]
+///     --trials: number of random instances per corpus case (default 200)
+///     --seed: seed of the random number generator (default 0)
+///     --out: JSON output file (default circle_bench.json)
+
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "nuslam/circle_fitting.hpp"
+#include "turtlelib/benchmark.hpp"
+#include "turtlelib/rigid2d.hpp"
+
+using turtlelib::Vector2D;
+
+/// @cond
+namespace
+{
+
+// The default thresholds of the landmarks node
+const DetectorParams DETECTOR;
+const double TRUE_RADIUS = std::get<0>(DETECTOR.true_threshold);
+
+/// @brief one case of the synthetic corpus
+struct CorpusCase
+{
+  std::string shape;      // "arc" or "line"
+  double arc_deg = 0.0;   // angular span of the arc, in degrees
+  size_t points = 0;      // number of points in the cluster
+  double noise = 0.0;     // standard deviation of radial noise in meters
+  double outliers = 0.0;  // fraction of points replaced by outliers
+};
+
+/// @brief a generated cluster together with its ground truth
+struct Instance
+{
+  std::vector<Vector2D> points;
+  Vector2D center;
+  double radius = 0.0;
+};
+
+/// @brief generates the points of one corpus case. Points are ordered along the
+/// arc (or line) since is_circle() assumes the endpoints are first and last.
+Instance generate(const CorpusCase & c, std::mt19937 & rng)
+{
+  std::uniform_real_distribution<> range_d(0.3, 2.0);
+  std::uniform_real_distribution<> angle_d(-turtlelib::PI, turtlelib::PI);
+  std::uniform_real_distribution<> unit_d(0.0, 1.0);
+  std::normal_distribution<> noise_d(0.0, c.noise > 0.0 ? c.noise : 1.0);
+
+  Instance inst;
+  inst.radius = TRUE_RADIUS;
+  inst.center = Vector2D::from_polar(range_d(rng), angle_d(rng));
+
+  // the visible side of the landmark faces the sensor at the origin
+  const double facing = std::atan2(-inst.center.y, -inst.center.x);
+  const double span = turtlelib::deg2rad(c.arc_deg);
+
+  for (size_t i = 0; i < c.points; i++) {
+    const double s = (c.points > 1) ? static_cast<double>(i) / (c.points - 1) : 0.5;
+    Vector2D p;
+    if (c.shape == "line") {
+      // a wall segment of the same chord length as a half circle
+      const double t = (s - 0.5) * 2.0 * inst.radius;
+      p = Vector2D{inst.center.x - t * std::sin(facing), inst.center.y + t * std::cos(facing)};
+    } else {
+      const double ang = facing - span / 2.0 + s * span;
+      const double r = inst.radius + (c.noise > 0.0 ? noise_d(rng) : 0.0);
+      p = inst.center + Vector2D::from_polar(r, ang);
+    }
+
+    // outliers are displaced radially by up to two radii
+    if (unit_d(rng) < c.outliers) {
+      const double ang = std::atan2(p.y - inst.center.y, p.x - inst.center.x);
+      p += Vector2D::from_polar((unit_d(rng) - 0.5) * 4.0 * inst.radius, ang);
+    }
+    inst.points.push_back(p);
+  }
+  return inst;
+}
+
+/// @brief builds the full corpus of cases
+std::vector<CorpusCase> build_corpus()
+{
+  std::vector<CorpusCase> corpus;
+  for (const double arc : {60.0, 120.0, 180.0, 270.0}) {
+    for (const size_t n : {5ul, 10ul, 20ul, 50ul}) {
+      for (const double noise : {0.0, 0.001, 0.005}) {
+        for (const double outliers : {0.0, 0.1, 0.25}) {
+          corpus.push_back(CorpusCase{"arc", arc, n, noise, outliers});
+        }
+      }
+    }
+  }
+  for (const size_t n : {5ul, 10ul, 20ul, 50ul}) {
+    corpus.push_back(CorpusCase{"line", 0.0, n, 0.0, 0.0});
+  }
+  return corpus;
+}
+
+/// @brief timing and accuracy results of one method on one corpus case
+struct MethodResult
+{
+  bool classifier = false;
+  turtlelib::SampleStats time_us;
+  turtlelib::SampleStats center_error;
+  turtlelib::SampleStats radius_error;
+  size_t accepted = 0;
+  size_t failures = 0;
+};
+
+void write_method(
+  turtlelib::JsonWriter & json, const std::string & name,
+  const MethodResult & result)
+{
+  json.key(name);
+  json.begin_object();
+  json.key("time_us");
+  json.value(result.time_us);
+  if (result.center_error.count() > 0) {
+    json.key("center_error_m");
+    json.value(result.center_error);
+    json.key("radius_error_m");
+    json.value(result.radius_error);
+  }
+  if (result.classifier) {
+    json.key("accept_rate");
+    json.value(
+      result.time_us.count() > 0 ?
+      static_cast<double>(result.accepted) / result.time_us.count() : 0.0);
+  }
+  json.key("failures");
+  json.value(result.failures);
+  json.end_object();
+}
+
+}
+/// @endcond
+
+/// @brief runs the circle fitting benchmark
+int main(int argc, char * argv[])
+{
+  size_t trials = 200;
+  unsigned int seed = 0;
+  std::string out_path = "circle_bench.json";
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--trials" and i + 1 < argc) {
+      trials = std::stoul(argv[++i]);
+    } else if (arg == "--seed" and i + 1 < argc) {
+      seed = std::stoul(argv[++i]);
+    } else if (arg == "--out" and i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      std::cerr << "usage: circle_bench [--trials N] [--seed S] [--out FILE]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::mt19937 rng{seed};
+  std::ofstream out(out_path);
+  turtlelib::JsonWriter json(out);
+
+  json.begin_object();
+  json.key("benchmark");
+  json.value("circle_fitting");
+  json.key("trials");
+  json.value(trials);
+  json.key("seed");
+  json.value(static_cast<size_t>(seed));
+  json.key("cases");
+  json.begin_array();
+
+  for (const auto & c : build_corpus()) {
+    MethodResult cluster_res;
+    MethodResult fit_res;
+    MethodResult classify_res;
+    MethodResult classify_radius_res;
+    classify_res.classifier = true;
+    classify_radius_res.classifier = true;
+
+    for (size_t t = 0; t < trials; t++) {
+      const Instance inst = generate(c, rng);
+
+      // Cluster construction the way the landmarks node does it, point by point
+      turtlelib::Stopwatch sw;
+      Cluster cluster(inst.points.front(), DETECTOR.cluster_threshold);
+      for (size_t i = 1; i < inst.points.size(); i++) {
+        if (not cluster.belongs(inst.points.at(i))) {
+          cluster.blind_add(inst.points.at(i));
+        }
+      }
+      cluster_res.time_us.add(sw.elapsed_us());
+
+      try {
+        sw.reset();
+        const auto hkr = fit_circle(cluster);
+        fit_res.time_us.add(sw.elapsed_us());
+        fit_res.center_error.add(turtlelib::distance(std::get<0>(hkr), inst.center));
+        fit_res.radius_error.add(std::abs(std::get<1>(hkr) - inst.radius));
+      } catch (const std::exception &) {
+        fit_res.failures++;
+      }
+
+      try {
+        sw.reset();
+        const bool accept = is_circle(cluster, DETECTOR.mean_threshold, DETECTOR.std_threshold);
+        classify_res.time_us.add(sw.elapsed_us());
+        classify_res.accepted += accept;
+      } catch (const std::exception &) {
+        classify_res.failures++;
+      }
+
+      try {
+        sw.reset();
+        const bool accept = is_circle(
+          cluster, DETECTOR.mean_threshold, DETECTOR.std_threshold, DETECTOR.true_threshold);
+        classify_radius_res.time_us.add(sw.elapsed_us());
+        classify_radius_res.accepted += accept;
+      } catch (const std::exception &) {
+        classify_radius_res.failures++;
+      }
+    }
+
+    json.begin_object();
+    json.key("shape");
+    json.value(c.shape);
+    json.key("arc_deg");
+    json.value(c.arc_deg);
+    json.key("points");
+    json.value(c.points);
+    json.key("noise_m");
+    json.value(c.noise);
+    json.key("outlier_fraction");
+    json.value(c.outliers);
+    json.key("methods");
+    json.begin_object();
+    write_method(json, "cluster_build", cluster_res);
+    write_method(json, "fit_circle", fit_res);
+    write_method(json, "is_circle", classify_res);
+    write_method(json, "is_circle_radius", classify_radius_res);
+    json.end_object();
+    json.end_object();
+  }
+
+  json.end_array();
+  json.end_object();
+  out << std::endl;
+
+  std::cout << "Wrote circle fitting benchmark results to " << out_path << std::endl;
+  return 0;
+}
@@ -0,0 +1,388 @@
+/// @file
+/// @brief Offline tuning sweep of the landmark detector thresholds
+///
+/// Replays LIDAR scans with ground truth, either recorded by nusim (scan_record_file)
+/// or simulated here, through the same detector as the landmarks node for every
+/// combination of the given thresholds. Each detection is matched to the obstacles
+/// the scan actually hit, giving the precision and recall of each combination along
+/// with the detector time per scan, as JSON. Combinations are spread over worker
+/// threads; use --threads 1 for timings free of contention between the workers.
+///
+/// USAGE:
+///   detector_sweep [--log FILE | --generate N] [--seed S] [--noise STDDEV]
+///                  [--save-log FILE] [--min-cluster-size N1,N2,...]
+///                  [--cluster-threshold T1,T2,...] [--mean-min A1,A2,...]
+///                  [--mean-max A1,A2,...] [--std-threshold S1,S2,...]
+///                  [--radius-tolerance F1,F2,...] [--true-radius R]
+///                  [--match-distance D] [--threads N] [--out FILE]
+///     --log: scan log recorded by nusim to replay
+///     --generate: number of scans to simulate when no log is given (default 300)
+///     --seed: seed of the simulated world and noise (default 0)
+///     --noise: standard deviation of the simulated range noise in meters (default 0.01)
+///     --save-log: also write the simulated scans as a scan log
+///     --min-cluster-size: Clusters with fewer points are discarded (default 3,4,5)
+///     --cluster-threshold: distance for a point to join a Cluster (default 0.05,0.1,0.15)
+///     --mean-min: lower bounds of the mean inscribed angle in degrees (default 0)
+///     --mean-max: upper bounds of the mean inscribed angle in degrees (default 110,130,150)
+///     --std-threshold: largest standard deviation of the inscribed angles
+///                      (default 0.1,0.15,0.2)
+///     --radius-tolerance: fraction the fitted radius may differ from the true radius
+///                         (default 0.1,0.2,0.4)
+///     --true-radius: true radius of the landmarks (default: the radius in the log)
+///     --match-distance: farthest a detection may be from its obstacle (default 0.05)
+///     --threads: number of worker threads (default: one per core)
+///     --out: JSON output file (default detector_sweep.json)
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "nuslam/circle_fitting.hpp"
+#include "turtlelib/benchmark.hpp"
+#include "turtlelib/diff_drive.hpp"
+#include "turtlelib/lidar.hpp"
+#include "turtlelib/rigid2d.hpp"
+#include "turtlelib/scan_log.hpp"
+#include "turtlelib/world.hpp"
+
+using turtlelib::Vector2D;
+
+/// @cond
+namespace
+{
+
+// Scan period of nusim's fake lidar
+constexpr double SCAN_PERIOD = 0.2;
+
+// The robot drives a circle of radius V / W starting at the origin facing +x
+constexpr double V = 0.15;
+constexpr double W = 0.1;
+
+// An obstacle is visible when this many returns lie within the tolerance of its surface,
+// the fewest points a circle can be fit to
+constexpr double VISIBLE_TOLERANCE = 0.01;
+constexpr size_t VISIBLE_RETURNS = 3;
+
+/// @brief the outcome of one combination of thresholds
+struct SweepResult
+{
+  DetectorParams params;
+  turtlelib::DetectionScore score;
+  turtlelib::SampleStats detect_us;
+};
+
+/// @brief simulates a robot driving a circle through a generated world
+turtlelib::ScanLog generate_log(size_t n_scans, unsigned int seed, double noise)
+{
+  turtlelib::WorldParams world_params;
+  world_params.seed = seed;
+  const turtlelib::World world = turtlelib::generate_world(world_params);
+
+  turtlelib::LidarParams lidar;
+  lidar.max_range = 3.5;
+  lidar.noise_stddev = noise;
+
+  turtlelib::ScanLog log;
+  log.obstacle_radius = world.obstacle_radius;
+
+  std::mt19937 rng{seed};
+  turtlelib::Pose2D pose{0.0, 0.0, 0.0};
+  const turtlelib::Twist2D Vb{W * SCAN_PERIOD, V * SCAN_PERIOD, 0.0};
+  for (size_t s = 0; s < n_scans; s++) {
+    const turtlelib::Transform2D T_wb(Vector2D{pose.x, pose.y}, pose.theta);
+    const turtlelib::Transform2D T_wbp = T_wb * T_wb.integrate_twist(Vb);
+    pose = turtlelib::Pose2D{T_wbp.translation().x, T_wbp.translation().y, T_wbp.rotation()};
+
+    turtlelib::RecordedScan scan;
+    scan.stamp = s * SCAN_PERIOD;
+    scan.pose = pose;
+    scan.angle_min = 0.0;
+    scan.angle_increment = lidar.angle_increment;
+    scan.obstacles = world.obstacles;
+    turtlelib::simulate_lidar(
+      pose, world.obstacles, world.obstacle_radius, lidar, rng, scan.ranges);
+    log.scans.push_back(std::move(scan));
+  }
+  return log;
+}
+
+/// @brief every combination of the given thresholds
+std::vector<DetectorParams> make_grid(
+  const std::vector<double> & min_cluster_sizes, const std::vector<double> & cluster_thresholds,
+  const std::vector<double> & mean_mins, const std::vector<double> & mean_maxs,
+  const std::vector<double> & std_thresholds, const std::vector<double> & radius_tolerances,
+  double true_radius)
+{
+  std::vector<DetectorParams> grid;
+  for (const auto n : min_cluster_sizes) {
+    for (const auto c : cluster_thresholds) {
+      for (const auto lo : mean_mins) {
+        for (const auto hi : mean_maxs) {
+          for (const auto s : std_thresholds) {
+            for (const auto t : radius_tolerances) {
+              DetectorParams p;
+              p.min_cluster_size = static_cast<size_t>(n);
+              p.cluster_threshold = c;
+              p.mean_threshold = {lo, hi};
+              p.std_threshold = s;
+              p.true_threshold = {true_radius, t};
+              grid.push_back(p);
+            }
+          }
+        }
+      }
+    }
+  }
+  return grid;
+}
+
+/// @brief runs the detector with one combination of thresholds over every scan
+SweepResult run_config(
+  const DetectorParams & params, const turtlelib::ScanLog & log,
+  const std::vector<std::vector<Vector2D>> & truth, double match_distance)
+{
+  SweepResult res;
+  res.params = params;
+  for (size_t s = 0; s < log.scans.size(); s++) {
+    const auto & scan = log.scans.at(s);
+    const turtlelib::Stopwatch sw;
+    const auto detections = detect_circles(
+      scan.ranges, scan.angle_min, scan.angle_increment, params);
+    res.detect_us.add(sw.elapsed_us());
+    res.score += turtlelib::score_detections(detections, truth.at(s), match_distance);
+  }
+  return res;
+}
+
+double f1(const turtlelib::DetectionScore & score)
+{
+  const double p = score.precision();
+  const double r = score.recall();
+  return p + r > 0.0 ? 2.0 * p * r / (p + r) : 0.0;
+}
+
+/// @brief whether a is a better combination than b: higher F1, then fewer false positives
+bool better(const SweepResult & a, const SweepResult & b)
+{
+  const double fa = f1(a.score);
+  const double fb = f1(b.score);
+  if (fa != fb) {
+    return fa > fb;
+  }
+  return a.score.false_positives < b.score.false_positives;
+}
+
+std::vector<double> parse_list(const std::string & arg)
+{
+  std::vector<double> values;
+  std::stringstream ss(arg);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    values.push_back(std::stod(item));
+  }
+  return values;
+}
+
+void write_result(turtlelib::JsonWriter & json, const SweepResult & res)
+{
+  json.begin_object();
+  json.key("min_cluster_size");
+  json.value(res.params.min_cluster_size);
+  json.key("cluster_threshold");
+  json.value(res.params.cluster_threshold);
+  json.key("mean_min");
+  json.value(std::get<0>(res.params.mean_threshold));
+  json.key("mean_max");
+  json.value(std::get<1>(res.params.mean_threshold));
+  json.key("std_threshold");
+  json.value(res.params.std_threshold);
+  json.key("radius_tolerance");
+  json.value(std::get<1>(res.params.true_threshold));
+  json.key("true_positives");
+  json.value(res.score.true_positives);
+  json.key("false_positives");
+  json.value(res.score.false_positives);
+  json.key("false_negatives");
+  json.value(res.score.false_negatives);
+  json.key("precision");
+  json.value(res.score.precision());
+  json.key("recall");
+  json.value(res.score.recall());
+  json.key("f1");
+  json.value(f1(res.score));
+  json.key("time_per_scan_us");
+  json.value(res.detect_us);
+  json.end_object();
+}
+
+}
+/// @endcond
+
+/// @brief runs the detector threshold sweep
+int main(int argc, char * argv[])
+{
+  std::string log_path;
+  std::string save_path;
+  size_t n_scans = 300;
+  unsigned int seed = 0;
+  double noise = 0.01;
+  std::vector<double> min_cluster_sizes{3, 4, 5};
+  std::vector<double> cluster_thresholds{0.05, 0.1, 0.15};
+  std::vector<double> mean_mins{0.0};
+  std::vector<double> mean_maxs{110.0, 130.0, 150.0};
+  std::vector<double> std_thresholds{0.1, 0.15, 0.2};
+  std::vector<double> radius_tolerances{0.1, 0.2, 0.4};
+  double true_radius = 0.0;
+  double match_distance = 0.05;
+  size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::string out_path = "detector_sweep.json";
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--log" and i + 1 < argc) {
+      log_path = argv[++i];
+    } else if (arg == "--generate" and i + 1 < argc) {
+      n_scans = std::stoul(argv[++i]);
+    } else if (arg == "--seed" and i + 1 < argc) {
+      seed = std::stoul(argv[++i]);
+    } else if (arg == "--noise" and i + 1 < argc) {
+      noise = std::stod(argv[++i]);
+    } else if (arg == "--save-log" and i + 1 < argc) {
+      save_path = argv[++i];
+    } else if (arg == "--min-cluster-size" and i + 1 < argc) {
+      min_cluster_sizes = parse_list(argv[++i]);
+    } else if (arg == "--cluster-threshold" and i + 1 < argc) {
+      cluster_thresholds = parse_list(argv[++i]);
+    } else if (arg == "--mean-min" and i + 1 < argc) {
+      mean_mins = parse_list(argv[++i]);
+    } else if (arg == "--mean-max" and i + 1 < argc) {
+      mean_maxs = parse_list(argv[++i]);
+    } else if (arg == "--std-threshold" and i + 1 < argc) {
+      std_thresholds = parse_list(argv[++i]);
+    } else if (arg == "--radius-tolerance" and i + 1 < argc) {
+      radius_tolerances = parse_list(argv[++i]);
+    } else if (arg == "--true-radius" and i + 1 < argc) {
+      true_radius = std::stod(argv[++i]);
+    } else if (arg == "--match-distance" and i + 1 < argc) {
+      match_distance = std::stod(argv[++i]);
+    } else if (arg == "--threads" and i + 1 < argc) {
+      n_threads = std::max<size_t>(1, std::stoul(argv[++i]));
+    } else if (arg == "--out" and i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      std::cerr << "usage: detector_sweep [--log FILE | --generate N] [--seed S] [--noise STDDEV]"
+                << " [--save-log FILE] [--min-cluster-size N1,...] [--cluster-threshold T1,...]"
+                << " [--mean-min A1,...] [--mean-max A1,...] [--std-threshold S1,...]"
+                << " [--radius-tolerance F1,...] [--true-radius R] [--match-distance D]"
+                << " [--threads N] [--out FILE]" << std::endl;
+      return 1;
+    }
+  }
+
+  turtlelib::ScanLog log;
+  if (not log_path.empty()) {
+    std::ifstream in(log_path, std::ios::binary);
+    if (not in) {
+      std::cerr << "Cannot open " << log_path << std::endl;
+      return 1;
+    }
+    log = turtlelib::read_scan_log(in);
+  } else {
+    log = generate_log(n_scans, seed, noise);
+  }
+  if (not save_path.empty()) {
+    std::ofstream save(save_path, std::ios::binary);
+    turtlelib::write_scan_log_header(save, log.obstacle_radius);
+    for (const auto & scan : log.scans) {
+      turtlelib::write_recorded_scan(save, scan);
+    }
+  }
+  if (true_radius <= 0.0) {
+    true_radius = log.obstacle_radius;
+  }
+
+  // the ground truth does not depend on the thresholds
+  std::vector<std::vector<Vector2D>> truth;
+  truth.reserve(log.scans.size());
+  for (const auto & scan : log.scans) {
+    truth.push_back(
+      turtlelib::visible_obstacles(scan, log.obstacle_radius, VISIBLE_TOLERANCE, VISIBLE_RETURNS));
+  }
+
+  const auto grid = make_grid(
+    min_cluster_sizes, cluster_thresholds, mean_mins, mean_maxs, std_thresholds,
+    radius_tolerances, true_radius);
+  std::cout << "Sweeping " << grid.size() << " combinations over " << log.scans.size()
+            << " scans with " << n_threads << " threads" << std::endl;
+
+  // each worker takes the next combination until none are left
+  std::vector<SweepResult> results(grid.size());
+  std::atomic<size_t> next{0};
+  const turtlelib::Stopwatch wall;
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < n_threads; t++) {
+    workers.emplace_back(
+      [&]()
+      {
+        for (size_t i = next++; i < grid.size(); i = next++) {
+          results.at(i) = run_config(grid.at(i), log, truth, match_distance);
+        }
+      });
+  }
+  for (auto & w : workers) {
+    w.join();
+  }
+  const double wall_s = wall.elapsed_s();
+
+  std::ofstream out(out_path);
+  turtlelib::JsonWriter json(out);
+
+  json.begin_object();
+  json.key("benchmark");
+  json.value("detector_sweep");
+  json.key("log");
+  json.value(log_path.empty() ? std::string{"generated"} : log_path);
+  json.key("scans");
+  json.value(log.scans.size());
+  json.key("true_radius");
+  json.value(true_radius);
+  json.key("match_distance");
+  json.value(match_distance);
+  json.key("threads");
+  json.value(n_threads);
+  json.key("wall_time_s");
+  json.value(wall_s);
+  if (not results.empty()) {
+    const auto best = std::min_element(results.begin(), results.end(), better);
+    json.key("best");
+    write_result(json, *best);
+    std::cout << "Best: min_cluster_size " << best->params.min_cluster_size
+              << ", cluster_threshold " << best->params.cluster_threshold
+              << ", mean_threshold [" << std::get<0>(best->params.mean_threshold) << ", "
+              << std::get<1>(best->params.mean_threshold) << "], std_threshold "
+              << best->params.std_threshold << ", radius_tolerance "
+              << std::get<1>(best->params.true_threshold) << " (precision "
+              << best->score.precision() << ", recall " << best->score.recall() << ")"
+              << std::endl;
+  }
+  json.key("results");
+  json.begin_array();
+  for (const auto & res : results) {
+    write_result(json, res);
+  }
+  json.end_array();
+  json.end_object();
+  out << std::endl;
+
+  std::cout << "Wrote detector sweep results to " << out_path << std::endl;
+  return 0;
+}
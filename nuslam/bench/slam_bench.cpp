@@ -0,0 +1,406 @@
+/// @file
+/// @brief End-to-end SLAM pipeline scalability benchmark
+///
+/// Drives simulated LIDAR scans through the same pipeline as the landmarks and
+/// slam nodes (segmentation, circle fitting/classification, data association and
+/// the extended Kalman filter) without ROS middleware, for worlds of increasing
+/// landmark count. Reports per-stage and total latency percentiles, with the EKF split
+/// into association, prediction, and update, heap allocations per stage, the final map
+/// size, and memory use for each world as JSON. Obstacles which wander through the world
+/// can be added to see how association cost and map size behave under clutter.
+///
+/// USAGE:
+///   slam_bench [--landmarks N1,N2,...] [--scans N] [--budget SECONDS]
+///              [--seed S] [--known] [--movers N] [--consider DIST] [--reorder N]
+///              [--threads N] [--out FILE]
+///     --landmarks: comma separated landmark counts (default 10,50,100,500,1000,5000)
+///     --scans: number of scans to process per world (default 300)
+///     --budget: wall-clock seconds after which a world is cut short (default 120)
+///     --seed: seed of the random number generator (default 0)
+///     --known: use known data association (ids from ground truth)
+///     --movers: number of obstacles following random walks through each world (default 0)
+///     --consider: landmarks further than this from the robot are consider states, which
+///       the EKF update does not change (default 0, update every landmark)
+///     --reorder: sort the EKF landmarks along a Morton curve every N scans (default 0,
+///       never)
+///     --threads: threads to score the detections of a scan across (default 1)
+///     --out: JSON output file (default slam_bench.json)
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "nuslam/circle_fitting.hpp"
+#include "turtlelib/alloc_tracker.hpp"
+#include "turtlelib/benchmark.hpp"
+#include "turtlelib/diff_drive.hpp"
+#include "turtlelib/kalman.hpp"
+#include "turtlelib/lidar.hpp"
+#include "turtlelib/moving_obstacles.hpp"
+#include "turtlelib/rigid2d.hpp"
+
+using turtlelib::Vector2D;
+
+/// @cond
+namespace
+{
+
+// The default thresholds of the landmarks node
+const DetectorParams DETECTOR;
+const double TRUE_RADIUS = std::get<0>(DETECTOR.true_threshold);
+
+// Same gains as config/slam_params.yaml
+constexpr double EKF_Q = 1.0;
+constexpr double EKF_R = 1.0;
+
+// Scan period of nusim's fake lidar
+constexpr double SCAN_PERIOD = 0.2;
+
+// World layout: constant landmark density so the number of landmarks in view
+// stays realistic as the world grows
+constexpr double LANDMARK_DENSITY = 0.5;   // landmarks per square meter
+constexpr double MIN_SPACING = 0.3;        // minimum distance between landmarks
+constexpr double PATH_CLEARANCE = 0.3;     // keep landmarks off the robot's path
+
+// Moving obstacles walk at about the pace of a person
+constexpr double MOVER_SPEED = 0.5;        // m/s
+constexpr double MOVER_TURN_STDDEV = 1.0;  // rad per square root of a second
+
+// The robot drives a circle of radius V / W starting at the origin facing +x
+constexpr double V = 0.15;
+constexpr double W = 0.1;
+
+/// @brief places n landmarks uniformly at random around the robot's circular path
+std::vector<Vector2D> generate_world(size_t n, std::mt19937 & rng)
+{
+  const double side = std::sqrt(n / LANDMARK_DENSITY);
+  const Vector2D path_center{0.0, V / W};
+  std::uniform_real_distribution<> coord_d(-side / 2.0, side / 2.0);
+
+  std::vector<Vector2D> landmarks;
+  size_t attempts = 0;
+  while (landmarks.size() < n and attempts < 100 * n) {
+    attempts++;
+    const Vector2D p = path_center + Vector2D{coord_d(rng), coord_d(rng)};
+    if (std::abs(turtlelib::distance(p, path_center) - V / W) < PATH_CLEARANCE) {
+      continue;
+    }
+    bool too_close = false;
+    for (const auto & q : landmarks) {
+      if (turtlelib::distance(p, q) < MIN_SPACING) {
+        too_close = true;
+        break;
+      }
+    }
+    if (not too_close) {
+      landmarks.push_back(p);
+    }
+  }
+  return landmarks;
+}
+
+/// @brief results for one world
+struct WorldResult
+{
+  size_t landmarks = 0;
+  size_t movers = 0;
+  size_t scans = 0;
+  bool truncated = false;
+  size_t detections = 0;
+  size_t map_size = 0;
+  turtlelib::SampleStats active_landmarks;
+  turtlelib::SampleStats simulate_us;
+  turtlelib::SampleStats segment_us;
+  turtlelib::SampleStats fit_us;
+  turtlelib::SampleStats ekf_us;
+  turtlelib::SampleStats associate_us;
+  turtlelib::SampleStats predict_us;
+  turtlelib::SampleStats update_us;
+  turtlelib::SampleStats total_us;
+  turtlelib::SampleStats segment_allocs;
+  turtlelib::SampleStats fit_allocs;
+  turtlelib::SampleStats ekf_allocs;
+  turtlelib::SampleStats total_allocs;
+  size_t rss_kb = 0;
+  size_t peak_rss_kb = 0;
+};
+
+WorldResult run_world(
+  size_t n_landmarks, size_t n_movers, size_t n_scans, double budget_s, bool known,
+  double consider_distance, size_t reorder_period, size_t threads, std::mt19937 & rng)
+{
+  WorldResult res;
+  std::vector<Vector2D> world = generate_world(n_landmarks, rng);
+  const size_t n_static = world.size();
+  res.landmarks = n_static;
+
+  // Moving obstacles wander through the same square as the landmarks. They are kept
+  // at the tail of the world and overwritten in place after every step
+  const double side = std::max(std::sqrt(n_landmarks / LANDMARK_DENSITY), 1.0);
+  const Vector2D path_center{0.0, V / W};
+  turtlelib::MovingObstacleParams mover_params;
+  mover_params.speed = MOVER_SPEED;
+  mover_params.turn_stddev = MOVER_TURN_STDDEV;
+  mover_params.x_length = side;
+  mover_params.y_length = side;
+  turtlelib::MovingObstacles movers(mover_params);
+  std::uniform_real_distribution<> coord_d(-side / 2.0, side / 2.0);
+  std::uniform_real_distribution<> heading_d(-turtlelib::PI, turtlelib::PI);
+  for (size_t i = 0; i < n_movers; i++) {
+    movers.add_random_walk(Vector2D{coord_d(rng), coord_d(rng)}, heading_d(rng));
+  }
+  world.resize(n_static + movers.size());
+  res.movers = movers.size();
+
+  turtlelib::LidarParams lidar;
+  lidar.max_range = 3.5;
+  lidar.noise_stddev = 0.001;
+
+  turtlelib::KalmanFilter ekf{EKF_Q, EKF_R};
+  ekf.set_consider_distance(consider_distance);
+  ekf.set_reorder_period(reorder_period);
+  ekf.set_association_threads(threads);
+  turtlelib::Pose2D pose{0.0, 0.0, 0.0};
+  const turtlelib::Twist2D Vb{W * SCAN_PERIOD, V * SCAN_PERIOD, 0.0};
+  std::vector<float> ranges;
+
+  const turtlelib::Stopwatch wall;
+  for (size_t s = 0; s < n_scans; s++) {
+    if (wall.elapsed_s() > budget_s) {
+      res.truncated = true;
+      break;
+    }
+
+    // advance the robot by one scan period
+    const turtlelib::Transform2D T_wb(Vector2D{pose.x, pose.y}, pose.theta);
+    const turtlelib::Transform2D T_wbp = T_wb * T_wb.integrate_twist(Vb);
+    pose = turtlelib::Pose2D{T_wbp.translation().x, T_wbp.translation().y, T_wbp.rotation()};
+
+    movers.step(SCAN_PERIOD, rng);
+    for (size_t j = 0; j < movers.size(); j++) {
+      world.at(n_static + j) = path_center + movers.positions().at(j);
+    }
+
+    turtlelib::Stopwatch sw;
+    turtlelib::simulate_lidar(pose, world, TRUE_RADIUS, lidar, rng, ranges);
+    res.simulate_us.add(sw.elapsed_us());
+
+    // Stage 1: segmentation
+    turtlelib::AllocationScope allocs;
+    sw.reset();
+    const auto clusters = cluster_scan(
+      ranges, 0.0, lidar.angle_increment, DETECTOR.min_cluster_size, DETECTOR.cluster_threshold);
+    const double segment_us = sw.elapsed_us();
+    const size_t segment_allocs = allocs.counts().allocations;
+
+    // Stage 2: circle fitting and classification
+    allocs.reset();
+    sw.reset();
+    const std::vector<Vector2D> centers = detect_circles(clusters, DETECTOR);
+    const double fit_us = sw.elapsed_us();
+    const size_t fit_allocs = allocs.counts().allocations;
+
+    std::vector<turtlelib::LandmarkMeasurement> measurements;
+    const turtlelib::Transform2D T_bw = turtlelib::Transform2D(
+      Vector2D{pose.x, pose.y}, pose.theta).inv();
+    for (const auto & c : centers) {
+      if (known) {
+        // id of the closest true landmark, moving obstacles get their own ids
+        size_t id = 0;
+        double best = std::numeric_limits<double>::max();
+        for (size_t j = 0; j < world.size(); j++) {
+          const double d = turtlelib::distance(T_bw(world.at(j)), c);
+          if (d < best) {
+            best = d;
+            id = j;
+          }
+        }
+        measurements.push_back(turtlelib::LandmarkMeasurement::from_cartesian(c.x, c.y, id));
+      } else {
+        measurements.push_back(turtlelib::LandmarkMeasurement::from_cartesian(c.x, c.y));
+      }
+    }
+    res.detections += measurements.size();
+
+    // Stage 3: data association and extended Kalman filter
+    allocs.reset();
+    sw.reset();
+    ekf.run(pose, Vb, measurements);
+    const double ekf_us = sw.elapsed_us();
+    const size_t ekf_allocs = allocs.counts().allocations;
+
+    res.segment_us.add(segment_us);
+    res.fit_us.add(fit_us);
+    res.ekf_us.add(ekf_us);
+    res.associate_us.add(ekf.stats().last_associate_us);
+    res.predict_us.add(ekf.stats().last_predict_us);
+    res.update_us.add(ekf.stats().last_update_us);
+    res.active_landmarks.add(static_cast<double>(ekf.stats().last_active_landmarks));
+    res.total_us.add(segment_us + fit_us + ekf_us);
+    res.segment_allocs.add(static_cast<double>(segment_allocs));
+    res.fit_allocs.add(static_cast<double>(fit_allocs));
+    res.ekf_allocs.add(static_cast<double>(ekf_allocs));
+    res.total_allocs.add(static_cast<double>(segment_allocs + fit_allocs + ekf_allocs));
+    res.scans++;
+  }
+
+  res.map_size = ekf.stats().landmarks;
+  res.rss_kb = turtlelib::resident_memory_kb();
+  res.peak_rss_kb = turtlelib::peak_resident_memory_kb();
+  return res;
+}
+
+std::vector<size_t> parse_counts(const std::string & arg)
+{
+  std::vector<size_t> counts;
+  std::stringstream ss(arg);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    counts.push_back(std::stoul(item));
+  }
+  return counts;
+}
+
+}
+/// @endcond
+
+/// @brief runs the SLAM pipeline benchmark
+int main(int argc, char * argv[])
+{
+  std::vector<size_t> counts{10, 50, 100, 500, 1000, 5000};
+  size_t n_scans = 300;
+  double budget_s = 120.0;
+  unsigned int seed = 0;
+  bool known = false;
+  size_t n_movers = 0;
+  double consider_distance = 0.0;
+  size_t reorder_period = 0;
+  size_t threads = 1;
+  std::string out_path = "slam_bench.json";
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--landmarks" and i + 1 < argc) {
+      counts = parse_counts(argv[++i]);
+    } else if (arg == "--scans" and i + 1 < argc) {
+      n_scans = std::stoul(argv[++i]);
+    } else if (arg == "--budget" and i + 1 < argc) {
+      budget_s = std::stod(argv[++i]);
+    } else if (arg == "--seed" and i + 1 < argc) {
+      seed = std::stoul(argv[++i]);
+    } else if (arg == "--known") {
+      known = true;
+    } else if (arg == "--movers" and i + 1 < argc) {
+      n_movers = std::stoul(argv[++i]);
+    } else if (arg == "--consider" and i + 1 < argc) {
+      consider_distance = std::stod(argv[++i]);
+    } else if (arg == "--reorder" and i + 1 < argc) {
+      reorder_period = std::stoul(argv[++i]);
+    } else if (arg == "--threads" and i + 1 < argc) {
+      threads = std::stoul(argv[++i]);
+    } else if (arg == "--out" and i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      std::cerr << "usage: slam_bench [--landmarks N1,N2,...] [--scans N] [--budget SECONDS]"
+                << " [--seed S] [--known] [--movers N] [--consider DIST] [--reorder N]"
+                << " [--threads N] [--out FILE]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::mt19937 rng{seed};
+  std::ofstream out(out_path);
+  turtlelib::JsonWriter json(out);
+
+  json.begin_object();
+  json.key("benchmark");
+  json.value("slam_pipeline");
+  json.key("known_association");
+  json.value(known);
+  json.key("consider_distance");
+  json.value(consider_distance);
+  json.key("reorder_period");
+  json.value(reorder_period);
+  json.key("association_threads");
+  json.value(threads);
+  json.key("scan_period_s");
+  json.value(SCAN_PERIOD);
+  json.key("seed");
+  json.value(static_cast<size_t>(seed));
+  json.key("worlds");
+  json.begin_array();
+
+  for (const auto n : counts) {
+    std::cout << "Running world with " << n << " landmarks" << std::endl;
+    const WorldResult res = run_world(
+      n, n_movers, n_scans, budget_s, known, consider_distance, reorder_period, threads, rng);
+
+    json.begin_object();
+    json.key("landmarks");
+    json.value(res.landmarks);
+    json.key("movers");
+    json.value(res.movers);
+    json.key("scans");
+    json.value(res.scans);
+    json.key("truncated");
+    json.value(res.truncated);
+    json.key("detections");
+    json.value(res.detections);
+    json.key("map_size");
+    json.value(res.map_size);
+    json.key("active_landmarks");
+    json.value(res.active_landmarks);
+    json.key("real_time");
+    json.value(res.total_us.percentile(99.0) < SCAN_PERIOD * 1e6);
+    json.key("stages_us");
+    json.begin_object();
+    json.key("simulate");
+    json.value(res.simulate_us);
+    json.key("segment");
+    json.value(res.segment_us);
+    json.key("fit");
+    json.value(res.fit_us);
+    json.key("ekf");
+    json.value(res.ekf_us);
+    json.key("ekf_associate");
+    json.value(res.associate_us);
+    json.key("ekf_predict");
+    json.value(res.predict_us);
+    json.key("ekf_update");
+    json.value(res.update_us);
+    json.key("total");
+    json.value(res.total_us);
+    json.end_object();
+    json.key("allocations_per_scan");
+    json.begin_object();
+    json.key("segment");
+    json.value(res.segment_allocs);
+    json.key("fit");
+    json.value(res.fit_allocs);
+    json.key("ekf");
+    json.value(res.ekf_allocs);
+    json.key("total");
+    json.value(res.total_allocs);
+    json.end_object();
+    json.key("rss_kb");
+    json.value(res.rss_kb);
+    json.key("peak_rss_kb");
+    json.value(res.peak_rss_kb);
+    json.end_object();
+  }
+
+  json.end_array();
+  json.end_object();
+  out << std::endl;
+
+  std::cout << "Wrote SLAM pipeline benchmark results to " << out_path << std::endl;
+  return 0;
+}
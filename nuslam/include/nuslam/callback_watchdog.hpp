@@ -0,0 +1,153 @@
+#ifndef CALLBACK_WATCHDOG_INCLUDE_GUARD_HPP
+#define CALLBACK_WATCHDOG_INCLUDE_GUARD_HPP
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp/logging.hpp>
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "diagnostic_msgs/msg/diagnostic_status.hpp"
+#include "diagnostic_msgs/msg/key_value.hpp"
+#include "turtlelib/watchdog.hpp"
+
+namespace nuslam
+{
+
+/// @brief creates a subscription whose lost messages, as reported by the middleware,
+/// are counted by a watchdog. Falls back to an ordinary subscription when the
+/// middleware does not report lost messages.
+/// @param node the node which owns the subscription
+/// @param topic the topic to subscribe to
+/// @param qos the quality of service of the subscription
+/// @param callback the subscription callback
+/// @param watchdog the watchdog which counts the lost messages
+/// @param id the id of the callback in the watchdog
+/// @param options further options of the subscription
+/// @return the subscription
+template<typename MessageT, typename CallbackT>
+typename rclcpp::Subscription<MessageT>::SharedPtr create_watched_subscription(
+  rclcpp::Node & node, const std::string & topic, const rclcpp::QoS & qos,
+  CallbackT callback, turtlelib::CallbackWatchdog & watchdog, size_t id,
+  rclcpp::SubscriptionOptions options = rclcpp::SubscriptionOptions())
+{
+  options.event_callbacks.message_lost_callback =
+    [&watchdog, id](rclcpp::QOSMessageLostInfo & info) {
+      watchdog.record_lost(id, info.total_count_change);
+    };
+  try {
+    return node.create_subscription<MessageT>(topic, qos, callback, options);
+  } catch (const rclcpp::UnsupportedEventTypeException &) {
+    RCLCPP_WARN_STREAM(
+      node.get_logger(), "The middleware does not report lost messages on " << topic);
+    options.event_callbacks.message_lost_callback = nullptr;
+    return node.create_subscription<MessageT>(topic, qos, callback, options);
+  }
+}
+
+/// @brief summarizes the callbacks of a watchdog since its last reset. The status is a
+/// warning when a callback overran its budget or lost messages, and stale when no
+/// callback ran.
+/// @param watchdog the watchdog to summarize
+/// @param node_name the name of the node which owns the watchdog
+/// @return the diagnostic status
+inline diagnostic_msgs::msg::DiagnosticStatus watchdog_status(
+  const turtlelib::CallbackWatchdog & watchdog, const std::string & node_name)
+{
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.name = node_name + ": callbacks";
+  status.hardware_id = node_name;
+
+  const auto add_value = [&status](const std::string & key, const std::string & value) {
+      diagnostic_msgs::msg::KeyValue kv;
+      kv.key = key;
+      kv.value = value;
+      status.values.push_back(kv);
+    };
+
+  size_t calls = 0;
+  std::vector<std::string> unhealthy;
+  for (size_t id = 0; id < watchdog.size(); id++) {
+    const auto h = watchdog.health(id);
+    calls += h.calls;
+    add_value(h.name + " calls", std::to_string(h.calls));
+    add_value(h.name + " overruns", std::to_string(h.overruns));
+    add_value(h.name + " max (ms)", std::to_string(h.max_duration_us * 1e-3));
+    add_value(h.name + " budget (ms)", std::to_string(h.budget_us * 1e-3));
+    add_value(h.name + " messages lost", std::to_string(h.messages_lost));
+    add_value(h.name + " max queue depth", std::to_string(h.max_queue_depth));
+    add_value(h.name + " max message age (ms)", std::to_string(h.max_message_age_s * 1e3));
+    if (h.overruns > 0 or h.messages_lost > 0) {
+      unhealthy.push_back(h.name);
+    }
+  }
+
+  if (calls == 0) {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::STALE;
+    status.message = "No callbacks since the last report";
+  } else if (not unhealthy.empty()) {
+    std::ostringstream ss;
+    ss << "Overruns or lost messages in";
+    for (const auto & name : unhealthy) {
+      ss << " " << name;
+    }
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    status.message = ss.str();
+  } else {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.message = "OK";
+  }
+  return status;
+}
+
+/// @brief describes a callback which overran its budget
+/// @param overrun the overrun
+/// @param node_name the name of the node which owns the callback
+/// @return the diagnostic status, a warning
+inline diagnostic_msgs::msg::DiagnosticStatus overrun_status(
+  const turtlelib::Overrun & overrun, const std::string & node_name)
+{
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.name = node_name + ": callback overrun";
+  status.hardware_id = node_name;
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+
+  std::ostringstream ss;
+  ss << overrun.callback << " ran for " << overrun.duration_us * 1e-3 <<
+    " ms, over its budget of " << overrun.budget_us * 1e-3 << " ms";
+  status.message = ss.str();
+
+  diagnostic_msgs::msg::KeyValue kv;
+  kv.key = overrun.callback + " (ms)";
+  kv.value = std::to_string(overrun.duration_us * 1e-3);
+  status.values.push_back(kv);
+  return status;
+}
+
+/// @brief publishes the overruns of a watchdog since the last call, if any
+/// @param watchdog the watchdog whose overruns are published
+/// @param node_name the name of the node which owns the watchdog
+/// @param stamp the stamp of the diagnostics
+/// @param pub the diagnostics publisher
+inline void publish_overruns(
+  turtlelib::CallbackWatchdog & watchdog, const std::string & node_name,
+  const rclcpp::Time & stamp,
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray> & pub)
+{
+  const auto overruns = watchdog.take_overruns();
+  if (overruns.empty()) {
+    return;
+  }
+  diagnostic_msgs::msg::DiagnosticArray diagnostics;
+  diagnostics.header.stamp = stamp;
+  for (const auto & overrun : overruns) {
+    diagnostics.status.push_back(overrun_status(overrun, node_name));
+  }
+  pub.publish(diagnostics);
+}
+
+}
+
+#endif
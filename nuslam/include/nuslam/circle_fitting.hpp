@@ -18,8 +18,11 @@ using turtlelib::Vector2D;
 /// std::vector<Vector2D> and various useful methods
 struct Cluster
 {
+  /// @brief distance threshold of Clusters created without one
+  static constexpr double DEFAULT_THRESHOLD = 0.1;
+
 private:
-  double THRESHOLD = 0.1;
+  double THRESHOLD = DEFAULT_THRESHOLD;
   std::vector<Vector2D> cluster_vec;
 
 public:
@@ -69,6 +72,19 @@ public:
 
 };
 
+/// @brief Groups the points of a LIDAR scan into Clusters. Each return is
+/// added to the first existing Cluster it belongs to, or starts a new one.
+/// Returns of 0.0 are treated as no return and skipped.
+/// @param ranges the ranges of the scan, one per beam
+/// @param angle_min the angle of the first beam in radians
+/// @param angle_increment the angle between consecutive beams in radians
+/// @param min_cluster_size Clusters with fewer points than this are discarded
+/// @param threshold points closer than this to a point of a Cluster join it
+/// @return the Clusters found in the scan
+std::vector<Cluster> cluster_scan(
+  const std::vector<float> & ranges, double angle_min, double angle_increment,
+  size_t min_cluster_size, double threshold = Cluster::DEFAULT_THRESHOLD);
+
 /// @brief Attempts to fit a circle to the points in
 /// the given cluster, returning the center and radius
 /// @param cluster a Cluster object defining a cluster of 2D points
@@ -96,6 +112,45 @@ bool is_circle(
   std::tuple<double, double> mean_threshold,
   double std_threshold);
 
+/// @brief the thresholds of the landmark detector
+struct DetectorParams
+{
+  /// @brief Clusters with fewer points are discarded
+  size_t min_cluster_size = 4;
+
+  /// @brief points closer than this to a point of a Cluster join it, in meters
+  double cluster_threshold = Cluster::DEFAULT_THRESHOLD;
+
+  /// @brief lower and upper bounds of the mean inscribed angle, in degrees
+  std::tuple<double, double> mean_threshold{0.0, 130.0};
+
+  /// @brief largest standard deviation of the inscribed angles, in radians
+  double std_threshold = 0.15;
+
+  /// @brief the true radius of the landmarks and the fraction the fitted radius may
+  /// differ from it
+  std::tuple<double, double> true_threshold{0.038, 0.2};
+};
+
+/// @brief finds the circular landmarks in a LIDAR scan by clustering, circle fitting
+/// and classification. Clusters the circle cannot be fit to are skipped
+/// @param ranges the ranges of the scan, one per beam
+/// @param angle_min the angle of the first beam in radians
+/// @param angle_increment the angle between consecutive beams in radians
+/// @param params the thresholds of the detector
+/// @return the centers of the landmarks in the frame of the scan
+std::vector<Vector2D> detect_circles(
+  const std::vector<float> & ranges, double angle_min, double angle_increment,
+  const DetectorParams & params);
+
+/// @brief finds the circular landmarks among the Clusters of a scan by circle fitting
+/// and classification. Clusters the circle cannot be fit to are skipped
+/// @param clusters the Clusters of the scan, from cluster_scan()
+/// @param params the thresholds of the detector. The clustering thresholds are unused
+/// @return the centers of the landmarks in the frame of the scan
+std::vector<Vector2D> detect_circles(
+  const std::vector<Cluster> & clusters, const DetectorParams & params);
+
 namespace vec
 {
 /// @brief computes the mean of the elements in a std::vector<double>
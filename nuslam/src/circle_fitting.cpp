@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <stdexcept>
 #include <tuple>
+#include <utility>
 #include <turtlelib/rigid2d.hpp>
 
 using turtlelib::almost_equal;
@@ -97,6 +98,44 @@ size_t Cluster::count() const
   return cluster_vec.size();
 }
 
+std::vector<Cluster> cluster_scan(
+  const std::vector<float> & ranges, double angle_min, double angle_increment,
+  size_t min_cluster_size, double threshold)
+{
+  std::vector<Cluster> all_clusters;
+
+  // check each point to see if it fits in an existing cluster,
+  // if not, add it to a new cluster
+  for (size_t i = 0; i < ranges.size(); i++) {
+    const double r = ranges.at(i);
+    if (almost_equal(r, 0.0)) {
+      continue;
+    }
+    const double phi = turtlelib::normalize_angle(angle_min + i * angle_increment);
+    const Vector2D v = Vector2D::from_polar(r, phi);
+
+    bool added = false;
+    for (auto & cluster : all_clusters) {
+      added = cluster.belongs(v);
+      if (added) {
+        break;
+      }
+    }
+    if (not added) {
+      all_clusters.push_back(Cluster(v, threshold));
+    }
+  }
+
+  // Remove clusters with too few points
+  std::vector<Cluster> clusters;
+  for (auto & cluster : all_clusters) {
+    if (cluster.count() >= min_cluster_size) {
+      clusters.push_back(std::move(cluster));
+    }
+  }
+  return clusters;
+}
+
 // ===================
 //    Circle Fitting
 // ===================
@@ -281,8 +320,9 @@ bool is_circle(
 
   auto hkr = fit_circle(cluster);   // (center,R) = get<0>(hkr),get<1>(hkr)
   if (not within_percentage(std::get<1>(hkr), R_true, R_true_percent)) {
-    std::cout << "R = " << std::get<1>(hkr) << std::endl;
-    std::cout << "Radius thrown out." << std::endl;
+    RCLCPP_DEBUG_STREAM(
+      rclcpp::get_logger("circle_fitting"),
+      "Radius thrown out, R = " << std::get<1>(hkr));
     return false;
   }
 
@@ -354,4 +394,30 @@ bool is_circle(
 
   }
 }
+
+std::vector<Vector2D> detect_circles(
+  const std::vector<float> & ranges, double angle_min, double angle_increment,
+  const DetectorParams & params)
+{
+  return detect_circles(
+    cluster_scan(
+      ranges, angle_min, angle_increment, params.min_cluster_size, params.cluster_threshold),
+    params);
+}
+
+std::vector<Vector2D> detect_circles(
+  const std::vector<Cluster> & clusters, const DetectorParams & params)
+{
+  std::vector<Vector2D> centers;
+  for (const auto & cluster : clusters) {
+    try {
+      if (is_circle(cluster, params.mean_threshold, params.std_threshold, params.true_threshold)) {
+        centers.push_back(std::get<0>(fit_circle(cluster)));
+      }
+    } catch (const std::exception &) {
+      // the circle cannot be fit to degenerate clusters
+    }
+  }
+  return centers;
+}
 /// @endcond
@@ -0,0 +1,328 @@
+/// @file
+/// @brief explore node: drives the robot to the waypoints which are expected to teach
+/// SLAM the most about the map and the robot pose per meter driven
+///
+/// PARAMETERS:
+///     frequency (int): rate at which cmd_vel is published in Hz (default 10)
+///     autostart (bool): start exploring without calling explore/start (default false)
+///     max_linear, max_angular: largest commanded speeds in m/s and rad/s
+///         (default 0.1 and 1.0)
+///     k_linear, k_angular: gains of the go to waypoint controller (default 1.0 and 2.0)
+///     goal_tolerance: distance in meters at which a waypoint is reached (default 0.05)
+///     waypoint_timeout: seconds after which an unreached waypoint is replaced (default 30)
+///     coverage_goal: fraction of the arena to explore before stopping (default 0.95)
+///     arena_x_length, arena_y_length: size of the arena in meters (default 5.0)
+///     arena_center_x, arena_center_y: center of the arena in the map frame (default 0.0)
+///     sensor_range: landmarks within this distance are expected to be seen (default 1.5)
+///     measurement_variance: variance of a landmark measurement, the R gain of slam
+///         (default 1.0)
+///     new_landmark_variance: variance of a landmark when it is first seen (default 4.0)
+///     landmark_density: expected landmarks per square meter of unexplored area
+///         (default 0.5)
+///     drift_per_meter: growth of the robot position variance per meter (default 0.01)
+///     turn_cost: meters of driving that cost as much as turning one radian (default 0.1)
+///     clearance: distance waypoints and paths keep from landmarks and walls (default 0.25)
+///     radii: distances of the candidate waypoints from the robot (default [0.5, 1.0, 1.5])
+///     headings: number of directions of the candidate waypoints (default 12)
+///     cell_size: side of the cells which track the explored area (default 0.25)
+///     min_gain: waypoints which gain fewer nats are ignored (default 0.05)
+/// PUBLISHES:
+///     /cmd_vel (geometry_msgs/msg/Twist): velocity towards the current waypoint
+///     explore/waypoint (geometry_msgs/msg/PointStamped): the current waypoint
+/// SUBSCRIBES:
+///     /slam/map_estimate (nuslam/msg/MapEstimate): SLAM estimates and their covariances
+/// SERVICES:
+///     explore/start (std_srvs/srv/Empty): starts (or resumes) exploring
+///     explore/stop (std_srvs/srv/Empty): stops the robot
+/// CLIENTS:
+///     None
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/logging.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+#include "geometry_msgs/msg/point_stamped.hpp"
+#include "geometry_msgs/msg/twist.hpp"
+#include "std_srvs/srv/empty.hpp"
+#include "nuslam/msg/map_estimate.hpp"
+
+#include "turtlelib/diff_drive.hpp"
+#include "turtlelib/explore.hpp"
+#include "turtlelib/rigid2d.hpp"
+
+using namespace std::chrono_literals;
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+/// @brief explore node which plans waypoints from the SLAM marginals and drives to them
+class Explore : public rclcpp::Node
+{
+public:
+  Explore()
+  : Node("explore")
+  {
+    turtlelib::ExplorationParams params;
+    declare_parameter("frequency", RATE);
+    declare_parameter("autostart", AUTOSTART);
+    declare_parameter("max_linear", MAX_LINEAR);
+    declare_parameter("max_angular", MAX_ANGULAR);
+    declare_parameter("k_linear", K_LINEAR);
+    declare_parameter("k_angular", K_ANGULAR);
+    declare_parameter("goal_tolerance", GOAL_TOLERANCE);
+    declare_parameter("waypoint_timeout", WAYPOINT_TIMEOUT);
+    declare_parameter("coverage_goal", COVERAGE_GOAL);
+    declare_parameter("arena_x_length", params.x_length);
+    declare_parameter("arena_y_length", params.y_length);
+    declare_parameter("arena_center_x", params.arena_center.x);
+    declare_parameter("arena_center_y", params.arena_center.y);
+    declare_parameter("sensor_range", params.sensor_range);
+    declare_parameter("measurement_variance", params.measurement_variance);
+    declare_parameter("new_landmark_variance", params.new_landmark_variance);
+    declare_parameter("landmark_density", params.landmark_density);
+    declare_parameter("drift_per_meter", params.drift_per_meter);
+    declare_parameter("turn_cost", params.turn_cost);
+    declare_parameter("clearance", params.clearance);
+    declare_parameter("radii", params.radii);
+    declare_parameter("headings", static_cast<int>(params.headings));
+    declare_parameter("cell_size", params.cell_size);
+    declare_parameter("min_gain", params.min_gain);
+
+    RATE = get_parameter("frequency").get_value<int>();
+    AUTOSTART = get_parameter("autostart").get_value<bool>();
+    MAX_LINEAR = get_parameter("max_linear").get_value<double>();
+    MAX_ANGULAR = get_parameter("max_angular").get_value<double>();
+    K_LINEAR = get_parameter("k_linear").get_value<double>();
+    K_ANGULAR = get_parameter("k_angular").get_value<double>();
+    GOAL_TOLERANCE = get_parameter("goal_tolerance").get_value<double>();
+    WAYPOINT_TIMEOUT = get_parameter("waypoint_timeout").get_value<double>();
+    COVERAGE_GOAL = get_parameter("coverage_goal").get_value<double>();
+    params.x_length = get_parameter("arena_x_length").get_value<double>();
+    params.y_length = get_parameter("arena_y_length").get_value<double>();
+    params.arena_center.x = get_parameter("arena_center_x").get_value<double>();
+    params.arena_center.y = get_parameter("arena_center_y").get_value<double>();
+    params.sensor_range = get_parameter("sensor_range").get_value<double>();
+    params.measurement_variance = get_parameter("measurement_variance").get_value<double>();
+    params.new_landmark_variance = get_parameter("new_landmark_variance").get_value<double>();
+    params.landmark_density = get_parameter("landmark_density").get_value<double>();
+    params.drift_per_meter = get_parameter("drift_per_meter").get_value<double>();
+    params.turn_cost = get_parameter("turn_cost").get_value<double>();
+    params.clearance = get_parameter("clearance").get_value<double>();
+    params.radii = get_parameter("radii").get_value<std::vector<double>>();
+    const int64_t headings = get_parameter("headings").as_int();
+    params.headings = static_cast<size_t>(std::max<int64_t>(0, headings));
+    params.cell_size = get_parameter("cell_size").get_value<double>();
+    params.min_gain = get_parameter("min_gain").get_value<double>();
+
+    if (RATE <= 0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "frequency must be positive");
+      throw std::runtime_error("frequency must be positive");
+    }
+    try {
+      planner = turtlelib::ExplorationPlanner(params);
+    } catch (const std::invalid_argument & e) {
+      RCLCPP_ERROR_STREAM(get_logger(), e.what());
+      throw std::runtime_error(e.what());
+    }
+
+    /// @brief Publisher to cmd_vel topic
+    cmd_vel_pub = create_publisher<geometry_msgs::msg::Twist>("cmd_vel", 10);
+
+    /// @brief Publishes the waypoint the robot is driving to
+    waypoint_pub = create_publisher<geometry_msgs::msg::PointStamped>("explore/waypoint", 10);
+
+    /// @brief Subscriber to the SLAM estimates and marginals
+    map_estimate_sub = create_subscription<nuslam::msg::MapEstimate>(
+      "/slam/map_estimate", 10, std::bind(&Explore::map_estimate_callback, this, _1));
+
+    /// \brief Timer (frequency defined by node parameter)
+    _timer = create_wall_timer(
+      std::chrono::milliseconds((int)(1000 / RATE)),
+      std::bind(&Explore::timer_callback, this));
+
+    /// @brief start service that starts exploring
+    _start_service = create_service<std_srvs::srv::Empty>(
+      "explore/start",
+      std::bind(&Explore::start_callback, this, _1, _2));
+
+    /// @brief stop service that stops the robot
+    _stop_service = create_service<std_srvs::srv::Empty>(
+      "explore/stop",
+      std::bind(&Explore::stop_callback, this, _1, _2));
+
+    STOPPED = not AUTOSTART;
+    start_time = get_clock()->now();
+  }
+
+private:
+  // Controller
+  int RATE = 10;
+  bool AUTOSTART = false;
+  double MAX_LINEAR = 0.1;          // m/s
+  double MAX_ANGULAR = 1.0;         // rad/s
+  double K_LINEAR = 1.0;
+  double K_ANGULAR = 2.0;
+  double GOAL_TOLERANCE = 0.05;     // m
+  double WAYPOINT_TIMEOUT = 30.0;   // s
+  double COVERAGE_GOAL = 0.95;
+
+  // Estimates older than this stop the robot
+  static constexpr double STALE_ESTIMATE = 1.0; // s
+
+  bool STOPPED = true;
+  turtlelib::ExplorationPlanner planner;
+  bool has_waypoint = false;
+  turtlelib::Waypoint waypoint;
+  rclcpp::Time waypoint_time{0, 0, RCL_ROS_TIME};
+  rclcpp::Time estimate_time{0, 0, RCL_ROS_TIME};
+  rclcpp::Time start_time{0, 0, RCL_ROS_TIME};
+  bool has_pose = false;
+  turtlelib::Pose2D last_pose{0.0, 0.0, 0.0};
+  double distance_driven = 0.0;
+
+  geometry_msgs::msg::Twist twist_msg;
+  rclcpp::TimerBase::SharedPtr _timer;
+
+  // Services
+  rclcpp::Service<std_srvs::srv::Empty>::SharedPtr _start_service;
+  rclcpp::Service<std_srvs::srv::Empty>::SharedPtr _stop_service;
+
+  // Publishers and subscribers
+  rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr cmd_vel_pub;
+  rclcpp::Publisher<geometry_msgs::msg::PointStamped>::SharedPtr waypoint_pub;
+  rclcpp::Subscription<nuslam::msg::MapEstimate>::SharedPtr map_estimate_sub;
+
+  /// @brief plans and follows waypoints from each new SLAM estimate
+  /// @param msg the SLAM estimate with its marginal covariances
+  void map_estimate_callback(const nuslam::msg::MapEstimate & msg)
+  {
+    const turtlelib::Pose2D pose{msg.pose.x, msg.pose.y, msg.pose.theta};
+    estimate_time = get_clock()->now();
+    planner.observe(pose);
+    if (has_pose and not STOPPED) {
+      distance_driven += turtlelib::distance(
+        turtlelib::Vector2D{pose.x, pose.y}, turtlelib::Vector2D{last_pose.x, last_pose.y});
+    }
+    last_pose = pose;
+    has_pose = true;
+
+    if (STOPPED) {
+      return;
+    }
+    if (msg.landmark_covariances.size() != 3 * msg.landmarks.size()) {
+      RCLCPP_WARN_STREAM(get_logger(), "Map estimate without a covariance for every landmark");
+      return;
+    }
+
+    const bool reached = has_waypoint and turtlelib::distance(
+      waypoint.position, turtlelib::Vector2D{pose.x, pose.y}) < GOAL_TOLERANCE;
+    const bool timed_out = has_waypoint and
+      (estimate_time - waypoint_time).seconds() > WAYPOINT_TIMEOUT;
+    if (not has_waypoint or reached or timed_out) {
+      if (timed_out) {
+        RCLCPP_WARN_STREAM(get_logger(), "Waypoint not reached in time, replanning");
+      }
+      std::array<double, 9> pose_cov;
+      std::copy(msg.pose_covariance.begin(), msg.pose_covariance.end(), pose_cov.begin());
+      std::vector<turtlelib::LandmarkBelief> landmarks(msg.landmarks.size());
+      for (size_t i = 0; i < landmarks.size(); i++) {
+        const auto & point = msg.landmarks.at(i);
+        landmarks.at(i).position = turtlelib::Vector2D{point.x, point.y};
+        std::copy_n(
+          msg.landmark_covariances.begin() + 3 * i, 3, landmarks.at(i).covariance.begin());
+      }
+
+      waypoint = planner.plan(pose, pose_cov, landmarks);
+      if (planner.explored_fraction() >= COVERAGE_GOAL or waypoint.gain <= 0.0) {
+        RCLCPP_INFO_STREAM(
+          get_logger(), "Exploration finished: " << 100.0 * planner.explored_fraction() <<
+            "% of the arena and " << landmarks.size() << " landmarks in " << distance_driven <<
+            " m and " << (estimate_time - start_time).seconds() << " s");
+        stop();
+        return;
+      }
+      has_waypoint = true;
+      waypoint_time = estimate_time;
+      RCLCPP_DEBUG_STREAM(
+        get_logger(), "Waypoint (" << waypoint.position.x << ", " << waypoint.position.y <<
+          ") gains " << waypoint.gain << " nats for " << waypoint.cost << " m");
+
+      geometry_msgs::msg::PointStamped point;
+      point.header.stamp = estimate_time;
+      point.header.frame_id = msg.header.frame_id;
+      point.point.x = waypoint.position.x;
+      point.point.y = waypoint.position.y;
+      waypoint_pub->publish(point);
+    }
+
+    // turn towards the waypoint, and only drive forward when roughly facing it
+    const double dx = waypoint.position.x - pose.x;
+    const double dy = waypoint.position.y - pose.y;
+    const double heading_error = turtlelib::normalize_angle(std::atan2(dy, dx) - pose.theta);
+    const double forward = std::max(0.0, std::cos(heading_error));
+    twist_msg.linear.x = std::min(MAX_LINEAR, K_LINEAR * std::hypot(dx, dy)) * forward * forward;
+    twist_msg.angular.z = std::clamp(K_ANGULAR * heading_error, -MAX_ANGULAR, MAX_ANGULAR);
+  }
+
+  /// @brief stops the robot and forgets the waypoint
+  void stop()
+  {
+    STOPPED = true;
+    has_waypoint = false;
+    twist_msg = geometry_msgs::msg::Twist();
+    cmd_vel_pub->publish(twist_msg);
+  }
+
+  /// @brief starts exploring from the next SLAM estimate
+  void start_callback(
+    const std::shared_ptr<std_srvs::srv::Empty::Request>,
+    std::shared_ptr<std_srvs::srv::Empty::Response>)
+  {
+    RCLCPP_INFO_STREAM(get_logger(), "Exploring");
+    if (STOPPED) {
+      start_time = get_clock()->now();
+      distance_driven = 0.0;
+    }
+    STOPPED = false;
+  }
+
+  /// @brief stops the robot
+  void stop_callback(
+    const std::shared_ptr<std_srvs::srv::Empty::Request>,
+    std::shared_ptr<std_srvs::srv::Empty::Response>)
+  {
+    RCLCPP_INFO_STREAM(get_logger(), "Stopping robot");
+    stop();
+  }
+
+  /// @brief timer callback to publish the Twist messages on /cmd_vel
+  void timer_callback()
+  {
+    if (STOPPED) {
+      return;
+    }
+
+    // without fresh estimates the robot would drive blind
+    if ((get_clock()->now() - estimate_time).seconds() > STALE_ESTIMATE) {
+      twist_msg = geometry_msgs::msg::Twist();
+    }
+    cmd_vel_pub->publish(twist_msg);
+  }
+};
+
+/// @brief the main function to run the explore node
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<Explore>());
+  rclcpp::shutdown();
+  return 0;
+}
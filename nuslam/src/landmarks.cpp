@@ -4,27 +4,75 @@
 ///
 /// PARAMETERS:
 ///   robot: "nusim" for simulation, "localhost" for robot
+///   profile_period: log the duration and heap allocations of the scan callback every
+///     this many scans, 0 to disable. Allocations are only counted when built with
+///     NUSLAM_TRACK_ALLOCATIONS
+///   allocation_budget: warn when a scan callback allocates more than this many times,
+///     -1 to disable
+///   callback_budget: longest a scan callback may run in seconds before it is reported
+///     as an overrun, 0 to disable (default 0.1)
+///   min_cluster_size: clusters with fewer points are discarded (default 4)
+///   cluster_threshold: points closer than this to a point of a cluster join it, in
+///     meters (default 0.1)
+///   mean_threshold: lower and upper bounds of the mean inscribed angle of a circle, in
+///     degrees (default [0.0, 130.0])
+///   std_threshold: largest standard deviation of the inscribed angles of a circle, in
+///     radians (default 0.15)
+///   true_radius: radius of the landmarks in meters (default 0.038)
+///   radius_tolerance: fraction the fitted radius may differ from true_radius
+///     (default 0.2)
+///   resource_period: seconds between reports of the CPU time, memory, and message
+///     rates of the node on /diagnostics, 0 to disable (default 5.0)
+///   adaptive_rate: skip scans while the SLAM pose is certain and the robot slow, which
+///     also slows the EKF updates (default false)
+///   scan_rate_bounds: scans processed per second when certain and slow, and at most
+///     (default [1.0, 5.0])
+///   position_std_thresholds: standard deviations of the SLAM position in m below which
+///     it is certain and above which it is uncertain (default [0.02, 0.1])
+///   heading_std_thresholds: the same for the heading in rad (default [0.02, 0.1])
+///   speed_thresholds: linear speeds in m/s below which the robot is slow and above
+///     which it is fast (default [0.02, 0.1])
+///   turn_rate_thresholds: the same for the turn rate in rad/s (default [0.1, 0.5])
+///   estimate_timeout: seconds after which the uncertainty or speed is too old and every
+///     scan is processed again (default 2.0)
 /// PUBLISHES:
-///   /detected_landmarks (nuslam/msg/PointArray): Centers of the detected landmarks
+///   /detected_landmarks (nuslam/msg/PointArray): Centers of the detected landmarks,
+///     stamped with the scan they were detected in
 ///   /clusters (visualization_msgs/MarkerArray): Centroids of the detected clusters
+///   /diagnostics (diagnostic_msgs/DiagnosticArray): every scan callback overrun as it
+///     happens, and once per second the durations, overruns, lost messages, and queue
+///     depth of the scan callback; and every resource_period the CPU time of the node
+///     and its threads, its memory, and the rates of its topics; and with adaptive_rate
+///     once per second the target scan rate and the processed and skipped scans
 /// SUBSCRIBES:
 ///   /scan (sensor_msgs/LaserScan): LIDAR scanner
+///   /slam/map_estimate (nuslam/msg/MapEstimate): uncertainty of the SLAM pose, if
+///     adaptive_rate
+///   /odom (nav_msgs/Odometry): speed of the robot, if adaptive_rate
 /// SERVICES:
 ///   None
 /// CLIENTS:
 ///   None
 
 #include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <geometry_msgs/msg/detail/point__struct.hpp>
 #include <rclcpp/duration.hpp>
 #include <tuple>
+#include <vector>
 #include <memory>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
 #include <rclcpp/publisher.hpp>
 
+#include "nuslam/callback_watchdog.hpp"
 #include "nuslam/circle_fitting.hpp"
 #include "nuslam/msg/detail/point_array__struct.hpp"
 #include "rclcpp/logging.hpp"
@@ -35,10 +83,19 @@
 #include "visualization_msgs/msg/marker.hpp"
 #include "visualization_msgs/msg/marker_array.hpp"
 #include "nuslam/msg/point_array.hpp"
+#include "nuslam/msg/map_estimate.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "diagnostic_msgs/msg/key_value.hpp"
 
+#include "turtlelib/alloc_tracker.hpp"
 #include "turtlelib/diff_drive.hpp"
 #include "turtlelib/kalman.hpp"
+#include "turtlelib/resource_monitor.hpp"
+#include "turtlelib/resource_status.hpp"
 #include "turtlelib/rigid2d.hpp"
+#include "turtlelib/scan_rate.hpp"
+#include "turtlelib/watchdog.hpp"
 
 #include "nuslam/circle_fitting.hpp"
 
@@ -47,12 +104,6 @@
 using namespace std::chrono_literals;
 using std::placeholders::_1;
 
-/// @brief minimum amount of points to be considered a cluster
-constexpr unsigned int MIN_CLUSTER_SIZE = 4;
-
-/// @brief true radius of the landmarks
-constexpr double TRUE_RADIUS = 0.038;
-
 /// @brief Landmarks detection node
 class Landmarks : public rclcpp::Node
 {
@@ -62,108 +113,311 @@ public:
   {
 
     declare_parameter("robot", ROBOT);
+    declare_parameter("profile_period", PROFILE_PERIOD);
+    declare_parameter("allocation_budget", ALLOCATION_BUDGET);
+    declare_parameter("callback_budget", CALLBACK_BUDGET);
+    declare_parameter("resource_period", RESOURCE_PERIOD);
+    declare_parameter("min_cluster_size", static_cast<int>(detector.min_cluster_size));
+    declare_parameter("cluster_threshold", detector.cluster_threshold);
+    declare_parameter(
+      "mean_threshold", std::vector<double>{
+        std::get<0>(detector.mean_threshold), std::get<1>(detector.mean_threshold)});
+    declare_parameter("std_threshold", detector.std_threshold);
+    declare_parameter("true_radius", std::get<0>(detector.true_threshold));
+    declare_parameter("radius_tolerance", std::get<1>(detector.true_threshold));
+    declare_parameter("adaptive_rate", ADAPTIVE_RATE);
+    declare_parameter(
+      "scan_rate_bounds", std::vector<double>{scan_rate.min_rate, scan_rate.max_rate});
+    declare_parameter(
+      "position_std_thresholds", std::vector<double>{
+        scan_rate.confident_position_std, scan_rate.uncertain_position_std});
+    declare_parameter(
+      "heading_std_thresholds", std::vector<double>{
+        scan_rate.confident_heading_std, scan_rate.uncertain_heading_std});
+    declare_parameter(
+      "speed_thresholds", std::vector<double>{scan_rate.slow_speed, scan_rate.fast_speed});
+    declare_parameter(
+      "turn_rate_thresholds", std::vector<double>{
+        scan_rate.slow_turn_rate, scan_rate.fast_turn_rate});
+    declare_parameter("estimate_timeout", scan_rate.timeout);
     ROBOT = get_parameter("robot").get_value<std::string>();
+    PROFILE_PERIOD = get_parameter("profile_period").get_value<int>();
+    ALLOCATION_BUDGET = get_parameter("allocation_budget").get_value<int>();
+    CALLBACK_BUDGET = get_parameter("callback_budget").get_value<double>();
+    RESOURCE_PERIOD = get_parameter("resource_period").get_value<double>();
+    const int64_t min_cluster_size = get_parameter("min_cluster_size").as_int();
+    const auto mean_threshold = get_parameter("mean_threshold").as_double_array();
+    detector.cluster_threshold = get_parameter("cluster_threshold").as_double();
+    detector.std_threshold = get_parameter("std_threshold").as_double();
+    detector.true_threshold = {
+      get_parameter("true_radius").as_double(), get_parameter("radius_tolerance").as_double()};
+
+    if (min_cluster_size < 3) {
+      // three points are needed to fit a circle
+      RCLCPP_ERROR_STREAM(get_logger(), "min_cluster_size must be at least 3");
+      throw std::runtime_error("min_cluster_size must be at least 3");
+    }
+    detector.min_cluster_size = static_cast<size_t>(min_cluster_size);
+    if (mean_threshold.size() != 2) {
+      RCLCPP_ERROR_STREAM(get_logger(), "mean_threshold must be [lower, upper]");
+      throw std::runtime_error("mean_threshold must be [lower, upper]");
+    }
+    detector.mean_threshold = {mean_threshold.at(0), mean_threshold.at(1)};
+
+    ADAPTIVE_RATE = get_parameter("adaptive_rate").get_value<bool>();
+    std::tie(scan_rate.min_rate, scan_rate.max_rate) = get_bounds("scan_rate_bounds");
+    std::tie(scan_rate.confident_position_std, scan_rate.uncertain_position_std) =
+      get_bounds("position_std_thresholds");
+    std::tie(scan_rate.confident_heading_std, scan_rate.uncertain_heading_std) =
+      get_bounds("heading_std_thresholds");
+    std::tie(scan_rate.slow_speed, scan_rate.fast_speed) = get_bounds("speed_thresholds");
+    std::tie(scan_rate.slow_turn_rate, scan_rate.fast_turn_rate) =
+      get_bounds("turn_rate_thresholds");
+    scan_rate.timeout = get_parameter("estimate_timeout").as_double();
+    try {
+      rate_controller = turtlelib::ScanRateController(scan_rate);
+    } catch (const std::invalid_argument & e) {
+      RCLCPP_ERROR_STREAM(get_logger(), e.what());
+      throw std::runtime_error(e.what());
+    }
+
+    if (CALLBACK_BUDGET < 0.0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "callback_budget cannot be negative");
+      throw std::runtime_error("callback_budget cannot be negative");
+    }
+    lidar_watch = watchdog.add_callback("lidar_callback", CALLBACK_BUDGET * 1e6);
+    if (RESOURCE_PERIOD < 0.0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "resource_period cannot be negative");
+      throw std::runtime_error("resource_period cannot be negative");
+    }
+    lidar_count = resources.add_subscription("/scan");
+    detected_landmarks_count = resources.add_publisher("/detected_landmarks");
+    cluster_count = resources.add_publisher("/clusters");
+    if (ADAPTIVE_RATE) {
+      map_estimate_count = resources.add_subscription("/slam/map_estimate");
+      odom_count = resources.add_subscription("/odom");
+    }
 
     if (ROBOT == "nusim") {
-      lidar_sub = create_subscription<sensor_msgs::msg::LaserScan>(
-        "/scan", 10,
-        std::bind(&Landmarks::lidar_callback, this, _1));
+      lidar_sub = nuslam::create_watched_subscription<sensor_msgs::msg::LaserScan>(
+        *this, "/scan", rclcpp::QoS(10),
+        std::bind(&Landmarks::lidar_callback, this, _1), watchdog, lidar_watch);
     } else if (ROBOT == "localhost") {
-      lidar_sub = create_subscription<sensor_msgs::msg::LaserScan>(
-        "/scan", rclcpp::SensorDataQoS(),
-        std::bind(&Landmarks::lidar_callback, this, _1));
+      lidar_sub = nuslam::create_watched_subscription<sensor_msgs::msg::LaserScan>(
+        *this, "/scan", rclcpp::SensorDataQoS(),
+        std::bind(&Landmarks::lidar_callback, this, _1), watchdog, lidar_watch);
+    }
+
+    if (ADAPTIVE_RATE) {
+      map_estimate_sub = create_subscription<nuslam::msg::MapEstimate>(
+        "/slam/map_estimate", 10, std::bind(&Landmarks::map_estimate_callback, this, _1));
+      odom_sub = create_subscription<nav_msgs::msg::Odometry>(
+        "/odom", 10, std::bind(&Landmarks::odom_callback, this, _1));
     }
 
     cluster_pub = create_publisher<visualization_msgs::msg::MarkerArray>("/clusters", 10);
 
     detected_landmarks_pub = create_publisher<nuslam::msg::PointArray>("/detected_landmarks", 10);
+
+    diagnostics_pub = create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
+
+    diagnostics_timer = create_wall_timer(
+      1s, std::bind(&Landmarks::diagnostics_timer_callback, this));
+
+    if (RESOURCE_PERIOD > 0.0) {
+      resource_timer = create_wall_timer(
+        std::chrono::milliseconds((int)(1000 * RESOURCE_PERIOD)),
+        std::bind(&Landmarks::resource_timer_callback, this));
+    }
   }
 
 private:
   // Parameters
   std::string ROBOT = "nusim";
+  int PROFILE_PERIOD = 0;
+  int ALLOCATION_BUDGET = -1;
+  double CALLBACK_BUDGET = 0.1;
+  double RESOURCE_PERIOD = 5.0;
+  bool ADAPTIVE_RATE = false;
+
+  // duration and heap allocations of each scan callback
+  turtlelib::CallbackProfile lidar_profile;
+
+  // overruns, lost messages, and queue depth of the scan callback
+  turtlelib::CallbackWatchdog watchdog;
+  size_t lidar_watch = 0;
+
+  // CPU time, memory, and message rates of the node
+  turtlelib::ResourceMonitor resources;
+  size_t lidar_count = 0;
+  size_t detected_landmarks_count = 0;
+  size_t cluster_count = 0;
+  size_t map_estimate_count = 0;
+  size_t odom_count = 0;
+
+  // how often to process scans, from the SLAM uncertainty and the speed of the robot
+  turtlelib::ScanRateParams scan_rate;
+  turtlelib::ScanRateController rate_controller;
+
+  // Timers
+  rclcpp::TimerBase::SharedPtr diagnostics_timer;
+  rclcpp::TimerBase::SharedPtr resource_timer;
 
   // Subscriptions
   rclcpp::Subscription<sensor_msgs::msg::LaserScan>::SharedPtr lidar_sub;
+  rclcpp::Subscription<nuslam::msg::MapEstimate>::SharedPtr map_estimate_sub;
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr odom_sub;
 
   // Publishers
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr cluster_pub;
   rclcpp::Publisher<nuslam::msg::PointArray>::SharedPtr detected_landmarks_pub;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub;
 
   // Vector of Cluster objects representing all the clusters of points
   std::vector<Cluster> all_clusters;
 
-  // Thresholds for circle classification
-  const std::tuple<double, double> mean_threshold{0.0, 130.0};
-  const std::tuple<double, double> true_threshold{TRUE_RADIUS, 0.2};
-  const double std_threshold = 0.15;
+  // Thresholds for clustering and circle classification
+  DetectorParams detector;
 
 
+  /// @brief reads a [lower, upper] parameter
+  std::tuple<double, double> get_bounds(const std::string & name)
+  {
+    const auto bounds = get_parameter(name).as_double_array();
+    if (bounds.size() != 2) {
+      RCLCPP_ERROR_STREAM(get_logger(), name << " must be [lower, upper]");
+      throw std::runtime_error(name + " must be [lower, upper]");
+    }
+    return {bounds.at(0), bounds.at(1)};
+  }
+
   void lidar_callback(const sensor_msgs::msg::LaserScan & lidar_data)
   {
+    resources.count(lidar_count);
+    watchdog.record_message(
+      lidar_watch, rclcpp::Time(lidar_data.header.stamp, RCL_ROS_TIME).seconds(),
+      get_clock()->now().seconds());
+    if (ADAPTIVE_RATE and not rate_controller.accept(get_clock()->now().seconds())) {
+      return;
+    }
+    {
+      const turtlelib::CallbackWatchdog::Scope watch(watchdog, lidar_watch);
+      const turtlelib::CallbackProfile::Sample sample(lidar_profile);
+      detect_landmarks(lidar_data);
+    }
+    nuslam::publish_overruns(watchdog, get_name(), get_clock()->now(), *diagnostics_pub);
+    report_profile();
+  }
+
+  /// @brief keeps the uncertainty of the SLAM pose for the scan rate
+  void map_estimate_callback(const nuslam::msg::MapEstimate & msg)
+  {
+    resources.count(map_estimate_count);
+    rate_controller.set_pose_covariance(get_clock()->now().seconds(), msg.pose_covariance);
+  }
 
-    all_clusters.clear(); // clears clusters from the previous scan
+  /// @brief keeps the speed of the robot for the scan rate
+  void odom_callback(const nav_msgs::msg::Odometry & msg)
+  {
+    resources.count(odom_count);
+    rate_controller.set_speed(
+      get_clock()->now().seconds(), std::hypot(msg.twist.twist.linear.x, msg.twist.twist.linear.y),
+      msg.twist.twist.angular.z);
+  }
 
-    // check each point to see if it fits in an existing cluster,
-    // if not, add it to a new cluster
-    for (size_t i = 0; i < lidar_data.ranges.size(); i++) {
-      // for each point
-      const double r = lidar_data.ranges.at(i);
-      if (turtlelib::almost_equal(r, 0.0)) {
-        continue;
-      }
-      const double phi = turtlelib::normalize_angle(turtlelib::deg2rad(i));
-      const turtlelib::Vector2D v = turtlelib::Vector2D::from_polar(r, phi);
-
-      // for each cluster we have
-      bool added = false;
-      for (auto & cluster : all_clusters) {
-        added = cluster.belongs(v);
-        if (added) {
-          break;
-        }
-      }
-      if (not added) {
-        // add the point as a new Cluster
-        all_clusters.push_back(Cluster(v));
-      }
+  /// @brief describes the scans processed and skipped since the last call
+  diagnostic_msgs::msg::DiagnosticStatus scan_rate_status()
+  {
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.name = std::string(get_name()) + ": scan rate";
+    status.hardware_id = get_name();
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    const double now = get_clock()->now().seconds();
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(2) << rate_controller.rate(now) << " Hz target";
+    status.message = message.str();
+    const std::vector<std::pair<std::string, std::string>> values{
+      {"target rate (Hz)", std::to_string(rate_controller.rate(now))},
+      {"demand", std::to_string(rate_controller.demand(now))},
+      {"processed", std::to_string(rate_controller.accepted())},
+      {"skipped", std::to_string(rate_controller.skipped())}};
+    for (const auto & [key, value] : values) {
+      diagnostic_msgs::msg::KeyValue kv;
+      kv.key = key;
+      kv.value = value;
+      status.values.push_back(kv);
     }
+    rate_controller.reset_counts();
+    return status;
+  }
 
-    // Remove clusters with too few points
-    std::vector<Cluster> temp_cluster_vec;
-    for (const auto & cluster : all_clusters) {
-      if (cluster.count() >= MIN_CLUSTER_SIZE) {
-        temp_cluster_vec.push_back(cluster);
-      }
+  /// @brief publishes the health of the scan callback since the last call as diagnostics
+  void diagnostics_timer_callback()
+  {
+    diagnostic_msgs::msg::DiagnosticArray diagnostics;
+    diagnostics.header.stamp = get_clock()->now();
+    diagnostics.status.push_back(nuslam::watchdog_status(watchdog, get_name()));
+    if (ADAPTIVE_RATE) {
+      diagnostics.status.push_back(scan_rate_status());
     }
-    all_clusters = temp_cluster_vec;
-    temp_cluster_vec.clear();
+    diagnostics_pub->publish(diagnostics);
+    watchdog.reset();
+  }
+
+  /// @brief publishes the resources used by the node since the last call as diagnostics
+  void resource_timer_callback()
+  {
+    diagnostic_msgs::msg::DiagnosticArray diagnostics;
+    diagnostics.header.stamp = get_clock()->now();
+    diagnostics.status.push_back(turtlelib::resource_status(resources.report(), get_name()));
+    diagnostics_pub->publish(diagnostics);
+  }
+
+  /// @brief logs the callback profile once every PROFILE_PERIOD scans
+  void report_profile()
+  {
+    if (PROFILE_PERIOD <= 0) {
+      lidar_profile.clear();
+      return;
+    }
+    if (lidar_profile.count() < static_cast<size_t>(PROFILE_PERIOD)) {
+      return;
+    }
+    RCLCPP_INFO_STREAM(get_logger(), lidar_profile.summary("lidar_callback"));
+    if (ALLOCATION_BUDGET >= 0 and
+      lidar_profile.allocations().max() > static_cast<double>(ALLOCATION_BUDGET))
+    {
+      RCLCPP_WARN_STREAM(
+        get_logger(), "lidar_callback allocated up to " << lidar_profile.allocations().max() <<
+          " times per scan, over the budget of " << ALLOCATION_BUDGET);
+    }
+    lidar_profile.clear();
+  }
+
+  /// @brief detects circular landmarks in a scan and publishes their centers
+  void detect_landmarks(const sensor_msgs::msg::LaserScan & lidar_data)
+  {
+    // group the scan into clusters, discarding clusters with too few points
+    all_clusters = cluster_scan(
+      lidar_data.ranges, lidar_data.angle_min, lidar_data.angle_increment,
+      detector.min_cluster_size, detector.cluster_threshold);
 
+    // carry the scan stamp along so slam can trace the latency of its estimates
     nuslam::msg::PointArray point_arr;
-    RCLCPP_DEBUG_STREAM(get_logger(), "----------------------------------");
-    int count = 1;
+    point_arr.header = lidar_data.header;
     if (not all_clusters.empty()) {
-      for (const auto & cluster: all_clusters) {
-        auto hkr = fit_circle(cluster);
-        RCLCPP_DEBUG_STREAM(get_logger(), "Cluster " << count);
-        RCLCPP_DEBUG_STREAM(get_logger(), "Center = " << std::get<0>(hkr));
-        RCLCPP_DEBUG_STREAM(get_logger(), "Radius = " << std::get<1>(hkr));
-        RCLCPP_DEBUG_STREAM(get_logger(), "----------------------------------");
-
-        if (is_circle(cluster, mean_threshold, std_threshold, true_threshold)) {
-          RCLCPP_INFO_STREAM(get_logger(), "Center = " << std::get<0>(hkr));
-          RCLCPP_INFO_STREAM(get_logger(), "Radius = " << std::get<1>(hkr));
-
-          // publish the landmarks (x,y) which is the center of the circle
-          geometry_msgs::msg::Point center;
-          center.x = std::get<0>(hkr).x;
-          center.y = std::get<0>(hkr).y;
-          center.z = 0.0;
-          point_arr.points.push_back(center);
-        }
-        count++;
+      // the same detector the detector_sweep tunes, publishing the centers of the circles
+      for (const auto & c : detect_circles(all_clusters, detector)) {
+        RCLCPP_DEBUG_STREAM(get_logger(), "Center = " << c);
+        geometry_msgs::msg::Point center;
+        center.x = c.x;
+        center.y = c.y;
+        center.z = 0.0;
+        point_arr.points.push_back(center);
       }
+      point_arr.detection_stamp = get_clock()->now();
       detected_landmarks_pub->publish(point_arr);
+      resources.count(detected_landmarks_count);
 
 
       // Publisher cluster markers
@@ -196,6 +450,7 @@ private:
       }
 
       cluster_pub->publish(cluster_marker_arr);
+      resources.count(cluster_count);
     }
   }
 };
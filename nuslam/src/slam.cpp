@@ -7,13 +7,68 @@
 ///     odom_id: The name of the odometry frame. Defaults to odom if not specified
 ///     wheel_left: The name of the left wheel joint
 ///     wheel_right: The name of the right wheel joint
+///     profile_period: log the duration and heap allocations of the landmark and timer
+///         callbacks every this many invocations, 0 to disable. Allocations are only
+///         counted when built with NUSLAM_TRACK_ALLOCATIONS
+///     allocation_budget: warn when a callback allocates more than this many times,
+///         -1 to disable
+///     realtime: run odometry (joint states and tf) and estimation (EKF) callbacks on
+///         their own threads with the real-time profile below (default false)
+///     lock_memory: with realtime, lock the memory of the process (default true)
+///     heap_reserve_mb: with realtime, megabytes of heap to prefault (default 64)
+///     odometry_priority, estimation_priority: with realtime, SCHED_FIFO priority of
+///         the odometry and estimation threads, 0 for the default scheduler
+///         (default 70 and 50)
+///     odometry_cpus, estimation_cpus: with realtime, CPUs each thread is pinned to,
+///         empty for any CPU (default [])
+///     latency_budget: the diagnostics warn when the 99th percentile of the time from
+///         scan acquisition to the publication of the resulting map -> odom_slam tf
+///         exceeds this many seconds
+///     update_budget: longest a landmark (or fake sensor) callback may run in seconds
+///         before it is reported as an overrun, 0 to disable (default 0.1)
+///     odometry_budget: longest a joint states or tf timer callback may run in seconds
+///         before it is reported as an overrun, 0 to disable (default 0.005)
+///     odometry_topic: if set, the odometry (nav_msgs/Odometry) of an odometry node to use
+///         instead of integrating /joint_states here. The odom -> body tf, /odom, and
+///         /odom/path are then left to that node (default "", integrate the joint states)
+///     gyro_weight: fraction of the heading change between joint states taken from the
+///         yaw rate on /imu instead of the wheels, 0 to ignore the gyro (default 0). Only
+///         used when the joint states are integrated here
+///     correction_time: seconds over which the map -> odom_slam tf moves to a new SLAM
+///         estimate, 0 to jump to it (default 0.2). Between estimates the SLAM pose is
+///         carried forward with the odometry
+///     resource_period: seconds between reports of the CPU time, memory, and message
+///         rates of the node on /diagnostics, 0 to disable (default 5.0)
+///     consider_distance: landmarks further than this many meters from the robot are
+///         consider states, which an EKF update uses but does not change, 0 to update every
+///         landmark (default 0)
+///     reorder_period: every this many EKF updates the landmarks of the state are sorted
+///         along a Morton curve through their positions, so nearby landmarks are near in
+///         memory, 0 to keep them in the order they were first seen (default 0)
+///     association_threads: threads the scoring of the detections of a scan against the
+///         map is split across, including the estimation thread, 1 to score them on the
+///         estimation thread alone (default 1). The associations do not depend on it. The
+///         workers run on the default scheduler, without the real-time profile
 /// PUBLISHES:
-///     /odom (nav_msgs/Odometry): odom information
-///     /odom/path (nav_msgs/Path): path taken by robot from odometry estimate
+///     /odom (nav_msgs/Odometry): odom information, unless odometry_topic is set
+///     /odom/path (nav_msgs/Path): path taken by robot from odometry estimate, unless
+///         odometry_topic is set
 ///     /slam/path (nav_msgs/Path): path taken by roobt from SLAM estimate
 ///     /slam/landmarks (visualization_msgs/MarkerArray): Estimated landmark locations from SLAM
+///     /slam/filter_stats (nuslam/FilterStats): map size, memory, stage durations, and data
+///         association outcomes of the EKF, after every update
+///     /slam/map_estimate (nuslam/MapEstimate): pose and landmark estimates with their
+///         marginal covariances, after every update while anything subscribes
+///     /diagnostics (diagnostic_msgs/DiagnosticArray): latency from scan acquisition to
+///         detection, EKF update, and tf publication, and the durations, overruns,
+///         lost messages, and queue depth of the callbacks, once per second; every
+///         callback overrun as it happens; and every resource_period the CPU time of the
+///         node and its threads, its memory, and the rates of its topics
 /// SUBSCRIBES:
-///		/joint_states (sensor_msgs/JointState): joint (wheel) states information
+///		/joint_states (sensor_msgs/JointState): joint (wheel) states information, unless
+///		    odometry_topic is set
+///		<odometry_topic> (nav_msgs/Odometry): odometry from an odometry node, if set
+///		/imu (sensor_msgs/Imu): yaw rate from a gyro, if gyro_weight is set
 ///		/detected_landmarks (nuslam/PointArray): landmark locations from circle fitting algorithm
 ///		/fake_sensor (visualization_msgs/MarkerArray): Markers representing fake sensed obstacles
 /// SERVICES:
@@ -22,8 +77,14 @@
 ///
 
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <fstream>
 #include <iostream>
 
@@ -35,8 +96,12 @@
 #include "geometry_msgs/msg/twist_with_covariance.hpp"
 #include "geometry_msgs/msg/transform_stamped.hpp"
 #include "geometry_msgs/msg/point.hpp"
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "diagnostic_msgs/msg/diagnostic_status.hpp"
+#include "diagnostic_msgs/msg/key_value.hpp"
 #include "nuturtlebot_msgs/msg/wheel_commands.hpp"
 #include "nuturtlebot_msgs/msg/sensor_data.hpp"
+#include "sensor_msgs/msg/imu.hpp"
 #include "sensor_msgs/msg/joint_state.hpp"
 #include "sensor_msgs/msg/laser_scan.hpp"
 #include "nav_msgs/msg/odometry.hpp"
@@ -48,13 +113,24 @@
 #include "tf2_ros/transform_broadcaster.h"
 #include "tf2_ros/static_transform_broadcaster.h"
 
+#include "nuslam/callback_watchdog.hpp"
 #include "nuslam/srv/initial_pose.hpp"
 
+#include "turtlelib/alloc_tracker.hpp"
+#include "turtlelib/benchmark.hpp"
 #include "turtlelib/diff_drive.hpp"
+#include "turtlelib/odometry.hpp"
 #include "turtlelib/kalman.hpp"
+#include "turtlelib/pose_extrapolator.hpp"
+#include "turtlelib/realtime.hpp"
+#include "turtlelib/resource_monitor.hpp"
+#include "turtlelib/resource_status.hpp"
+#include "turtlelib/watchdog.hpp"
 
 #include "armadillo"
 #include "nuslam/msg/point_array.hpp"
+#include "nuslam/msg/filter_stats.hpp"
+#include "nuslam/msg/map_estimate.hpp"
 
 using namespace std::chrono_literals;
 using std::placeholders::_1;
@@ -71,6 +147,25 @@ auto t0 = std::chrono::system_clock::now();
 
 // throttle the rate at which path messages are published
 constexpr unsigned int PATH_PUB_RATE = 100;
+
+/// latencies of one stage of the pipeline, in milliseconds since scan acquisition
+struct StageLatency
+{
+  turtlelib::SampleStats stats;
+  turtlelib::Histogram histogram{{10.0, 20.0, 50.0, 100.0, 200.0, 500.0, 1000.0}};
+
+  void add(double ms)
+  {
+    stats.add(ms);
+    histogram.add(ms);
+  }
+
+  void clear()
+  {
+    stats.clear();
+    histogram.clear();
+  }
+};
 /// @endcond
 
 /// @brief SLAM + Odometry node
@@ -89,11 +184,53 @@ public:
     declare_parameter("Q", Q);
     declare_parameter("R", R);
     declare_parameter("known_association", KNOWN_ASSOCIATION);
+    declare_parameter("profile_period", PROFILE_PERIOD);
+    declare_parameter("allocation_budget", ALLOCATION_BUDGET);
+    declare_parameter("latency_budget", LATENCY_BUDGET);
+    declare_parameter("update_budget", UPDATE_BUDGET);
+    declare_parameter("odometry_budget", ODOMETRY_BUDGET);
+    declare_parameter("correction_time", CORRECTION_TIME);
+    declare_parameter("resource_period", RESOURCE_PERIOD);
+    declare_parameter("consider_distance", CONSIDER_DISTANCE);
+    declare_parameter("reorder_period", REORDER_PERIOD);
+    declare_parameter("association_threads", ASSOCIATION_THREADS);
+    declare_parameter("odometry_topic", odometry_topic);
+    declare_parameter("gyro_weight", GYRO_WEIGHT);
+    declare_parameter("realtime", REALTIME);
+    declare_parameter("lock_memory", LOCK_MEMORY);
+    declare_parameter("heap_reserve_mb", HEAP_RESERVE_MB);
+    declare_parameter("odometry_priority", odometry_schedule.priority);
+    declare_parameter("estimation_priority", estimation_schedule.priority);
+    declare_parameter<std::vector<int64_t>>("odometry_cpus", std::vector<int64_t>{});
+    declare_parameter<std::vector<int64_t>>("estimation_cpus", std::vector<int64_t>{});
 
     // Get parameters
     Q = get_parameter("Q").get_value<double>();
     R = get_parameter("R").get_value<double>();
     KNOWN_ASSOCIATION = get_parameter("known_association").get_value<bool>();
+    PROFILE_PERIOD = get_parameter("profile_period").get_value<int>();
+    ALLOCATION_BUDGET = get_parameter("allocation_budget").get_value<int>();
+    LATENCY_BUDGET = get_parameter("latency_budget").get_value<double>();
+    UPDATE_BUDGET = get_parameter("update_budget").get_value<double>();
+    ODOMETRY_BUDGET = get_parameter("odometry_budget").get_value<double>();
+    CORRECTION_TIME = get_parameter("correction_time").get_value<double>();
+    RESOURCE_PERIOD = get_parameter("resource_period").get_value<double>();
+    CONSIDER_DISTANCE = get_parameter("consider_distance").get_value<double>();
+    REORDER_PERIOD = get_parameter("reorder_period").get_value<int>();
+    ASSOCIATION_THREADS = get_parameter("association_threads").get_value<int>();
+    odometry_topic = get_parameter("odometry_topic").get_value<std::string>();
+    GYRO_WEIGHT = get_parameter("gyro_weight").get_value<double>();
+    REALTIME = get_parameter("realtime").get_value<bool>();
+    LOCK_MEMORY = get_parameter("lock_memory").get_value<bool>();
+    HEAP_RESERVE_MB = get_parameter("heap_reserve_mb").get_value<int>();
+    odometry_schedule.priority = get_parameter("odometry_priority").get_value<int>();
+    estimation_schedule.priority = get_parameter("estimation_priority").get_value<int>();
+    for (const auto cpu : get_parameter("odometry_cpus").get_value<std::vector<int64_t>>()) {
+      odometry_schedule.cpus.push_back(cpu);
+    }
+    for (const auto cpu : get_parameter("estimation_cpus").get_value<std::vector<int64_t>>()) {
+      estimation_schedule.cpus.push_back(cpu);
+    }
     body_id = get_parameter("body_id").get_value<std::string>();
     odom_id = get_parameter("odom_id").get_value<std::string>();
     wheel_left = get_parameter("wheel_left").get_value<std::string>();
@@ -112,6 +249,62 @@ public:
       RCLCPP_ERROR_STREAM(get_logger(), "left_right parameter not specified");
       throw std::runtime_error("left_right parameter not specified");
     }
+    if (UPDATE_BUDGET < 0.0 or ODOMETRY_BUDGET < 0.0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "Callback budgets cannot be negative");
+      throw std::runtime_error("Callback budgets cannot be negative");
+    }
+    if (CONSIDER_DISTANCE < 0.0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "consider_distance cannot be negative");
+      throw std::runtime_error("consider_distance cannot be negative");
+    }
+    ekf.set_consider_distance(CONSIDER_DISTANCE);
+    if (REORDER_PERIOD < 0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "reorder_period cannot be negative");
+      throw std::runtime_error("reorder_period cannot be negative");
+    }
+    ekf.set_reorder_period(static_cast<size_t>(REORDER_PERIOD));
+    if (ASSOCIATION_THREADS < 1) {
+      RCLCPP_ERROR_STREAM(get_logger(), "association_threads must be at least 1");
+      throw std::runtime_error("association_threads must be at least 1");
+    }
+    ekf.set_association_threads(static_cast<size_t>(ASSOCIATION_THREADS));
+    if (CORRECTION_TIME < 0.0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "correction_time cannot be negative");
+      throw std::runtime_error("correction_time cannot be negative");
+    }
+    extrapolator.set_blend_time(CORRECTION_TIME);
+    if (GYRO_WEIGHT < 0.0 or GYRO_WEIGHT > 1.0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "gyro_weight must be between 0 and 1");
+      throw std::runtime_error("gyro_weight must be between 0 and 1");
+    }
+    wheel_odometry.set_gyro_weight(GYRO_WEIGHT);
+    if (RESOURCE_PERIOD < 0.0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "resource_period cannot be negative");
+      throw std::runtime_error("resource_period cannot be negative");
+    }
+
+    joint_states_watch = watchdog.add_callback(
+      odometry_topic.empty() ? "joint_states_callback" : "odometry_callback",
+      ODOMETRY_BUDGET * 1e6);
+    timer_watch = watchdog.add_callback("timer_callback", ODOMETRY_BUDGET * 1e6);
+    landmarks_watch = watchdog.add_callback(
+      KNOWN_ASSOCIATION ? "fake_sensor_callback" : "detected_landmarks_callback",
+      UPDATE_BUDGET * 1e6);
+
+    if (REALTIME) {
+      configure_process();
+    }
+
+    /// @brief odometry (joint states and tf) and estimation (EKF) callbacks, which run
+    /// on their own threads with the real-time profile, or on the default executor
+    odometry_group = create_callback_group(
+      rclcpp::CallbackGroupType::MutuallyExclusive, not REALTIME);
+    estimation_group = create_callback_group(
+      rclcpp::CallbackGroupType::MutuallyExclusive, not REALTIME);
+    rclcpp::SubscriptionOptions odometry_options;
+    odometry_options.callback_group = odometry_group;
+    rclcpp::SubscriptionOptions estimation_options;
+    estimation_options.callback_group = estimation_group;
 
     /// @brief Publisher to the odom topic
     odom_pub = create_publisher<nav_msgs::msg::Odometry>("odom", 10);
@@ -126,25 +319,70 @@ public:
     slam_marker_arr_pub = create_publisher<visualization_msgs::msg::MarkerArray>(
       "/slam/landmarks", 10);
 
-    /// @brief Subscriber to joint_states topic
-    joint_states_sub = create_subscription<sensor_msgs::msg::JointState>(
-      "/blue/joint_states", 10,
-      std::bind(&Slam::joint_states_callback, this, _1));
+    /// @brief Publishes the statistics of the EKF
+    filter_stats_pub = create_publisher<nuslam::msg::FilterStats>("/slam/filter_stats", 10);
+
+    /// @brief Publishes the estimates and marginal covariances, for exploration
+    map_estimate_pub = create_publisher<nuslam::msg::MapEstimate>("/slam/map_estimate", 10);
+
+    /// @brief Publishes the latency of the SLAM estimates as diagnostics
+    diagnostics_pub = create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
+
+    odom_count = resources.add_publisher("odom");
+    tf_count = resources.add_publisher("/tf");
+    slam_path_count = resources.add_publisher("/slam/path");
+    odom_path_count = resources.add_publisher("/odom/path");
+    slam_marker_arr_count = resources.add_publisher("/slam/landmarks");
+    filter_stats_count = resources.add_publisher("/slam/filter_stats");
+    map_estimate_count = resources.add_publisher("/slam/map_estimate");
+
+    /// @brief Subscriber to joint_states topic, or to the output of an odometry node so
+    /// that the joint states are only integrated once
+    if (odometry_topic.empty()) {
+      joint_states_count = resources.add_subscription("/blue/joint_states");
+      joint_states_sub = nuslam::create_watched_subscription<sensor_msgs::msg::JointState>(
+        *this, "/blue/joint_states", rclcpp::QoS(10),
+        std::bind(&Slam::joint_states_callback, this, _1), watchdog, joint_states_watch,
+        odometry_options);
+
+      /// @brief the yaw rate of the gyro, fused into the heading of the odometry
+      if (GYRO_WEIGHT > 0.0) {
+        imu_count = resources.add_subscription("/imu");
+        imu_sub = create_subscription<sensor_msgs::msg::Imu>(
+          "/imu", rclcpp::QoS(10), std::bind(&Slam::imu_callback, this, _1), odometry_options);
+      }
+    } else {
+      RCLCPP_INFO_STREAM(get_logger(), "Using the odometry on " << odometry_topic);
+      if (GYRO_WEIGHT > 0.0) {
+        RCLCPP_WARN_STREAM(
+          get_logger(), "gyro_weight is ignored, the odometry comes from " << odometry_topic);
+      }
+      joint_states_count = resources.add_subscription(odometry_topic);
+      odometry_sub = nuslam::create_watched_subscription<nav_msgs::msg::Odometry>(
+        *this, odometry_topic, rclcpp::QoS(10),
+        std::bind(&Slam::odometry_callback, this, _1), watchdog, joint_states_watch,
+        odometry_options);
+    }
 
     /// @brief subscription to the detected landmarks from circle fitting
     /// which is based on data from the lidar scanner (or fake lidar scanner)
     if (not KNOWN_ASSOCIATION) {
-      detected_landmarks_sub = create_subscription<nuslam::msg::PointArray>(
-        "/detected_landmarks", 10, std::bind(&Slam::detected_landmarks_callback, this, _1)
-      );
+      landmarks_count = resources.add_subscription("/detected_landmarks");
+      detected_landmarks_sub = nuslam::create_watched_subscription<nuslam::msg::PointArray>(
+        *this, "/detected_landmarks", rclcpp::QoS(10),
+        std::bind(&Slam::detected_landmarks_callback, this, _1), watchdog, landmarks_watch,
+        estimation_options);
     }
 
     /// @brief subscription to fake sensor for use with SLAM
     /// with known data association
     if (KNOWN_ASSOCIATION) {
       RCLCPP_INFO_STREAM(get_logger(), "Known data association, using fake sensor");
-      fake_sensor_sub = create_subscription<visualization_msgs::msg::MarkerArray>(
-        "/fake_sensor", 10, std::bind(&Slam::fake_sensor_callback, this, _1));
+      landmarks_count = resources.add_subscription("/fake_sensor");
+      fake_sensor_sub = nuslam::create_watched_subscription<visualization_msgs::msg::MarkerArray>(
+        *this, "/fake_sensor", rclcpp::QoS(10),
+        std::bind(&Slam::fake_sensor_callback, this, _1), watchdog, landmarks_watch,
+        estimation_options);
     }
 
     /// @brief initial pose service that sets the initial pose of the robot
@@ -161,7 +399,18 @@ public:
     /// \brief Timer (frequency defined by node parameter)
     _timer = create_wall_timer(
       std::chrono::milliseconds((int)(1000 / RATE)),
-      std::bind(&Slam::timer_callback, this));
+      std::bind(&Slam::timer_callback, this), odometry_group);
+
+    /// \brief Timer which publishes the diagnostics
+    diagnostics_timer = create_wall_timer(
+      1s, std::bind(&Slam::diagnostics_timer_callback, this));
+
+    /// \brief Timer which publishes the resources used by the node
+    if (RESOURCE_PERIOD > 0.0) {
+      resource_timer = create_wall_timer(
+        std::chrono::milliseconds((int)(1000 * RESOURCE_PERIOD)),
+        std::bind(&Slam::resource_timer_callback, this));
+    }
 
     // world -> map (static)
     world_map_tf.header.stamp = get_clock()->now();
@@ -186,13 +435,43 @@ public:
     odom_path_msg.header.frame_id = "odom";
   }
 
+  /// @brief returns true if the odometry and estimation callbacks run on their own
+  /// real-time threads
+  bool realtime() const
+  {
+    return REALTIME;
+  }
+
+  /// @brief returns the callback group of the joint states and tf callbacks
+  rclcpp::CallbackGroup::SharedPtr get_odometry_group() const
+  {
+    return odometry_group;
+  }
+
+  /// @brief returns the callback group of the EKF callbacks
+  rclcpp::CallbackGroup::SharedPtr get_estimation_group() const
+  {
+    return estimation_group;
+  }
+
+  /// @brief applies the odometry thread's priority and affinity to the calling thread
+  void configure_odometry_thread()
+  {
+    configure_thread(odometry_schedule, "Odometry");
+  }
+
+  /// @brief applies the estimation thread's priority and affinity to the calling thread
+  void configure_estimation_thread()
+  {
+    configure_thread(estimation_schedule, "Estimation");
+  }
+
 private:
   // Main timer callback frequency in Hz
   int RATE = 100;
 
   unsigned int count = 0;
   bool path_flag = true;
-  bool fake_sensor_flag = false;
 
   // Parameters that can be passed to the node
   bool KNOWN_ASSOCIATION = true;
@@ -202,21 +481,86 @@ private:
   std::string wheel_left;
   std::string wheel_right;
   std::string odom_id = "odom";
-
-  // KalmanFilter object
+  std::string odometry_topic;
+  int PROFILE_PERIOD = 0;
+  int ALLOCATION_BUDGET = -1;
+  double LATENCY_BUDGET = 0.2;
+  double UPDATE_BUDGET = 0.1;
+  double ODOMETRY_BUDGET = 0.005;
+  double CORRECTION_TIME = 0.2;
+  double CONSIDER_DISTANCE = 0.0;
+  int REORDER_PERIOD = 0;
+  int ASSOCIATION_THREADS = 1;
+  double RESOURCE_PERIOD = 5.0;
+  double GYRO_WEIGHT = 0.0;
+  bool REALTIME = false;
+  bool LOCK_MEMORY = true;
+  int HEAP_RESERVE_MB = 64;
+
+  // real-time profile
+  turtlelib::ThreadSchedule odometry_schedule{70, {}};
+  turtlelib::ThreadSchedule estimation_schedule{50, {}};
+  rclcpp::CallbackGroup::SharedPtr odometry_group;
+  rclcpp::CallbackGroup::SharedPtr estimation_group;
+
+  // guards the state shared by the odometry, estimation, and default callbacks:
+  // the odometry pose and twist, the extrapolator, the stamp of the current estimate,
+  // and the latency traces. It is held only to copy them, never while publishing
+  std::mutex state_mutex;
+
+  // duration and heap allocations of each callback invocation
+  turtlelib::CallbackProfile landmarks_profile;
+  turtlelib::CallbackProfile timer_profile;
+
+  // overruns, lost messages, and queue depth of each callback
+  turtlelib::CallbackWatchdog watchdog;
+  size_t joint_states_watch = 0;
+  size_t timer_watch = 0;
+  size_t landmarks_watch = 0;
+
+  // CPU time, memory, and message rates of the node
+  turtlelib::ResourceMonitor resources;
+  size_t joint_states_count = 0;
+  size_t imu_count = 0;
+  size_t landmarks_count = 0;
+  size_t odom_count = 0;
+  size_t tf_count = 0;
+  size_t slam_path_count = 0;
+  size_t odom_path_count = 0;
+  size_t slam_marker_arr_count = 0;
+  size_t filter_stats_count = 0;
+  size_t map_estimate_count = 0;
+
+  // stamp of the scan which produced the current estimate, and whether the
+  // map -> odom_slam tf computed from it still has to be published
+  rclcpp::Time estimate_scan_stamp{0, 0, RCL_ROS_TIME};
+  bool estimate_tf_pending = false;
+
+  // latency from scan acquisition to each stage since the last diagnostics
+  StageLatency detection_latency;
+  StageLatency update_latency;
+  StageLatency tf_latency;
+
+  // the traces being reported, swapped with the ones above so neither loses its memory
+  StageLatency detection_report;
+  StageLatency update_report;
+  StageLatency tf_report;
+
+  // KalmanFilter object and its estimates, only touched by the estimation callbacks
   turtlelib::KalmanFilter ekf{Q, R};
   arma::mat slam_pose_estimate = arma::mat(3, 1, arma::fill::zeros);
   arma::mat slam_map_estimate = arma::mat(3, 1, arma::fill::zeros);
   arma::mat slam_state_estimate = arma::mat(5, 1, arma::fill::zeros);
   std::vector<turtlelib::LandmarkMeasurement> landmarks;
 
-  // DiffDrive object
-  turtlelib::DiffDrive ddrive;
+  // map -> odom_slam from the SLAM estimates, which carries them forward with the odometry
+  turtlelib::PoseExtrapolator extrapolator;
+
+  // integrates the joint states, unless the odometry comes from odometry_topic
+  turtlelib::WheelOdometry wheel_odometry;
 
   // Current robot state
   turtlelib::Pose2D pose_now{0.0, 0.0, 0.0};
-  turtlelib::WheelState wheel_angles_now{0.0, 0.0};
-  turtlelib::WheelState wheel_speeds_now{0.0, 0.0};
   turtlelib::Twist2D Vb_now{0.0, 0.0, 0.0};
 
   // Declare messages
@@ -231,6 +575,8 @@ private:
 
   // Declare timer
   rclcpp::TimerBase::SharedPtr _timer;
+  rclcpp::TimerBase::SharedPtr diagnostics_timer;
+  rclcpp::TimerBase::SharedPtr resource_timer;
 
   // Declare transform broadcaster
   std::unique_ptr<tf2_ros::TransformBroadcaster> tf_broadcaster;
@@ -238,6 +584,8 @@ private:
 
   // Declare subscriptions
   rclcpp::Subscription<sensor_msgs::msg::JointState>::SharedPtr joint_states_sub;
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr odometry_sub;
+  rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr imu_sub;
   rclcpp::Subscription<nuslam::msg::PointArray>::SharedPtr detected_landmarks_sub;
   rclcpp::Subscription<visualization_msgs::msg::MarkerArray>::SharedPtr fake_sensor_sub;
 
@@ -246,6 +594,9 @@ private:
   rclcpp::Publisher<nav_msgs::msg::Path>::SharedPtr slam_path_pub;
   rclcpp::Publisher<nav_msgs::msg::Path>::SharedPtr odom_path_pub;
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr slam_marker_arr_pub;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub;
+  rclcpp::Publisher<nuslam::msg::FilterStats>::SharedPtr filter_stats_pub;
+  rclcpp::Publisher<nuslam::msg::MapEstimate>::SharedPtr map_estimate_pub;
 
   // Services
   rclcpp::Service<nuslam::srv::InitialPose>::SharedPtr _init_pose_service;
@@ -258,29 +609,119 @@ private:
     const std::shared_ptr<nuslam::srv::InitialPose::Request> request,
     std::shared_ptr<nuslam::srv::InitialPose::Response>)
   {
-    pose_now.x = request->x;
-    pose_now.y = request->y;
-    pose_now.theta = request->theta;
+    if (not odometry_topic.empty()) {
+      RCLCPP_WARN_STREAM(
+        get_logger(), "The odometry comes from " << odometry_topic <<
+          ", set its initial pose there instead");
+      return;
+    }
+    const std::lock_guard<std::mutex> lock(state_mutex);
+    wheel_odometry.set_pose(turtlelib::Pose2D{request->x, request->y, request->theta});
+    pose_now = wheel_odometry.pose();
+  }
+
+  /// @brief locks and prefaults the memory of the process, as far as it is permitted
+  void configure_process()
+  {
+    try {
+      if (LOCK_MEMORY) {
+        turtlelib::lock_memory();
+      }
+      turtlelib::reserve_heap(static_cast<size_t>(HEAP_RESERVE_MB) * 1024 * 1024);
+    } catch (const std::exception & e) {
+      RCLCPP_WARN_STREAM(get_logger(), "Real-time memory profile not applied: " << e.what());
+    }
+  }
+
+  /// @brief applies a schedule to the calling thread, warning if it is not permitted
+  void configure_thread(const turtlelib::ThreadSchedule & schedule, const std::string & name)
+  {
+    try {
+      turtlelib::apply_thread_schedule(schedule);
+    } catch (const std::exception & e) {
+      RCLCPP_WARN_STREAM(get_logger(), name << " thread keeps the default schedule: " << e.what());
+    }
   }
 
   void joint_states_callback(sensor_msgs::msg::JointState js_data)
   {
-    // Update velocities and positions of the wheels
-    wheel_angles_now.left = js_data.position.at(0);
-    wheel_angles_now.right = js_data.position.at(1);
-    wheel_speeds_now.left = js_data.velocity.at(0);
-    wheel_speeds_now.right = js_data.velocity.at(1);
+    resources.count(joint_states_count);
+    const rclcpp::Time stamp(js_data.header.stamp, RCL_ROS_TIME);
+    if (stamp.nanoseconds() > 0) {
+      watchdog.record_message(joint_states_watch, stamp.seconds(), get_clock()->now().seconds());
+    }
+    {
+      const turtlelib::CallbackWatchdog::Scope watch(watchdog, joint_states_watch);
+      update_odometry(js_data);
+    }
+    nuslam::publish_overruns(watchdog, get_name(), get_clock()->now(), *diagnostics_pub);
+  }
 
-    // Compute current body twist from given wheel velocities
-    Vb_now = ddrive.body_twist(wheel_speeds_now);
+  /// @brief integrates the wheel states into the odometry pose and twist
+  void update_odometry(const sensor_msgs::msg::JointState & js_data)
+  {
+    const std::lock_guard<std::mutex> lock(state_mutex);
+    wheel_odometry.update(
+      turtlelib::WheelState{js_data.position.at(0), js_data.position.at(1)},
+      turtlelib::WheelState{js_data.velocity.at(0), js_data.velocity.at(1)});
+    pose_now = wheel_odometry.pose();
+    Vb_now = wheel_odometry.twist();
+  }
 
-    // Update current pose of the robot with forward kinematics
-    pose_now = ddrive.forward_kinematics(pose_now, wheel_angles_now);
+  /// @brief integrates the yaw rate of the gyro until the next joint state
+  void imu_callback(const sensor_msgs::msg::Imu & imu)
+  {
+    resources.count(imu_count);
+    const std::lock_guard<std::mutex> lock(state_mutex);
+    wheel_odometry.add_gyro(
+      imu.angular_velocity.z, rclcpp::Time(imu.header.stamp, RCL_ROS_TIME).seconds());
+  }
+
+  /// @brief callback for the odometry of an odometry node, used instead of the joint states
+  void odometry_callback(const nav_msgs::msg::Odometry & odom)
+  {
+    resources.count(joint_states_count);
+    const rclcpp::Time stamp(odom.header.stamp, RCL_ROS_TIME);
+    if (stamp.nanoseconds() > 0) {
+      watchdog.record_message(joint_states_watch, stamp.seconds(), get_clock()->now().seconds());
+    }
+    {
+      const turtlelib::CallbackWatchdog::Scope watch(watchdog, joint_states_watch);
+      const auto & q = odom.pose.pose.orientation;
+      const std::lock_guard<std::mutex> lock(state_mutex);
+      pose_now.x = odom.pose.pose.position.x;
+      pose_now.y = odom.pose.pose.position.y;
+      pose_now.theta = std::atan2(
+        2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z));
+      Vb_now.thetadot = odom.twist.twist.angular.z;
+      Vb_now.xdot = odom.twist.twist.linear.x;
+      Vb_now.ydot = odom.twist.twist.linear.y;
+    }
+    nuslam::publish_overruns(watchdog, get_name(), get_clock()->now(), *diagnostics_pub);
   }
 
   /// @brief callback function for detected landmark centers
   /// from circle fitting/classification published by landmarks node
   void detected_landmarks_callback(const nuslam::msg::PointArray & point_arr)
+  {
+    resources.count(landmarks_count);
+    // detection_stamp is when the landmarks node published, so the age is the queueing
+    const rclcpp::Time detection_stamp(point_arr.detection_stamp, RCL_ROS_TIME);
+    if (detection_stamp.nanoseconds() > 0) {
+      watchdog.record_message(
+        landmarks_watch, detection_stamp.seconds(), get_clock()->now().seconds());
+    }
+    {
+      const turtlelib::CallbackWatchdog::Scope watch(watchdog, landmarks_watch);
+      const turtlelib::CallbackProfile::Sample sample(landmarks_profile);
+      update_from_detections(point_arr);
+    }
+    nuslam::publish_overruns(watchdog, get_name(), get_clock()->now(), *diagnostics_pub);
+    report_profile(landmarks_profile, "detected_landmarks_callback");
+  }
+
+  /// @brief runs the EKF with landmark centers detected by the landmarks node
+  void update_from_detections(const nuslam::msg::PointArray & point_arr)
   {
     // by not providing an id for the landmark, the EKF assumes an unknown data association
     std::vector<turtlelib::LandmarkMeasurement> measurements;
@@ -290,13 +731,28 @@ private:
       measurements.push_back(m); // vector of 1 measurement...should be reworked
     }
 
-    // Run the extended Kalman filter for these measurements
-    ekf.run(pose_now, Vb_now, measurements);
+    // Run the extended Kalman filter for these measurements, without holding the
+    // lock so the odometry keeps running
+    const auto [pose, Vb] = odometry_snapshot();
+    ekf.run(pose, Vb, measurements);
+    publish_filter_stats();
+    publish_map_estimate();
 
     // Store state prediction from SLAM
     slam_pose_estimate = ekf.pose_prediction();
     slam_map_estimate = ekf.map_prediction();
     slam_state_estimate = ekf.state_prediction();
+    {
+      const std::lock_guard<std::mutex> lock(state_mutex);
+      correct_extrapolator(pose);
+
+      const rclcpp::Time scan_stamp(point_arr.header.stamp, RCL_ROS_TIME);
+      if (scan_stamp.nanoseconds() > 0) {
+        const rclcpp::Time detection_stamp(point_arr.detection_stamp, RCL_ROS_TIME);
+        detection_latency.add((detection_stamp - scan_stamp).seconds() * 1e3);
+        record_estimate(scan_stamp);
+      }
+    }
 
     // fill and publish SLAM landmark markers
     fill_slam_marker_arr();
@@ -307,9 +763,25 @@ private:
   /// @brief callback for fake sensors for SLAM with known data association
   void fake_sensor_callback(const visualization_msgs::msg::MarkerArray & marker_arr)
   {
+    resources.count(landmarks_count);
+    if (not marker_arr.markers.empty()) {
+      watchdog.record_message(
+        landmarks_watch,
+        rclcpp::Time(marker_arr.markers.front().header.stamp, RCL_ROS_TIME).seconds(),
+        get_clock()->now().seconds());
+    }
+    {
+      const turtlelib::CallbackWatchdog::Scope watch(watchdog, landmarks_watch);
+      const turtlelib::CallbackProfile::Sample sample(landmarks_profile);
+      update_from_fake_sensor(marker_arr);
+    }
+    nuslam::publish_overruns(watchdog, get_name(), get_clock()->now(), *diagnostics_pub);
+    report_profile(landmarks_profile, "fake_sensor_callback");
+  }
 
-    fake_sensor_flag = true;
-
+  /// @brief runs the EKF with the fake sensor markers, whose ids are the landmark ids
+  void update_from_fake_sensor(const visualization_msgs::msg::MarkerArray & marker_arr)
+  {
     // store markers in a vector of turtlelib::LandmarkMeasurement's
     // passing a marker_id signifies to the EKF that the data association is known
     for (size_t i = 0; i < marker_arr.markers.size(); i++) {
@@ -319,13 +791,27 @@ private:
       landmarks.push_back(turtlelib::LandmarkMeasurement::from_cartesian(x, y, marker_id));
     }
 
-    // Run extended Kalman filter and update get the updated state estimate
-    ekf.run(pose_now, Vb_now, landmarks);
+    // Run extended Kalman filter and update get the updated state estimate, without
+    // holding the lock so the odometry keeps running
+    const auto [pose, Vb] = odometry_snapshot();
+    ekf.run(pose, Vb, landmarks);
+    landmarks.clear();
+    publish_filter_stats();
+    publish_map_estimate();
 
     // Store state estimate from SLAM
     slam_pose_estimate = ekf.pose_prediction();
     slam_map_estimate = ekf.map_prediction();
     slam_state_estimate = ekf.state_prediction();
+    {
+      const std::lock_guard<std::mutex> lock(state_mutex);
+      correct_extrapolator(pose);
+
+      // the fake sensor measures the landmarks directly, so there is no detection stage
+      if (not marker_arr.markers.empty()) {
+        record_estimate(rclcpp::Time(marker_arr.markers.front().header.stamp, RCL_ROS_TIME));
+      }
+    }
 
     // Saves the state estimate from the EKF to a csv file
     if (SAVE_TO_CSV) {
@@ -343,10 +829,180 @@ private:
       }
 
       odom_log_file << timestamp << ",";
-      odom_log_file << pose_now.theta << ",";
-      odom_log_file << pose_now.x << ",";
-      odom_log_file << pose_now.y << "\n";
+      odom_log_file << pose.theta << ",";
+      odom_log_file << pose.x << ",";
+      odom_log_file << pose.y << "\n";
+    }
+
+    // publish marker messages for map landmarks based on map_estimate
+    fill_slam_marker_arr();
+  }
+
+  /// @brief publishes the statistics of the EKF after an update
+  void publish_filter_stats()
+  {
+    const turtlelib::FilterStats & st = ekf.stats();
+    nuslam::msg::FilterStats msg;
+    msg.header.stamp = get_clock()->now();
+    msg.landmarks = st.landmarks;
+    msg.state_dimension = st.state_dimension;
+    msg.bytes = st.bytes;
+    msg.runs = st.runs;
+    msg.associate_us = st.last_associate_us;
+    msg.predict_us = st.last_predict_us;
+    msg.update_us = st.last_update_us;
+    msg.total_associate_us = st.total_associate_us;
+    msg.total_predict_us = st.total_predict_us;
+    msg.total_update_us = st.total_update_us;
+    msg.measurements = st.last_measurements;
+    msg.associated = st.last_associated;
+    msg.new_landmarks = st.last_new_landmarks;
+    msg.active_landmarks = st.last_active_landmarks;
+    msg.association_threads = st.last_association_threads;
+    msg.total_measurements = st.total_measurements;
+    msg.total_associated = st.total_associated;
+    msg.total_new_landmarks = st.total_new_landmarks;
+    filter_stats_pub->publish(msg);
+    resources.count(filter_stats_count);
+  }
+
+  /// @brief publishes the pose and landmark estimates with their marginal covariances.
+  /// Skipped without subscribers, since it copies the whole covariance
+  void publish_map_estimate()
+  {
+    if (map_estimate_pub->get_subscription_count() == 0) {
+      return;
+    }
+    const arma::mat pose = ekf.pose_prediction();
+    const arma::mat map = ekf.map_prediction();
+    const arma::mat sigma = ekf.covariance();
+
+    nuslam::msg::MapEstimate msg;
+    msg.header.stamp = get_clock()->now();
+    msg.header.frame_id = "map";
+    msg.pose.theta = pose(0, 0);
+    msg.pose.x = pose(1, 0);
+    msg.pose.y = pose(2, 0);
+    for (size_t r = 0; r < 3; r++) {
+      for (size_t c = 0; c < 3; c++) {
+        msg.pose_covariance.at(3 * r + c) = sigma(r, c);
+      }
+    }
+    const size_t n = map.n_rows / 2;
+    msg.landmarks.resize(n);
+    msg.landmark_covariances.resize(3 * n);
+    for (size_t i = 0; i < n; i++) {
+      const size_t j = 3 + 2 * i;
+      msg.landmarks.at(i).x = map(2 * i, 0);
+      msg.landmarks.at(i).y = map(2 * i + 1, 0);
+      msg.landmark_covariances.at(3 * i) = sigma(j, j);
+      msg.landmark_covariances.at(3 * i + 1) = sigma(j, j + 1);
+      msg.landmark_covariances.at(3 * i + 2) = sigma(j + 1, j + 1);
+    }
+    map_estimate_pub->publish(msg);
+    resources.count(map_estimate_count);
+  }
+
+  /// @brief returns the current odometry pose and body twist
+  std::tuple<turtlelib::Pose2D, turtlelib::Twist2D> odometry_snapshot()
+  {
+    const std::lock_guard<std::mutex> lock(state_mutex);
+    return {pose_now, Vb_now};
+  }
+
+  /// @brief hands the new SLAM pose, and the odometry pose it was computed from, to the
+  /// extrapolator, with state_mutex held
+  /// @param odom_pose the odometry pose passed to the EKF
+  void correct_extrapolator(const turtlelib::Pose2D & odom_pose)
+  {
+    const turtlelib::Pose2D map_pose{
+      slam_pose_estimate(1, 0), slam_pose_estimate(2, 0), slam_pose_estimate(0, 0)};
+    extrapolator.correct(map_pose, odom_pose, get_clock()->now().seconds());
+  }
+
+  /// @brief records the stamp of the scan behind a new estimate and its update latency,
+  /// with state_mutex held
+  void record_estimate(const rclcpp::Time & scan_stamp)
+  {
+    estimate_scan_stamp = scan_stamp;
+    estimate_tf_pending = true;
+    update_latency.add((get_clock()->now() - scan_stamp).seconds() * 1e3);
+  }
+
+  /// @brief publishes the latency of each stage since the last call as diagnostics
+  void diagnostics_timer_callback()
+  {
+    // take the traces and leave the cleared ones of the last report in their place,
+    // then report without the lock
+    {
+      const std::lock_guard<std::mutex> lock(state_mutex);
+      std::swap(detection_report, detection_latency);
+      std::swap(update_report, update_latency);
+      std::swap(tf_report, tf_latency);
     }
+
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.name = std::string(get_name()) + ": scan latency";
+    status.hardware_id = "slam";
+
+    const auto add_value = [&status](const std::string & key, const std::string & value) {
+        diagnostic_msgs::msg::KeyValue kv;
+        kv.key = key;
+        kv.value = value;
+        status.values.push_back(kv);
+      };
+    const auto add_stage = [&add_value](const std::string & name, const StageLatency & stage) {
+        add_value(name + " count", std::to_string(stage.stats.count()));
+        add_value(name + " p50 (ms)", std::to_string(stage.stats.percentile(50.0)));
+        add_value(name + " p99 (ms)", std::to_string(stage.stats.percentile(99.0)));
+        add_value(name + " max (ms)", std::to_string(stage.stats.max()));
+
+        // histogram buckets
+        const auto & edges = stage.histogram.edges();
+        const auto & counts = stage.histogram.counts();
+        for (size_t i = 0; i < edges.size(); i++) {
+          add_value(
+            name + " <= " + std::to_string(static_cast<int>(edges.at(i))) + " ms",
+            std::to_string(counts.at(i)));
+        }
+        add_value(
+          name + " > " + std::to_string(static_cast<int>(edges.back())) + " ms",
+          std::to_string(counts.back()));
+      };
+    add_stage("scan->detection", detection_report);
+    add_stage("scan->update", update_report);
+    add_stage("scan->tf", tf_report);
+
+    if (tf_report.stats.count() == 0) {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::STALE;
+      status.message = "No estimates since the last report";
+    } else if (tf_report.stats.percentile(99.0) > LATENCY_BUDGET * 1e3) {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+      status.message = "scan->tf latency over budget";
+    } else {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+      status.message = "OK";
+    }
+
+    diagnostic_msgs::msg::DiagnosticArray diagnostics;
+    diagnostics.header.stamp = get_clock()->now();
+    diagnostics.status.push_back(status);
+    diagnostics.status.push_back(nuslam::watchdog_status(watchdog, get_name()));
+    diagnostics_pub->publish(diagnostics);
+    watchdog.reset();
+
+    detection_report.clear();
+    update_report.clear();
+    tf_report.clear();
+  }
+
+  /// @brief publishes the resources used by the node since the last call as diagnostics
+  void resource_timer_callback()
+  {
+    diagnostic_msgs::msg::DiagnosticArray diagnostics;
+    diagnostics.header.stamp = get_clock()->now();
+    diagnostics.status.push_back(turtlelib::resource_status(resources.report(), get_name()));
+    diagnostics_pub->publish(diagnostics);
   }
 
   /// @brief fills in MarkerArray of landmarks based on SLAM estimation
@@ -383,6 +1039,7 @@ private:
     }
 
     slam_marker_arr_pub->publish(slam_marker_arr);
+    resources.count(slam_marker_arr_count);
   }
 
   /// @brief Publishes transforms for the odometry (blue) robot
@@ -420,7 +1077,8 @@ private:
     odom_blue_tf.transform.rotation.z = q_ob.z();
     odom_blue_tf.transform.rotation.w = q_ob.w();
 
-    if (path_flag) {
+    // the odometry node publishes its own path
+    if (path_flag and odometry_topic.empty()) {
       count = 0;
       geometry_msgs::msg::PoseStamped temp_pose;
       temp_pose.header.stamp = get_clock()->now();
@@ -436,6 +1094,7 @@ private:
       odom_path_msg.header.stamp = get_clock()->now();
       odom_path_msg.poses.push_back(temp_pose);
       odom_path_pub->publish(odom_path_msg);
+      resources.count(odom_path_count);
     }
   }
 
@@ -453,15 +1112,13 @@ private:
   /// which is useful for decreasing path publishing frequency for performance
   void map_to_slam_odom(const bool & path_flag)
   {
-    // Compute transforms between frames
-    const turtlelib::Vector2D vec_mb{slam_pose_estimate(1, 0), slam_pose_estimate(2, 0)};
-    const double angle_mb = slam_pose_estimate(0, 0);
-    const turtlelib::Transform2D T_MB(vec_mb, angle_mb);
-
-    const turtlelib::Vector2D vec_ob{pose_now.x, pose_now.y};
-    const turtlelib::Transform2D T_OB(vec_ob, pose_now.theta);
-
-    const turtlelib::Transform2D T_MO = T_MB * T_OB.inv();
+    // The SLAM estimate refers to the odometry pose it was computed from, so the
+    // odometry since then carries it forward to now, and a new estimate is blended in
+    const double now = get_clock()->now().seconds();
+    const turtlelib::Transform2D T_MO = extrapolator.map_to_odom(now);
+    const turtlelib::Pose2D pose_mb = extrapolator.predict(pose_now, now);
+    const turtlelib::Vector2D vec_mb{pose_mb.x, pose_mb.y};
+    const turtlelib::Transform2D T_MB(vec_mb, pose_mb.theta);
 
     // map -> odom_slam
     tf2::Quaternion q_mo;
@@ -491,11 +1148,49 @@ private:
       slam_path_msg.header.stamp = get_clock()->now();
       slam_path_msg.poses.push_back(path_pose);
       slam_path_pub->publish(slam_path_msg);
+      resources.count(slam_path_count);
     }
   }
 
+  /// @brief logs a callback profile once every PROFILE_PERIOD invocations
+  /// @param profile the profile of the callback
+  /// @param name the name of the callback
+  void report_profile(turtlelib::CallbackProfile & profile, const char * name)
+  {
+    if (PROFILE_PERIOD <= 0) {
+      profile.clear();
+      return;
+    }
+    if (profile.count() < static_cast<size_t>(PROFILE_PERIOD)) {
+      return;
+    }
+    RCLCPP_INFO_STREAM(get_logger(), profile.summary(name));
+    if (ALLOCATION_BUDGET >= 0 and
+      profile.allocations().max() > static_cast<double>(ALLOCATION_BUDGET))
+    {
+      RCLCPP_WARN_STREAM(
+        get_logger(), name << " allocated up to " << profile.allocations().max() <<
+          " times per call, over the budget of " << ALLOCATION_BUDGET);
+    }
+    profile.clear();
+  }
+
   void timer_callback()
   {
+    {
+      const turtlelib::CallbackWatchdog::Scope watch(watchdog, timer_watch);
+      const turtlelib::CallbackProfile::Sample sample(timer_profile);
+      publish_estimates();
+    }
+    nuslam::publish_overruns(watchdog, get_name(), get_clock()->now(), *diagnostics_pub);
+    report_profile(timer_profile, "timer_callback");
+  }
+
+  /// @brief publishes the odometry and SLAM transforms, paths, and landmarks
+  void publish_estimates()
+  {
+    const std::lock_guard<std::mutex> lock(state_mutex);
+
     // throttle the path publishing for performance
     if (count > PATH_PUB_RATE) {
       path_flag = true;
@@ -510,21 +1205,26 @@ private:
     odom_to_blue(path_flag);
     map_to_slam_odom(path_flag);
 
-    // send transforms
-    tf_broadcaster->sendTransform(odom_blue_tf);
+    // send transforms, leaving odom -> body to the odometry node if there is one
+    if (odometry_topic.empty()) {
+      tf_broadcaster->sendTransform(odom_blue_tf);
+      resources.count(tf_count);
+    }
     tf_broadcaster->sendTransform(odom_green_tf);
     tf_broadcaster->sendTransform(map_odom_tf);
+    resources.count(tf_count);
+    resources.count(tf_count);
 
-    // publish odometry msg
-    odom_pub->publish(odom_msg);
-
-    if (fake_sensor_flag) {
-      fake_sensor_flag = false;
-
-      // publish marker messages for map landmarks based on map_estimate
-      fill_slam_marker_arr();
+    // the first map -> odom_slam tf computed from a new estimate ends its trace
+    if (estimate_tf_pending) {
+      estimate_tf_pending = false;
+      tf_latency.add((get_clock()->now() - estimate_scan_stamp).seconds() * 1e3);
+    }
 
-      landmarks.clear();
+    // publish odometry msg
+    if (odometry_topic.empty()) {
+      odom_pub->publish(odom_msg);
+      resources.count(odom_count);
     }
   }
 };
@@ -539,7 +1239,39 @@ int main(int argc, char * argv[])
   }
 
   rclcpp::init(argc, argv);
-  rclcpp::spin(std::make_shared<Slam>());
+  const auto node = std::make_shared<Slam>();
+
+  // with the real-time profile the odometry and estimation callbacks get their own threads
+  rclcpp::executors::SingleThreadedExecutor odometry_executor;
+  rclcpp::executors::SingleThreadedExecutor estimation_executor;
+  std::thread odometry_thread;
+  std::thread estimation_thread;
+  if (node->realtime()) {
+    odometry_executor.add_callback_group(
+      node->get_odometry_group(), node->get_node_base_interface());
+    estimation_executor.add_callback_group(
+      node->get_estimation_group(), node->get_node_base_interface());
+    odometry_thread = std::thread(
+      [&node, &odometry_executor]() {
+        node->configure_odometry_thread();
+        odometry_executor.spin();
+      });
+    estimation_thread = std::thread(
+      [&node, &estimation_executor]() {
+        node->configure_estimation_thread();
+        estimation_executor.spin();
+      });
+  }
+
+  rclcpp::spin(node);
+  odometry_executor.cancel();
+  estimation_executor.cancel();
+  if (odometry_thread.joinable()) {
+    odometry_thread.join();
+  }
+  if (estimation_thread.joinable()) {
+    estimation_thread.join();
+  }
   rclcpp::shutdown();
 
   slam_log_file.close();   // may be problamatic in the event that the node crashes and we don't get here?
@@ -1,5 +1,8 @@
 #include <catch2/catch_test_macros.hpp>
+#include <cmath>
 #include <future>
+#include <random>
+#include <turtlelib/lidar.hpp>
 #include <turtlelib/rigid2d.hpp>
 #include <vector>
 #include "nuslam/circle_fitting.hpp"
@@ -107,6 +110,69 @@ TEST_CASE("fit_circle()")
 }
 
 
+TEST_CASE("cluster_scan()")
+{
+  // two groups of returns, and a single stray return
+  std::vector<float> ranges(360, 0.0f);
+  for (size_t i = 10; i < 15; i++) {
+    ranges.at(i) = 1.0f;
+  }
+  for (size_t i = 100; i < 106; i++) {
+    ranges.at(i) = 0.5f;
+  }
+  ranges.at(200) = 2.0f;
+
+  auto clusters = cluster_scan(ranges, 0.0, turtlelib::deg2rad(1.0), 4);
+  REQUIRE(clusters.size() == 2);
+  REQUIRE(clusters.at(0).count() == 5);
+  REQUIRE(clusters.at(1).count() == 6);
+
+  clusters = cluster_scan(ranges, 0.0, turtlelib::deg2rad(1.0), 1);
+  REQUIRE(clusters.size() == 3);
+
+  // returns one degree apart at 1m are 0.017m apart, too far for a tight threshold
+  clusters = cluster_scan(ranges, 0.0, turtlelib::deg2rad(1.0), 4, 0.01);
+  REQUIRE(clusters.size() == 1);
+  REQUIRE(clusters.at(0).count() == 6);
+}
+
+TEST_CASE("detect_circles()")
+{
+  // a landmark 0.4m straight ahead and a wall to the left
+  std::vector<float> ranges(360, 0.0f);
+  turtlelib::LidarParams lidar;
+  std::mt19937 rng(0);
+  turtlelib::simulate_lidar(
+    turtlelib::Pose2D{0.0, 0.0, 0.0}, {Vector2D{0.4, 0.0}}, 0.038, lidar, rng, ranges);
+  for (size_t i = 80; i < 100; i++) {
+    ranges.at(i) = static_cast<float>(1.0 / std::sin(turtlelib::deg2rad(i)));
+  }
+
+  DetectorParams params;
+  auto centers = detect_circles(ranges, 0.0, lidar.angle_increment, params);
+  REQUIRE(centers.size() == 1);
+  REQUIRE(turtlelib::distance(centers.at(0), Vector2D{0.4, 0.0}) < 0.01);
+
+  // the same from the clusters, which the landmarks node also publishes
+  auto clusters = cluster_scan(
+    ranges, 0.0, lidar.angle_increment, params.min_cluster_size, params.cluster_threshold);
+  const auto from_clusters = detect_circles(clusters, params);
+  REQUIRE(from_clusters.size() == 1);
+  REQUIRE(turtlelib::distance(from_clusters.at(0), centers.at(0)) == 0.0);
+
+  // a cluster the circle cannot be fit to is skipped
+  Cluster line(Vector2D{1.0, 0.0});
+  line.blind_add(Vector2D{1.0, 0.01});
+  clusters.push_back(line);
+  REQUIRE_NOTHROW(centers = detect_circles(clusters, params));
+  REQUIRE(centers.size() == 1);
+
+  // the landmark spans fewer beams than the minimum cluster size
+  params.min_cluster_size = 20;
+  centers = detect_circles(ranges, 0.0, lidar.angle_increment, params);
+  REQUIRE(centers.empty());
+}
+
 //
 //
 // NOTE: Previously passed these tests before making these
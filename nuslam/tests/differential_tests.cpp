@@ -0,0 +1,156 @@
+/// \file
+/// \brief Differential tests: fit_circle is run side by side with a frozen reference
+/// implementation of the same hyperaccurate algebraic fit on random arcs. The reference
+/// takes a different numerical route (eigendecomposition of Z^T Z instead of the SVD
+/// of Z) so a change to either the math or its numerics shows up as a disagreement.
+
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <tuple>
+#include <vector>
+#include <turtlelib/rigid2d.hpp>
+#include "nuslam/circle_fitting.hpp"
+
+using turtlelib::Vector2D;
+
+namespace
+{
+
+/// Hyperaccurate circle fit straight from the derivation: A minimizes A^T M A
+/// subject to A^T H A = 1, found through Y = (Z^T Z)^(1/2)
+std::tuple<Vector2D, double> reference_fit(const std::vector<Vector2D> & points)
+{
+  const size_t n = points.size();
+  Vector2D c{0.0, 0.0};
+  for (const auto & p : points) {
+    c.x += p.x / n;
+    c.y += p.y / n;
+  }
+
+  arma::mat Z(n, 4, arma::fill::ones);
+  double z_bar = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    const double x = points.at(i).x - c.x;
+    const double y = points.at(i).y - c.y;
+    Z(i, 0) = x * x + y * y;
+    Z(i, 1) = x;
+    Z(i, 2) = y;
+    z_bar += Z(i, 0) / n;
+  }
+
+  const arma::mat ZtZ = Z.t() * Z;
+  arma::vec lambda;
+  arma::mat E;
+  arma::eig_sym(lambda, E, ZtZ);
+
+  arma::vec A;
+  if (std::sqrt(std::max(lambda(0), 0.0)) < 10e-12) {
+    // the points lie exactly on a circle
+    A = E.col(0);
+  } else {
+    arma::mat sqrt_lambda(4, 4, arma::fill::zeros);
+    for (size_t i = 0; i < 4; i++) {
+      sqrt_lambda(i, i) = std::sqrt(lambda(i));
+    }
+    const arma::mat Y = E * sqrt_lambda * E.t();
+
+    arma::mat Hinv(4, 4, arma::fill::eye);
+    Hinv(0, 0) = 0.0;
+    Hinv(3, 3) = -2.0 * z_bar;
+    Hinv(0, 3) = 0.5;
+    Hinv(3, 0) = 0.5;
+
+    arma::vec eta;
+    arma::mat W;
+    arma::eig_sym(eta, W, arma::mat(Y * Hinv * Y));
+    size_t k = 0;
+    while (eta(k) <= 0.0) {
+      k++;
+    }
+    A = arma::solve(Y, arma::vec(W.col(k)));
+  }
+
+  const double a = -A(1) / (2.0 * A(0)) + c.x;
+  const double b = -A(2) / (2.0 * A(0)) + c.y;
+  const double R = std::sqrt(
+    (A(1) * A(1) + A(2) * A(2) - 4.0 * A(0) * A(3)) / (4.0 * A(0) * A(0)));
+  return {Vector2D{a, b}, R};
+}
+
+struct Arc
+{
+  Vector2D center;
+  double radius;
+  std::vector<Vector2D> points;
+};
+
+/// points on an arc of a random circle, as a lidar would see the near side of an obstacle
+Arc random_arc(std::mt19937 & rng, double noise)
+{
+  std::uniform_real_distribution<> center_d(-2.0, 2.0);
+  std::uniform_real_distribution<> radius_d(0.02, 0.5);
+  std::uniform_real_distribution<> start_d(-turtlelib::PI, turtlelib::PI);
+  std::uniform_real_distribution<> span_d(turtlelib::PI / 4.0, turtlelib::PI);
+  std::uniform_int_distribution<> count_d(4, 40);
+  std::normal_distribution<> noise_d(0.0, 1.0);
+
+  const Vector2D center{center_d(rng), center_d(rng)};
+  const double radius = radius_d(rng);
+  const double start = start_d(rng);
+  const double span = span_d(rng);
+  const int count = count_d(rng);
+
+  Arc arc{center, radius, {}};
+  for (int i = 0; i < count; i++) {
+    const double angle = start + span * i / (count - 1);
+    arc.points.push_back(
+      Vector2D{center.x + radius * std::cos(angle) + noise * noise_d(rng),
+        center.y + radius * std::sin(angle) + noise * noise_d(rng)});
+  }
+  return arc;
+}
+
+constexpr double TOLERANCE = 1e-6;
+
+/// without noise the generating circle is the reference, since the smallest singular
+/// value of Z is only zero up to rounding and the two routes may pick different branches
+void check_agreement(double noise, uint32_t seed)
+{
+  std::mt19937 rng{seed};
+  for (int trial = 0; trial < 200; trial++) {
+    const Arc arc = random_arc(rng, noise);
+    const auto & points = arc.points;
+    Cluster cluster;
+    for (const auto & p : points) {
+      cluster.blind_add(p);
+    }
+
+    const auto [center, radius] = fit_circle(cluster);
+    const auto [ref_center, ref_radius] =
+      noise > 0.0 ? reference_fit(points) : std::make_tuple(arc.center, arc.radius);
+
+    INFO("seed " << seed << ", trial " << trial << ", " << points.size() << " points");
+    const double scale = std::max(1.0, ref_radius);
+    REQUIRE(std::abs(center.x - ref_center.x) / scale < TOLERANCE);
+    REQUIRE(std::abs(center.y - ref_center.y) / scale < TOLERANCE);
+    REQUIRE(std::abs(radius - ref_radius) / scale < TOLERANCE);
+  }
+}
+
+}
+
+TEST_CASE("fit_circle matches reference on noisy arcs", "[differential]")
+{
+  for (uint32_t seed = 0; seed < 5; seed++) {
+    check_agreement(1e-3, seed);
+  }
+}
+
+TEST_CASE("fit_circle recovers exact arcs", "[differential]")
+{
+  for (uint32_t seed = 0; seed < 5; seed++) {
+    check_agreement(0.0, seed);
+  }
+}
@@ -6,8 +6,12 @@
 ///     odom_id: The name of the odometry frame. Defaults to odom if not specified
 ///     wheel_left: The name of the left wheel joint
 ///     wheel_right: The name of the right wheel joint
+///     resource_period: seconds between reports of the CPU time, memory, and message
+///         rates of the node on /diagnostics, 0 to disable (default 5.0)
 /// PUBLISHES:
 ///     /odom (nav_msgs::msg::Odometry): odom information
+///     /diagnostics (diagnostic_msgs::msg::DiagnosticArray): CPU time of the node and its
+///         threads, its memory, and the rates of its topics, every resource_period
 /// SUBSCRIBES:
 ///		/joint_states (sensor_msgs::msg::JointStat): joint (wheel) states information
 /// SERVICES:
@@ -26,7 +30,10 @@
 #include "geometry_msgs/msg/twist_with_covariance.hpp"
 #include "nuturtlebot_msgs/msg/wheel_commands.hpp"
 #include "nuturtlebot_msgs/msg/sensor_data.hpp"
-#include "turtlelib/diff_drive.hpp"
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "turtlelib/odometry.hpp"
+#include "turtlelib/resource_monitor.hpp"
+#include "turtlelib/resource_status.hpp"
 #include "sensor_msgs/msg/joint_state.hpp"
 #include "nav_msgs/msg/odometry.hpp"
 #include "nav_msgs/msg/path.hpp"
@@ -53,10 +60,12 @@ public:
     declare_parameter("odom_id", odom_id);
     declare_parameter("wheel_left", wheel_left);
     declare_parameter("wheel_right", wheel_right);
+    declare_parameter("resource_period", RESOURCE_PERIOD);
     body_id = get_parameter("body_id").get_value<std::string>();
     odom_id = get_parameter("odom_id").get_value<std::string>();
     wheel_left = get_parameter("wheel_left").get_value<std::string>();
     wheel_right = get_parameter("wheel_right").get_value<std::string>();
+    RESOURCE_PERIOD = get_parameter("resource_period").get_value<double>();
 
     // throw runtime error if parameters are undefined
     if (body_id.empty()) {
@@ -71,6 +80,10 @@ public:
       RCLCPP_ERROR_STREAM(get_logger(), "left_right parameter not specified");
       throw std::runtime_error("left_right parameter not specified");
     }
+    if (RESOURCE_PERIOD < 0.0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "resource_period cannot be negative");
+      throw std::runtime_error("resource_period cannot be negative");
+    }
 
     /// @brief Publisher to the odom topic
     odom_pub = create_publisher<nav_msgs::msg::Odometry>("odom", 10);
@@ -79,6 +92,14 @@ public:
     path_pub = create_publisher<nav_msgs::msg::Path>(
       "/odom/path", 10);
 
+    /// @brief publishes the resources used by the node
+    diagnostics_pub = create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
+
+    joint_states_count = resources.add_subscription("/blue/joint_states");
+    odom_count = resources.add_publisher("odom");
+    tf_count = resources.add_publisher("/tf");
+    path_count = resources.add_publisher("/odom/path");
+
     /// @brief Subscriber to joint_states topic
     joint_states_sub = create_subscription<sensor_msgs::msg::JointState>(
       "/blue/joint_states", 10,
@@ -96,10 +117,18 @@ public:
     _timer = create_wall_timer(
       std::chrono::milliseconds((int)(1000 / RATE)),
       std::bind(&Odometry::timer_callback, this));
+
+    /// \brief Timer which reports the resources used by the node
+    if (RESOURCE_PERIOD > 0.0) {
+      resource_timer = create_wall_timer(
+        std::chrono::milliseconds((int)(1000 * RESOURCE_PERIOD)),
+        std::bind(&Odometry::resource_timer_callback, this));
+    }
   }
 
 private:
   int RATE = 200;
+  double RESOURCE_PERIOD = 5.0;
 
   // Parameters that can be passed to the node
   std::string body_id;
@@ -108,16 +137,17 @@ private:
   std::string odom_id = "odom";
   int count = 0;
 
-  // DiffDrive object
-  turtlelib::DiffDrive ddrive;
-
-  // Current robot state
-  turtlelib::Pose2D pose_now{0.0, 0.0, 0.0};
-  turtlelib::WheelState wheel_angles_now{0.0, 0.0};
-  turtlelib::WheelState wheel_speeds_now{0.0, 0.0};
-  turtlelib::Twist2D Vb_now{0.0, 0.0, 0.0};
+  // integrates the joint states into the pose and twist of the robot
+  turtlelib::WheelOdometry odometry;
   tf2::Quaternion q;
 
+  // CPU time, memory, and message rates of the node
+  turtlelib::ResourceMonitor resources;
+  size_t joint_states_count = 0;
+  size_t odom_count = 0;
+  size_t tf_count = 0;
+  size_t path_count = 0;
+
   // Declare messages
   nav_msgs::msg::Odometry odom_msg;
   geometry_msgs::msg::TransformStamped odom_body_tf;
@@ -125,6 +155,7 @@ private:
 
   // Declare timer
   rclcpp::TimerBase::SharedPtr _timer;
+  rclcpp::TimerBase::SharedPtr resource_timer;
 
   // Declare transform broadcaster
   std::unique_ptr<tf2_ros::TransformBroadcaster> tf_broadcaster;
@@ -135,6 +166,7 @@ private:
   // Declare publishers
   rclcpp::Publisher<nav_msgs::msg::Odometry>::SharedPtr odom_pub;
   rclcpp::Publisher<nav_msgs::msg::Path>::SharedPtr path_pub;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub;
 
   // Services
   rclcpp::Service<nuturtle_control::srv::InitialPose>::SharedPtr _init_pose_service;
@@ -147,28 +179,24 @@ private:
     const std::shared_ptr<nuturtle_control::srv::InitialPose::Request> request,
     std::shared_ptr<nuturtle_control::srv::InitialPose::Response>)
   {
-    pose_now.x = request->x;
-    pose_now.y = request->y;
-    pose_now.theta = request->theta;
+    odometry.set_pose(turtlelib::Pose2D{request->x, request->y, request->theta});
   }
 
   void joint_states_callback(sensor_msgs::msg::JointState js_data)
   {
-    // Update velocities and positions of the wheels
-    wheel_angles_now.left = js_data.position.at(0);
-    wheel_angles_now.right = js_data.position.at(1);
-    wheel_speeds_now.left = js_data.velocity.at(0);
-    wheel_speeds_now.right = js_data.velocity.at(1);
-
-    // Compute current body twist from given wheel velocities
-    Vb_now = ddrive.body_twist(wheel_speeds_now);
+    resources.count(joint_states_count);
 
-    // Update current pose of the robot with forward kinematics
-    pose_now = ddrive.forward_kinematics(pose_now, wheel_angles_now);
+    // Update the pose and body twist from the positions and velocities of the wheels
+    odometry.update(
+      turtlelib::WheelState{js_data.position.at(0), js_data.position.at(1)},
+      turtlelib::WheelState{js_data.velocity.at(0), js_data.velocity.at(1)});
   }
 
   void timer_callback()
   {
+    const turtlelib::Pose2D pose_now = odometry.pose();
+    const turtlelib::Twist2D Vb_now = odometry.twist();
+
     // Define quaternion for current rotation
     q.setRPY(0.0, 0.0, pose_now.theta);
 
@@ -200,6 +228,8 @@ private:
     // publish odometry on /odom and transform on /tf
     tf_broadcaster->sendTransform(odom_body_tf);
     odom_pub->publish(odom_msg);
+    resources.count(tf_count);
+    resources.count(odom_count);
 
     constexpr int PATH_PUB_RATE = 100;
     if (count >= PATH_PUB_RATE) {
@@ -218,10 +248,21 @@ private:
       path_msg.header.stamp = get_clock()->now();
       path_msg.poses.push_back(temp_pose);
       path_pub->publish(path_msg);
+      resources.count(path_count);
     } else {
       count++;
     }
   }
+
+  /// @brief publishes the CPU time, memory, and message rates of the node since the
+  /// last call as diagnostics
+  void resource_timer_callback()
+  {
+    diagnostic_msgs::msg::DiagnosticArray diagnostics;
+    diagnostics.header.stamp = get_clock()->now();
+    diagnostics.status.push_back(turtlelib::resource_status(resources.report(), get_name()));
+    diagnostics_pub->publish(diagnostics);
+  }
 };
 
 /// @brief the main function to run the odometry node
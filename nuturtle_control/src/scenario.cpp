@@ -0,0 +1,138 @@
+/// \file
+/// \brief scenario node: replays a scripted mission on cmd_vel, stepped by the simulator
+///
+/// The mission is read from a scenario file (see turtlelib/scenario.hpp). Instead of a
+/// wall timer, the node publishes a new command for every simulation timestep, using
+/// the simulated time since the first timestep it receives. Together with a fixed nusim
+/// seed, every run drives the same trajectory regardless of the load on the machine.
+///
+/// PARAMETERS:
+///     scenario_file (string): path to the scenario file to replay
+///     sim_rate (int): rate of the nusim timestep in Hz, used to convert timesteps to time
+/// PUBLISHES:
+///     /cmd_vel (geometry_msgs/msg/Twist): the commanded twist of the scenario
+///     ~/done (std_msgs/msg/Bool): true once the whole scenario has been replayed
+/// SUBSCRIBES:
+///     /nusim/timestep (std_msgs/msg/UInt64): the simulation timestep
+/// SERVICES:
+///     None
+/// CLIENTS:
+///     None
+
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "rclcpp/logging.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "turtlelib/scenario.hpp"
+
+#include "geometry_msgs/msg/twist.hpp"
+#include "std_msgs/msg/bool.hpp"
+#include "std_msgs/msg/u_int64.hpp"
+
+using std::placeholders::_1;
+
+/// \brief replays a scenario file one simulation timestep at a time
+class ScenarioDriver : public rclcpp::Node
+{
+
+public:
+  ScenarioDriver()
+  : Node("scenario")
+  {
+    declare_parameter<std::string>("scenario_file", "");
+    declare_parameter<int>("sim_rate", SIM_RATE);
+    const auto scenario_file = get_parameter("scenario_file").get_value<std::string>();
+    SIM_RATE = get_parameter("sim_rate").get_value<int>();
+
+    if (scenario_file.empty()) {
+      RCLCPP_ERROR_STREAM(get_logger(), "scenario_file parameter missing");
+      throw std::runtime_error("scenario_file parameter missing");
+    }
+    if (SIM_RATE <= 0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "sim_rate must be positive");
+      throw std::runtime_error("sim_rate must be positive");
+    }
+
+    std::ifstream file(scenario_file);
+    if (not file) {
+      RCLCPP_ERROR_STREAM(get_logger(), "Unable to open " << scenario_file);
+      throw std::runtime_error("Unable to open " + scenario_file);
+    }
+    try {
+      scenario = turtlelib::parse_scenario(file);
+    } catch (const std::runtime_error & e) {
+      RCLCPP_ERROR_STREAM(get_logger(), e.what());
+      throw;
+    }
+    RCLCPP_INFO_STREAM(
+      get_logger(), "Loaded " << scenario.get_steps().size() << " steps lasting " <<
+        scenario.duration() << " s from " << scenario_file);
+
+    /// @brief Publisher to cmd_vel topic
+    cmd_vel_pub = create_publisher<geometry_msgs::msg::Twist>("cmd_vel", 10);
+
+    /// @brief Publisher which signals the end of the scenario
+    done_pub = create_publisher<std_msgs::msg::Bool>("~/done", 10);
+
+    /// @brief subscription to the simulation timestep, which drives the scenario
+    timestep_sub = create_subscription<std_msgs::msg::UInt64>(
+      "nusim/timestep", 10, std::bind(&ScenarioDriver::timestep_callback, this, _1));
+  }
+
+private:
+  int SIM_RATE = 200;
+  turtlelib::Scenario scenario;
+
+  // timestep at which the scenario started
+  bool started = false;
+  uint64_t first_step = 0;
+  bool done = false;
+
+  // Publishers
+  rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr cmd_vel_pub;
+  rclcpp::Publisher<std_msgs::msg::Bool>::SharedPtr done_pub;
+
+  // Subscribers
+  rclcpp::Subscription<std_msgs::msg::UInt64>::SharedPtr timestep_sub;
+
+  /// @brief publishes the twist the scenario commands at the current simulated time
+  void timestep_callback(const std_msgs::msg::UInt64 & msg)
+  {
+    if (done) {
+      return;
+    }
+    if (not started) {
+      started = true;
+      first_step = msg.data;
+    }
+
+    const double t = static_cast<double>(msg.data - first_step) / SIM_RATE;
+    const turtlelib::Twist2D V = scenario.twist_at(t);
+
+    geometry_msgs::msg::Twist twist_msg;
+    twist_msg.linear.x = V.xdot;
+    twist_msg.linear.y = V.ydot;
+    twist_msg.angular.z = V.thetadot;
+    cmd_vel_pub->publish(twist_msg);
+
+    if (t >= scenario.duration()) {
+      done = true;
+      std_msgs::msg::Bool done_msg;
+      done_msg.data = true;
+      done_pub->publish(done_msg);
+      RCLCPP_INFO_STREAM(get_logger(), "Scenario complete");
+    }
+  }
+};
+
+/// @brief the main function to run the scenario node
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<ScenarioDriver>());
+  rclcpp::shutdown();
+  return 0;
+}
@@ -7,9 +7,24 @@
 ///     motor_cmd_max (int): motors are provided commands on the interval [-motor_cmd_max, motor_cmd_max]
 ///     motor_cmd_per_rad_sec (double): Equivalent speed in rad/s for each motor command "tick"
 ///     encoder_ticks_per_rad (double): number of encoder ticks per radian
+///     rate (int): rate at which joint states are published in Hz
+///     realtime (bool): run the control callbacks on their own thread with the real-time
+///       profile below (default false)
+///     lock_memory (bool): with realtime, lock the memory of the process (default true)
+///     heap_reserve_mb (int): with realtime, megabytes of heap to prefault (default 32)
+///     control_priority (int): with realtime, SCHED_FIFO priority of the control
+///       thread, 0 for the default scheduler (default 80)
+///     control_cpus (int[]): with realtime, CPUs the control thread is pinned to,
+///       empty for any CPU (default [])
+///     jitter_report_period (int): log the jitter of the joint states timer every this
+///       many ticks, 0 to disable (default 0)
+///     resource_period (double): seconds between reports of the CPU time, memory, and
+///       message rates of the node on /diagnostics, 0 to disable (default 5.0)
 /// PUBLISHES:
 ///     /wheel_cmd (nuturtlebot_msgs::msg::WheelCommands): commanded value sent to the wheels
 ///     /joint_states (sensor_msgs::msg::JointState): wheel speeds and angles
+///     /diagnostics (diagnostic_msgs::msg::DiagnosticArray): CPU time of the node and its
+///       threads, its memory, and the rates of its topics, every resource_period
 /// SUBSCRIBES:
 ///     /cmd_vel (geometry_msgs::msg::Twist): commanded body twist
 ///		  /sensor_data (nuturtlebot_msgs::msg::SensorData): sensor data from the real robot sensors or nusim
@@ -18,17 +33,25 @@
 /// CLIENTS:
 ///     None
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "rclcpp/logging.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "geometry_msgs/msg/twist.hpp"
 #include "nuturtlebot_msgs/msg/wheel_commands.hpp"
 #include "nuturtlebot_msgs/msg/sensor_data.hpp"
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
 #include "turtlelib/diff_drive.hpp"
+#include "turtlelib/realtime.hpp"
+#include "turtlelib/resource_monitor.hpp"
+#include "turtlelib/resource_status.hpp"
 #include "sensor_msgs/msg/joint_state.hpp"
 
 using namespace std::chrono_literals;
@@ -50,7 +73,23 @@ public:
     declare_parameter<double>("motor_cmd_per_rad_sec", motor_cmd_per_rad_sec);
     declare_parameter<double>("encoder_ticks_per_rad", encoder_ticks_per_rad);
     declare_parameter<int>("rate", RATE);
+    declare_parameter<bool>("realtime", REALTIME);
+    declare_parameter<bool>("lock_memory", LOCK_MEMORY);
+    declare_parameter<int>("heap_reserve_mb", HEAP_RESERVE_MB);
+    declare_parameter<int>("control_priority", control_schedule.priority);
+    declare_parameter<std::vector<int64_t>>("control_cpus", std::vector<int64_t>{});
+    declare_parameter<int>("jitter_report_period", JITTER_REPORT_PERIOD);
+    declare_parameter<double>("resource_period", RESOURCE_PERIOD);
     RATE = get_parameter("rate").get_value<int>();
+    REALTIME = get_parameter("realtime").get_value<bool>();
+    LOCK_MEMORY = get_parameter("lock_memory").get_value<bool>();
+    HEAP_RESERVE_MB = get_parameter("heap_reserve_mb").get_value<int>();
+    control_schedule.priority = get_parameter("control_priority").get_value<int>();
+    for (const auto cpu : get_parameter("control_cpus").get_value<std::vector<int64_t>>()) {
+      control_schedule.cpus.push_back(cpu);
+    }
+    JITTER_REPORT_PERIOD = get_parameter("jitter_report_period").get_value<int>();
+    RESOURCE_PERIOD = get_parameter("resource_period").get_value<double>();
     wheel_radius = get_parameter("wheel_radius").get_value<double>();
     track_width = get_parameter("track_width").get_value<double>();
     motor_cmd_max = get_parameter("motor_cmd_max").get_value<int>();
@@ -78,16 +117,41 @@ public:
       RCLCPP_ERROR_STREAM(get_logger(), "encoder_ticks_per_rad parameter not provided");
       throw std::runtime_error("encoder_ticks_per_rad parameter not provided");
     }
+    if (RATE <= 0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "rate must be positive");
+      throw std::runtime_error("rate must be positive");
+    }
+    if (RESOURCE_PERIOD < 0.0) {
+      RCLCPP_ERROR_STREAM(get_logger(), "resource_period cannot be negative");
+      throw std::runtime_error("resource_period cannot be negative");
+    }
+
+    if (REALTIME) {
+      configure_process();
+    }
+
+    /// @brief all the callbacks of the node, which run on the control thread with the
+    /// real-time profile, or on the default executor otherwise
+    control_group = create_callback_group(
+      rclcpp::CallbackGroupType::MutuallyExclusive, not REALTIME);
+    rclcpp::SubscriptionOptions control_options;
+    control_options.callback_group = control_group;
+
+    // every topic is added before the control callbacks can count on it
+    cmd_vel_count = resources.add_subscription("cmd_vel");
+    sensor_data_count = resources.add_subscription("sensor_data");
+    wheel_cmd_count = resources.add_publisher("wheel_cmd");
+    joint_states_count = resources.add_publisher("/joint_states");
 
     /// @brief Subscriber to cmd_vel topic
     cmd_vel_sub = create_subscription<geometry_msgs::msg::Twist>(
       "cmd_vel", 10,
-      std::bind(&NuturtleControl::cmd_vel_callback, this, _1));
+      std::bind(&NuturtleControl::cmd_vel_callback, this, _1), control_options);
 
     /// @brief Subscriber to sensor_data topic
     sensor_data_sub = create_subscription<nuturtlebot_msgs::msg::SensorData>(
       "sensor_data", 10,
-      std::bind(&NuturtleControl::sensor_data_callback, this, _1));
+      std::bind(&NuturtleControl::sensor_data_callback, this, _1), control_options);
 
     /// @brief Publisher to wheel_cmd topic
     wheel_cmd_pub = create_publisher<nuturtlebot_msgs::msg::WheelCommands>("wheel_cmd", 10);
@@ -95,10 +159,21 @@ public:
     //// @brief Publisher to joint_states topic
     joint_states_pub = create_publisher<sensor_msgs::msg::JointState>("/joint_states", 10);
 
+    /// @brief Publisher of the resources used by the node
+    diagnostics_pub = create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
+
     /// \brief Timer (frequency defined by node parameter)
     _timer = create_wall_timer(
       std::chrono::milliseconds((int)(1000 / RATE)),
-      std::bind(&NuturtleControl::timer_callback, this));
+      std::bind(&NuturtleControl::timer_callback, this), control_group);
+    timer_jitter = turtlelib::TimerJitter((1000 / RATE) * 1e-3);
+
+    /// \brief Timer which reports the resources, off the control thread
+    if (RESOURCE_PERIOD > 0.0) {
+      resource_timer = create_wall_timer(
+        std::chrono::milliseconds((int)(1000 * RESOURCE_PERIOD)),
+        std::bind(&NuturtleControl::resource_timer_callback, this));
+    }
 
     // initialize joint states message
     js_msg.name.push_back("wheel_left_joint");
@@ -109,6 +184,28 @@ public:
     js_msg.velocity.push_back(0.0);
   }
 
+  /// @brief returns true if the control callbacks run on their own real-time thread
+  bool realtime() const
+  {
+    return REALTIME;
+  }
+
+  /// @brief returns the callback group of the control callbacks
+  rclcpp::CallbackGroup::SharedPtr get_control_group() const
+  {
+    return control_group;
+  }
+
+  /// @brief applies the control thread's priority and affinity to the calling thread
+  void configure_control_thread()
+  {
+    try {
+      turtlelib::apply_thread_schedule(control_schedule);
+    } catch (const std::exception & e) {
+      RCLCPP_WARN_STREAM(get_logger(), "Control thread keeps the default schedule: " << e.what());
+    }
+  }
+
 private:
   // Parameters that can be passed to the node
   // probably from diff_params.yaml in nuturtle_description
@@ -118,6 +215,23 @@ private:
   double motor_cmd_per_rad_sec = 0.0;
   double encoder_ticks_per_rad = 0.0;
   int RATE = 200;
+  bool REALTIME = false;
+  bool LOCK_MEMORY = true;
+  int HEAP_RESERVE_MB = 32;
+  int JITTER_REPORT_PERIOD = 0;
+  double RESOURCE_PERIOD = 5.0;
+
+  // real-time profile
+  turtlelib::ThreadSchedule control_schedule{80, {}};
+  rclcpp::CallbackGroup::SharedPtr control_group;
+  turtlelib::TimerJitter timer_jitter{0.005};
+
+  // CPU time, memory, and message rates of the node
+  turtlelib::ResourceMonitor resources;
+  size_t cmd_vel_count = 0;
+  size_t sensor_data_count = 0;
+  size_t wheel_cmd_count = 0;
+  size_t joint_states_count = 0;
 
   // Pubscriptions
   rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr cmd_vel_sub;
@@ -126,12 +240,27 @@ private:
   // Publishers
   rclcpp::Publisher<nuturtlebot_msgs::msg::WheelCommands>::SharedPtr wheel_cmd_pub;
   rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr joint_states_pub;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub;
 
   // Other
   rclcpp::TimerBase::SharedPtr _timer; // Timer
+  rclcpp::TimerBase::SharedPtr resource_timer;
   turtlelib::DiffDrive turtlebot;      // DiffDrive object for IK and FK for turtlebot
   sensor_msgs::msg::JointState js_msg; // JointStates message
 
+  /// @brief locks and prefaults the memory of the process, as far as it is permitted
+  void configure_process()
+  {
+    try {
+      if (LOCK_MEMORY) {
+        turtlelib::lock_memory();
+      }
+      turtlelib::reserve_heap(static_cast<size_t>(HEAP_RESERVE_MB) * 1024 * 1024);
+    } catch (const std::exception & e) {
+      RCLCPP_WARN_STREAM(get_logger(), "Real-time memory profile not applied: " << e.what());
+    }
+  }
+
   // Encoder values at the last timestep
   double last_encoder_left = 0.0;
   double last_encoder_right = 0.0;
@@ -143,6 +272,8 @@ private:
   /// @param Vmsg - (geometry_msgs/msg/Twist)
   void cmd_vel_callback(const geometry_msgs::msg::Twist & Vmsg)
   {
+    resources.count(cmd_vel_count);
+
     // Store the geometry_msg/Twist in a turtlelib/Twist2D
     turtlelib::Twist2D V{Vmsg.angular.z, Vmsg.linear.x, 0.0};
 
@@ -174,6 +305,7 @@ private:
 
     // Publish the wheel_cmd_msg on /wheel_cmd topic
     wheel_cmd_pub->publish(wheel_cmd_msg);
+    resources.count(wheel_cmd_count);
   }
 
   /// @brief  callback function to /sensor_data subscription
@@ -181,6 +313,8 @@ private:
   /// @param sensor_data (nuturtlebot_msgs/msg/SensorData)
   void sensor_data_callback(const nuturtlebot_msgs::msg::SensorData & sensor_data)
   {
+    resources.count(sensor_data_count);
+
     // Update wheel angles
     js_msg.position.at(0) = sensor_data.left_encoder / encoder_ticks_per_rad;
     js_msg.position.at(1) = sensor_data.right_encoder / encoder_ticks_per_rad;
@@ -202,9 +336,28 @@ private:
   /// @brief timer callback to publish joint states
   void timer_callback()
   {
+    timer_jitter.tick();
+    if (timer_jitter.count() >= static_cast<size_t>(std::max(JITTER_REPORT_PERIOD, 1))) {
+      if (JITTER_REPORT_PERIOD > 0) {
+        RCLCPP_INFO_STREAM(get_logger(), timer_jitter.summary("joint_states timer"));
+      }
+      timer_jitter.clear();
+    }
+
     // stamp and publish joint states
     js_msg.header.stamp = get_clock()->now();
     joint_states_pub->publish(js_msg);
+    resources.count(joint_states_count);
+  }
+
+  /// @brief publishes the CPU time, memory, and message rates of the node since the
+  /// last call as diagnostics
+  void resource_timer_callback()
+  {
+    diagnostic_msgs::msg::DiagnosticArray diagnostics;
+    diagnostics.header.stamp = get_clock()->now();
+    diagnostics.status.push_back(turtlelib::resource_status(resources.report(), get_name()));
+    diagnostics_pub->publish(diagnostics);
   }
 };
 
@@ -212,7 +365,25 @@ private:
 int main(int argc, char * argv[])
 {
   rclcpp::init(argc, argv);
-  rclcpp::spin(std::make_shared<NuturtleControl>());
+  const auto node = std::make_shared<NuturtleControl>();
+
+  // with the real-time profile the control callbacks get their own thread
+  rclcpp::executors::SingleThreadedExecutor control_executor;
+  std::thread control_thread;
+  if (node->realtime()) {
+    control_executor.add_callback_group(node->get_control_group(), node->get_node_base_interface());
+    control_thread = std::thread(
+      [&node, &control_executor]() {
+        node->configure_control_thread();
+        control_executor.spin();
+      });
+  }
+
+  rclcpp::spin(node);
+  control_executor.cancel();
+  if (control_thread.joinable()) {
+    control_thread.join();
+  }
   rclcpp::shutdown();
   return 0;
 }
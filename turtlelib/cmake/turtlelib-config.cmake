@@ -0,0 +1,6 @@
+# Config file of the installed turtlelib package. The exported targets link
+# Threads::Threads, so it is found before they are loaded
+include(CMakeFindDependencyMacro)
+find_dependency(Threads)
+
+include("${CMAKE_CURRENT_LIST_DIR}/turtlelib-targets.cmake")
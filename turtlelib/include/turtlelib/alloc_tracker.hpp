@@ -0,0 +1,123 @@
+#ifndef ALLOC_TRACKER_INCLUDE_GUARD_HPP
+#define ALLOC_TRACKER_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Opt-in heap allocation tracking for profiling callbacks
+///
+/// Allocations are only counted when the executable links the turtlelib::alloc_hooks
+/// library, which replaces the global operator new and operator delete with versions
+/// that update per-thread counters. Without it every count stays at zero, so the
+/// profiling code can stay in place at no cost.
+
+#include <cstddef>
+#include <string>
+#include "turtlelib/benchmark.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief heap activity of one thread
+    struct AllocationCounts
+    {
+        /// @brief number of calls to operator new
+        size_t allocations = 0;
+
+        /// @brief number of calls to operator delete with a non null pointer
+        size_t deallocations = 0;
+
+        /// @brief total number of bytes requested from operator new
+        size_t bytes = 0;
+    };
+
+    /// @brief returns true if the allocation hooks are linked into this executable
+    bool allocation_tracking_enabled();
+
+    /// @brief returns the heap activity of the calling thread since it started
+    AllocationCounts thread_allocation_counts();
+
+    /// @cond
+    namespace detail
+    {
+        // called by the replacement operator new and operator delete
+        void record_allocation(size_t bytes) noexcept;
+        void record_deallocation() noexcept;
+        void set_allocation_tracking_enabled() noexcept;
+    }
+    /// @endcond
+
+    /// @brief Measures the heap activity of the calling thread between its
+    /// construction and a call to counts()
+    class AllocationScope
+    {
+    private:
+        AllocationCounts start;
+
+    public:
+        /// @brief starts counting
+        AllocationScope();
+
+        /// @brief restarts counting
+        void reset();
+
+        /// @brief heap activity of the calling thread since construction or the last reset
+        AllocationCounts counts() const;
+    };
+
+    /// @brief Accumulates the duration, allocations, and allocated bytes of every
+    /// invocation of a callback
+    class CallbackProfile
+    {
+    private:
+        SampleStats time_samples;
+        SampleStats allocation_samples;
+        SampleStats byte_samples;
+
+    public:
+        /// @brief Measures one invocation from construction to destruction and adds
+        /// it to the profile
+        class Sample
+        {
+        private:
+            CallbackProfile &profile;
+            Stopwatch stopwatch;
+            AllocationScope scope;
+
+        public:
+            /// @brief starts measuring an invocation
+            /// @param p the profile the invocation is added to
+            explicit Sample(CallbackProfile &p);
+
+            /// @brief stops measuring and adds the invocation to the profile
+            ~Sample();
+
+            Sample(const Sample &) = delete;
+            Sample &operator=(const Sample &) = delete;
+        };
+
+        /// @brief adds an invocation
+        /// @param time_us the duration of the invocation in microseconds
+        /// @param counts the heap activity of the invocation
+        void add(double time_us, const AllocationCounts &counts);
+
+        /// @brief removes all invocations, keeping the memory used to store them
+        void clear();
+
+        /// @brief returns the number of invocations
+        size_t count() const;
+
+        /// @brief returns the durations of the invocations in microseconds
+        const SampleStats &time_us() const;
+
+        /// @brief returns the number of allocations of each invocation
+        const SampleStats &allocations() const;
+
+        /// @brief returns the number of bytes allocated by each invocation
+        const SampleStats &bytes() const;
+
+        /// @brief one line summary of the durations and allocations
+        /// @param name the name of the callback
+        std::string summary(const std::string &name) const;
+    };
+
+}
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef BENCHMARK_INCLUDE_GUARD_HPP
+#define BENCHMARK_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Timing, statistics, and JSON reporting helpers for the benchmark executables
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace turtlelib
+{
+
+    /// @brief Measures elapsed wall-clock time with std::chrono::steady_clock
+    class Stopwatch
+    {
+    private:
+        std::chrono::steady_clock::time_point t_start;
+
+    public:
+        /// @brief creates a Stopwatch which starts timing immediately
+        Stopwatch();
+
+        /// @brief restarts the stopwatch
+        void reset();
+
+        /// @brief time elapsed since construction or the last reset
+        /// @return elapsed time in microseconds
+        double elapsed_us() const;
+
+        /// @brief time elapsed since construction or the last reset
+        /// @return elapsed time in seconds
+        double elapsed_s() const;
+    };
+
+    /// @brief Collects samples (e.g. durations) and computes summary statistics
+    class SampleStats
+    {
+    private:
+        std::vector<double> samples;
+        double sum = 0.0;
+
+    public:
+        /// @brief adds a sample
+        /// @param value the sample to add
+        void add(double value);
+
+        /// @brief removes all samples
+        void clear();
+
+        /// @brief returns the number of samples
+        size_t count() const;
+
+        /// @brief returns the mean of the samples, or 0 if there are none
+        double mean() const;
+
+        /// @brief returns the smallest sample, or 0 if there are none
+        double min() const;
+
+        /// @brief returns the largest sample, or 0 if there are none
+        double max() const;
+
+        /// @brief returns the sum of all samples
+        double total() const;
+
+        /// @brief computes a percentile by linear interpolation between closest ranks
+        /// @param p the percentile in [0, 100]
+        /// @return the p-th percentile, or 0 if there are no samples
+        double percentile(double p) const;
+    };
+
+    /// @brief Counts samples in fixed buckets. Bucket i holds the samples in
+    /// (edges[i-1], edges[i]], and a last bucket holds the samples above all edges
+    class Histogram
+    {
+    private:
+        std::vector<double> upper_edges;
+        std::vector<size_t> bucket_counts;
+
+    public:
+        /// @brief creates a histogram with the given bucket edges
+        /// @param edges the upper edge of each bucket, in increasing order
+        /// @throw std::invalid_argument if the edges are not increasing
+        explicit Histogram(const std::vector<double> &edges);
+
+        /// @brief adds a sample to its bucket
+        void add(double value);
+
+        /// @brief empties every bucket
+        void clear();
+
+        /// @brief returns the upper edge of each bucket except the last
+        const std::vector<double> &edges() const;
+
+        /// @brief returns the number of samples in each bucket, one more than the edges
+        const std::vector<size_t> &counts() const;
+
+        /// @brief returns the total number of samples
+        size_t total() const;
+    };
+
+    /// @brief reads the resident set size of this process from /proc/self/status
+    /// @return the resident memory in kB, or 0 if it is not available
+    size_t resident_memory_kb();
+
+    /// @brief reads the peak resident set size of this process from /proc/self/status
+    /// @return the peak resident memory in kB, or 0 if it is not available
+    size_t peak_resident_memory_kb();
+
+    /// @brief Minimal streaming JSON writer. Commas between members are inserted
+    /// automatically, so callers only describe the structure, e.g.
+    /// begin_object(); key("n"); value(3); end_object();
+    class JsonWriter
+    {
+    private:
+        std::ostream &os;
+
+        // one entry per open object/array, true until its first member is written
+        std::vector<bool> first_member;
+        bool after_key = false;
+
+        void separate();
+
+    public:
+        /// @brief creates a writer which writes to the given stream
+        /// @param out the stream to write JSON to
+        explicit JsonWriter(std::ostream &out);
+
+        /// @brief opens a JSON object
+        void begin_object();
+
+        /// @brief closes the innermost JSON object
+        void end_object();
+
+        /// @brief opens a JSON array
+        void begin_array();
+
+        /// @brief closes the innermost JSON array
+        void end_array();
+
+        /// @brief writes the key of the next object member
+        /// @param name the member name
+        void key(const std::string &name);
+
+        /// @brief writes a number (non-finite values are written as null)
+        void value(double v);
+
+        /// @brief writes an integer
+        void value(long long v);
+
+        /// @brief writes an integer
+        void value(int v);
+
+        /// @brief writes an unsigned integer
+        void value(size_t v);
+
+        /// @brief writes a boolean
+        void value(bool v);
+
+        /// @brief writes an escaped string
+        void value(const std::string &v);
+
+        /// @brief writes an escaped string
+        void value(const char *v);
+
+        /// @brief writes the count, mean, min, max and p50/p90/p99 of the samples as an object
+        /// @param stats the samples to summarize
+        void value(const SampleStats &stats);
+    };
+
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef EXPLORE_INCLUDE_GUARD_HPP
+#define EXPLORE_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Picks exploration waypoints which gain the most information about the map and
+/// the pose of the robot per meter driven
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "turtlelib/rigid2d.hpp"
+#include "turtlelib/diff_drive.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief parameters of the exploration planner
+    struct ExplorationParams
+    {
+        /// @brief landmarks within this distance of the robot are expected to be seen
+        double sensor_range = 1.5;
+
+        /// @brief variance of a landmark position measurement, in m^2
+        double measurement_variance = 1.0;
+
+        /// @brief variance of a landmark position when it is first seen, in m^2
+        double new_landmark_variance = 4.0;
+
+        /// @brief expected number of landmarks per square meter of unexplored area
+        double landmark_density = 0.5;
+
+        /// @brief growth of the variance of the robot position per meter driven, in m^2/m
+        double drift_per_meter = 0.01;
+
+        /// @brief meters of driving that cost as much as turning in place by one radian
+        double turn_cost = 0.1;
+
+        /// @brief waypoints, and the straight paths to them, keep this far from known
+        /// landmarks
+        double clearance = 0.25;
+
+        /// @brief distances from the robot at which waypoints are considered
+        std::vector<double> radii{0.5, 1.0, 1.5};
+
+        /// @brief number of evenly spaced directions in which waypoints are considered
+        size_t headings = 12;
+
+        /// @brief size of the arena the robot explores, centered on arena_center
+        double x_length = 5.0;
+
+        /// @brief size of the arena the robot explores, centered on arena_center
+        double y_length = 5.0;
+
+        /// @brief center of the arena in the map frame
+        Vector2D arena_center{0.0, 0.0};
+
+        /// @brief side of the cells used to track which parts of the arena were seen
+        double cell_size = 0.25;
+
+        /// @brief waypoints expected to gain less than this many nats are not worth a trip
+        double min_gain = 0.05;
+    };
+
+    /// @brief the belief about one landmark of the map
+    struct LandmarkBelief
+    {
+        /// @brief the estimated position of the landmark
+        Vector2D position{};
+
+        /// @brief the marginal covariance of the position, (xx, xy, yy)
+        std::array<double, 3> covariance{0.0, 0.0, 0.0};
+    };
+
+    /// @brief a candidate waypoint and its expected value
+    struct Waypoint
+    {
+        /// @brief the position of the waypoint in the map frame
+        Vector2D position{};
+
+        /// @brief expected information gain in nats
+        double gain = 0.0;
+
+        /// @brief travel cost in meters, counting the turn towards the waypoint
+        double cost = 0.0;
+
+        /// @brief gain per meter of travel cost
+        double score = 0.0;
+    };
+
+    /// @brief Chooses where a SLAM robot should drive next to learn the most per meter
+    ///
+    /// Each candidate waypoint on rings around the robot is scored by the information it
+    /// is expected to give, divided by the cost of driving there. Visibility is predicted
+    /// by range only. Landmarks in range of a waypoint are re-observed, which shrinks their
+    /// marginal covariance and the covariance of the robot position, grown by the drift
+    /// of the drive there; unexplored cells in range are expected to hold new landmarks.
+    /// The gains are the log determinant reductions of each Gaussian.
+    class ExplorationPlanner
+    {
+    private:
+        ExplorationParams params;
+        size_t n_cols = 0;
+        size_t n_rows = 0;
+        std::vector<bool> explored;
+        size_t n_explored = 0;
+
+        /// @brief returns the number of unexplored cells within sensor range of p
+        size_t unexplored_in_range(const Vector2D &p) const;
+
+        /// @brief returns whether p is inside the arena, at least clearance from the walls
+        bool in_arena(const Vector2D &p) const;
+
+    public:
+        /// @brief a planner with the default parameters
+        ExplorationPlanner();
+
+        /// @brief a planner with the given parameters
+        /// @param params the sensor, cost and arena parameters
+        explicit ExplorationPlanner(const ExplorationParams &params);
+
+        /// @brief marks the part of the arena within sensor range of the robot as explored
+        /// @param pose the pose of the robot in the map frame
+        void observe(const Pose2D &pose);
+
+        /// @brief returns the fraction of the arena explored so far
+        double explored_fraction() const;
+
+        /// @brief returns the expected information gain of a robot at a waypoint
+        /// @param waypoint the position of the waypoint in the map frame
+        /// @param position_covariance the covariance of the robot position on arrival,
+        /// (xx, xy, yy)
+        /// @param landmarks the current map
+        double information_gain(
+            const Vector2D &waypoint,
+            const std::array<double, 3> &position_covariance,
+            const std::vector<LandmarkBelief> &landmarks) const;
+
+        /// @brief returns all waypoints the robot can drive to, scored
+        /// @param pose the pose of the robot in the map frame
+        /// @param pose_covariance the covariance of (theta, x, y), row major
+        /// @param landmarks the current map
+        std::vector<Waypoint> candidates(
+            const Pose2D &pose,
+            const std::array<double, 9> &pose_covariance,
+            const std::vector<LandmarkBelief> &landmarks) const;
+
+        /// @brief returns the waypoint with the highest score, or a waypoint with no gain
+        /// when there is nothing left to learn
+        /// @param pose the pose of the robot in the map frame
+        /// @param pose_covariance the covariance of (theta, x, y), row major
+        /// @param landmarks the current map
+        Waypoint plan(
+            const Pose2D &pose,
+            const std::array<double, 9> &pose_covariance,
+            const std::vector<LandmarkBelief> &landmarks) const;
+    };
+
+}
+
+#endif
@@ -11,8 +11,11 @@
 #include <iostream>
 #include <armadillo>
 #include <map>
+#include <memory>
 #include "turtlelib/rigid2d.hpp"
 #include "turtlelib/diff_drive.hpp"
+#include "turtlelib/benchmark.hpp"
+#include "turtlelib/thread_pool.hpp"
 #include "rclcpp/logging.hpp"
 #include "rclcpp/rclcpp.hpp"
 
@@ -69,30 +72,190 @@ namespace turtlelib
 
     };
 
+    /// @brief Statistics of a KalmanFilter, kept up to date by every call to run()
+    struct FilterStats
+    {
+        /// @brief number of landmarks in the map
+        size_t landmarks = 0;
+
+        /// @brief dimension of the state, 3 + 2 * landmarks
+        size_t state_dimension = 3;
+
+        /// @brief approximate bytes held by the state, covariance, noise, landmark index,
+        /// and the landmark arrays and scratch memory of association
+        size_t bytes = 0;
+
+        /// @brief number of calls to run()
+        size_t runs = 0;
+
+        /// @brief duration of the association (and landmark initialization) of the last run
+        /// in microseconds
+        double last_associate_us = 0.0;
+
+        /// @brief duration of the prediction of the last run in microseconds
+        double last_predict_us = 0.0;
+
+        /// @brief duration of the update of the last run in microseconds
+        double last_update_us = 0.0;
+
+        /// @brief duration of the association of all runs in microseconds
+        double total_associate_us = 0.0;
+
+        /// @brief duration of the prediction of all runs in microseconds
+        double total_predict_us = 0.0;
+
+        /// @brief duration of the update of all runs in microseconds
+        double total_update_us = 0.0;
+
+        /// @brief number of measurements in the last run
+        size_t last_measurements = 0;
+
+        /// @brief measurements of unknown association in the last run which were associated
+        /// with a landmark already in the map
+        size_t last_associated = 0;
+
+        /// @brief landmarks added to the map in the last run
+        size_t last_new_landmarks = 0;
+
+        /// @brief landmarks whose estimates the last run updated, all of them unless the
+        /// filter has a consider distance
+        size_t last_active_landmarks = 0;
+
+        /// @brief number of times the landmarks were reordered along the Morton curve
+        size_t reorders = 0;
+
+        /// @brief threads the scoring of the last run's measurements was split across, 1
+        /// when it was sequential
+        size_t last_association_threads = 1;
+
+        /// @brief number of measurements in all runs
+        size_t total_measurements = 0;
+
+        /// @brief measurements of unknown association in all runs which were associated
+        /// with a landmark already in the map
+        size_t total_associated = 0;
+
+        /// @brief landmarks added to the map in all runs
+        size_t total_new_landmarks = 0;
+    };
+
     /// @brief Extended Kalman Filter for use with EKF-SLAM
     /// This was written with the Turtlebot3 in mind but could
     /// probably be used for a wide variety of applications
-    class KalmanFilter
+    ///
+    /// The filter is specialized at compile time on the size of the robot state and of
+    /// each landmark state, so the Jacobians and covariance blocks of a single landmark
+    /// have fixed sizes and the steps only touch the rows and columns they change. The
+    /// state is [robot, m_1, m_2, ...]. The odometry motion model and the range-bearing
+    /// measurement model act on the leading (theta, x, y) of the robot and (x, y) of each
+    /// landmark, and any further components would be carried along with an identity
+    /// motion model. Only the point landmark model <3, 2> is compiled: compute_h(),
+    /// compute_H(), and the landmark arrays of association all assume a range and bearing
+    /// to a point, so landmarks such as lines need more than a specialization of those.
+    /// @tparam RobotDim number of components of the robot state, at least 3
+    /// @tparam LandmarkDim number of components of each landmark state, at least 2
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    class BasicKalmanFilter
     {
+        static_assert(RobotDim >= 3, "The robot state must contain the pose (theta, x, y)");
+        static_assert(LandmarkDim >= 2, "The landmark state must contain its position (x, y)");
+
+    public:
+        /// @brief a measurement (r, phi)
+        using MeasurementVector = arma::mat::fixed<2, 1>;
+
+        /// @brief covariance of a measurement
+        using MeasurementMatrix = arma::mat::fixed<2, 2>;
+
+        /// @brief a square block the size of the robot state
+        using RobotMatrix = arma::mat::fixed<RobotDim, RobotDim>;
+
+        /// @brief derivative of a measurement with respect to the robot state
+        using RobotJacobian = arma::mat::fixed<2, RobotDim>;
+
+        /// @brief derivative of a measurement with respect to the state of its landmark
+        using LandmarkJacobian = arma::mat::fixed<2, LandmarkDim>;
 
     private:
         arma::mat Xi_hat;    // Full state prediction [pose, map state]
         arma::mat sigma_hat; // Covariance matrix
-        arma::mat Q_bar;     // Process noise: Measure of how accurate the model is
-        arma::mat R_bar;     // Sensor noise: Measure of how accurate the sensors are
+        RobotMatrix Q_bar;   // Process noise of the robot: the map is stationary
+        MeasurementMatrix R_bar; // Sensor noise: Measure of how accurate the sensors are
         uint64_t n = 0;      // Number of landmarks
+        double consider_dist = 0.0; // Landmarks further from the robot are not updated
+        size_t reorder_period = 0;  // Runs between reorderings of the landmarks, 0 for never
+
+        /// @brief the measurements of the last run, with their associated ids
+        std::vector<LandmarkMeasurement> last_measurements;
+
+        /// @brief statistics of the runs so far
+        FilterStats filter_stats;
+
+        /// @brief changes whenever the state or covariance of the robot or of an existing
+        /// landmark does, so copies of them can tell when they are stale
+        uint64_t state_version = 1;
+
+        /// @brief a structure of arrays mirror of what association reads of each landmark:
+        /// its id, mean, marginal covariance, and covariance with the robot pose, and from
+        /// them its predicted measurement and the inverse of its innovation covariance, so
+        /// a measurement is scored against every landmark in one pass over contiguous memory
+        struct LandmarkArrays
+        {
+            std::vector<unsigned int> id;
+            std::vector<double> x, y;                // mean
+            std::vector<double> xx, xy, yy;          // marginal covariance
+            std::vector<double> theta_x, theta_y;    // covariance with the robot heading
+            std::vector<double> x_x, x_y, y_x, y_y;  // covariance with the robot position
+            std::vector<double> range, bearing;      // predicted measurement
+            std::vector<double> info_rr, info_rb, info_bb; // inverse innovation covariance
+
+            /// @brief the state_version the arrays were copied at, 0 for never
+            uint64_t version = 0;
+        };
+        mutable LandmarkArrays landmark_arrays;
+
+        /// @brief distances of the measurement being associated, kept to reuse the memory
+        mutable std::vector<double> association_distances;
+
+        /// @brief the closest landmark to a measurement among the slots scored so far
+        struct Candidate
+        {
+            double d = 0.0;         // mahalonobis distance, the threshold until found
+            unsigned int id = 0;    // landmark id, if found
+            bool found = false;     // whether a landmark is closer than the threshold
+            size_t scored = 0;      // the slots [0, scored) of landmark_arrays were scored
+        };
+
+        /// @brief scores the measurements of a scan across, shared by copies of the filter
+        std::shared_ptr<ThreadPool> association_pool;
+
+        /// @brief the closest landmarks found by the parallel scoring of the current run,
+        /// by measurement, and the distances of each chunk
+        std::vector<Candidate> scan_candidates;
+        std::vector<std::vector<double>> chunk_distances;
 
         /// @brief map (dictionary) of id:index key value pairs
-        // the index is the index of the x_j component of the map_j so index+1 is y_j
+        // the index is the index of the first component of landmark j in Xi_hat
         std::map<unsigned int, unsigned int> landmarks_dict;
 
         /// @brief computes the theoretical measurement given the current state estimate
-        /// @param j index of x component of mt_j in Xi_hat
-        arma::mat compute_h(unsigned int ind_in_Xi) const;
+        /// @param ind_in_Xi index of the first component of landmark j in Xi_hat
+        MeasurementVector compute_h(unsigned int ind_in_Xi) const;
+
+        /// @brief computes the derivative of h with respect to the state Xi, which is
+        /// zero outside of the robot state and the state of landmark j
+        /// @param ind_in_Xi index of the first component of landmark j in Xi_hat
+        /// @param Hr derivative with respect to the robot state
+        /// @param Hm derivative with respect to the state of landmark j
+        void compute_H(unsigned int ind_in_Xi, RobotJacobian &Hr, LandmarkJacobian &Hm) const;
 
-        /// @brief computes the derivative of h with respect to the state Xi
-        /// @param j index of x component of mt_j in Xi_hat
-        arma::mat compute_H(unsigned int ind_in_Xi) const;
+        /// @brief computes the covariance H sigma H^T + R of a measurement of landmark j
+        /// from the robot and landmark blocks of the covariance
+        /// @param ind_in_Xi index of the first component of landmark j in Xi_hat
+        /// @param Hr derivative with respect to the robot state
+        /// @param Hm derivative with respect to the state of landmark j
+        MeasurementMatrix innovation_covariance(unsigned int ind_in_Xi, const RobotJacobian &Hr,
+                                                const LandmarkJacobian &Hm) const;
 
         /// @brief takes a measurement and if it hasn't been seen before, initializes it,
         /// and adds it to the set of known landmark measurments.
@@ -108,29 +271,63 @@ namespace turtlelib
         /// @brief extented Kalman filter update step
         /// @param measurements a vector of LandmarkMeasurements
         void update(const std::vector<LandmarkMeasurement> &measurements);
+
+        /// @brief Schmidt-Kalman update step, which updates the robot, the measured
+        /// landmarks, and the landmarks within the consider distance of the robot. The
+        /// other landmarks keep their means and mutual covariances, but their covariance
+        /// with the updated states still enters the gain and is kept consistent
+        /// @param measurements a vector of LandmarkMeasurements with known association
+        void consider_update(const std::vector<LandmarkMeasurement> &measurements);
         
-        /// @brief computes the mahalonobis distance between zi and zk
-        /// @param zi a 2x1 vector of the measurment i
-        /// @param zk a 2x1 vector of the measurment k
-        /// @param covariance the covariance matrix
-        /// @return the mahalonobis distance
-        double mahalanobis_distance(arma::mat zi, arma::mat zk, arma::mat covariance) const;
+        /// @brief copies the landmark means and covariance blocks into landmark_arrays and
+        /// predicts their measurements, if the state changed or landmarks were added since
+        /// the last copy
+        void sync_landmark_arrays() const;
+
+        /// @brief returns the bytes reserved by landmark_arrays and the scratch memory of
+        /// association
+        size_t association_bytes() const;
+
+        /// @brief computes the mahalonobis distance of a measurement from the predicted
+        /// measurement of every landmark, in the order of the state. Only reads the
+        /// landmark arrays once they are in sync, so it may be called from several threads
+        /// @param measurement the measurement (r, phi)
+        /// @param first the first slot to score
+        /// @param distances resized to the number of slots from first and filled in
+        void score_landmarks(const LandmarkMeasurement &measurement, size_t first,
+                             std::vector<double> &distances) const;
+
+        /// @brief continues the search for the closest landmark to a measurement over the
+        /// slots of landmark_arrays after those it already scored
+        /// @param measurement the measurement (r, phi)
+        /// @param closest the closest landmark so far
+        /// @param distances scratch memory for the distances
+        /// @return the closest landmark over every slot
+        Candidate closest_landmark(const LandmarkMeasurement &measurement, Candidate closest,
+                                   std::vector<double> &distances) const;
+
+        /// @brief finds the closest landmark to each measurement of unknown association in
+        /// the state before the scan, across the association pool, into scan_candidates
+        /// @param measurements the measurements of the scan
+        /// @return whether the measurements were scored in parallel
+        bool score_scan(const std::vector<LandmarkMeasurement> &measurements);
 
         /// @brief incorporates unassociated data, modifies marker_id
         /// @param measurment the LandmarkMeasurement to associate
+        /// @param closest the closest landmark among the slots already scored
         /// @return LandmarkMeasurement that is the same as the input,
         /// except with an updated marker_id
-        LandmarkMeasurement associate_measurement(LandmarkMeasurement measurment);
+        LandmarkMeasurement associate_measurement(LandmarkMeasurement measurment, Candidate closest) const;
 
     public:
         
         /// @brief class constructor
-        KalmanFilter();
+        BasicKalmanFilter();
 
         /// @brief class constructor that accepts Q and R gains
         /// @param Q process noise gain
         /// @param R measurment noise gain
-        KalmanFilter(double Q, double R);
+        BasicKalmanFilter(double Q, double R);
 
         /// @brief Runs one iteration of the extended Kalman filtera
         /// with the given twist and landmark measurements. The pose
@@ -141,6 +338,51 @@ namespace turtlelib
         /// @param measurements a vector of LandmarkMeasurements
         void run(const Pose2D &pose, const Twist2D &V, const std::vector<LandmarkMeasurement> &measurements);
 
+        /// @brief sets the distance from the robot beyond which landmarks are consider
+        /// states: the update uses their uncertainty, but does not change their estimates
+        /// or their covariances with each other. This trades a little accuracy for an
+        /// update cost that grows with the landmarks near the robot rather than the map
+        /// @param distance the distance in meters, 0 to update every landmark (the default)
+        /// @throw std::invalid_argument if the distance is negative
+        void set_consider_distance(double distance);
+
+        /// @brief returns the distance beyond which landmarks are consider states, 0 when
+        /// every landmark is updated
+        double consider_distance() const;
+
+        /// @brief sorts the landmarks of the state and covariance in place along a Morton
+        /// (Z-order) curve through their positions, so landmarks near each other in the
+        /// world are near each other in memory. Landmark ids keep their estimates; only
+        /// the order of map_prediction() and of the covariance changes
+        /// @return true if the order changed
+        bool reorder_landmarks();
+
+        /// @brief reorders the landmarks every so many calls to run()
+        /// @param runs the calls between reorderings, 0 to never reorder (the default)
+        void set_reorder_period(size_t runs);
+
+        /// @brief returns the id of each landmark, in the order of map_prediction()
+        std::vector<unsigned int> landmark_ids() const;
+
+        /// @brief splits the scoring of the measurements of a scan against the map across
+        /// threads. Each measurement of unknown association is scored against the landmarks
+        /// in the state before the scan in parallel, and the measurements are then resolved
+        /// one after another on the calling thread against those scores and the landmarks
+        /// the scan added, so the associations are the same as with one thread. Scans with
+        /// too few scores to be worth waking the workers for are scored sequentially
+        /// @param threads the threads to use, including the caller, 0 or 1 for none
+        /// (the default)
+        void set_association_threads(size_t threads);
+
+        /// @brief returns the threads association is split across, 1 when sequential
+        size_t association_threads() const;
+
+        /// @brief returns the mahalonobis distance of a measurement from the predicted
+        /// measurement of each landmark, which association compares against its threshold
+        /// @param measurement the measurement (r, phi)
+        /// @return the distances, in the order of landmark_ids()
+        std::vector<double> mahalanobis_distances(const LandmarkMeasurement &measurement) const;
+
         /// @brief returns the current pose prediction
         /// @return an arma::mat of the prediction of the robot's current pose
         arma::mat pose_prediction() const;
@@ -152,7 +394,28 @@ namespace turtlelib
         /// @brief returns the current full state prediction
         /// @return an arma::mat of the prediction of the full state (robot+map)
         arma::mat state_prediction() const;
+
+        /// @brief returns the covariance of the full state
+        /// @return an arma::mat of the (RobotDim+LandmarkDim*n x RobotDim+LandmarkDim*n)
+        /// covariance matrix
+        arma::mat covariance() const;
+
+        /// @brief returns the measurements passed to the last call to run(),
+        /// with the ids they were associated with
+        /// @return the associated measurements
+        const std::vector<LandmarkMeasurement> &associated_measurements() const;
+
+        /// @brief returns the statistics of the filter, which are updated by run()
+        /// @return the size of the map and state, the memory held, the duration of each
+        /// stage, and the outcomes of the data association
+        const FilterStats &stats() const;
     };
 
+    // the models in use are compiled once, in kalman.cpp
+    extern template class BasicKalmanFilter<3, 2>;
+
+    /// @brief EKF-SLAM with a planar pose (theta, x, y) and point landmarks (x, y)
+    using KalmanFilter = BasicKalmanFilter<3, 2>;
+
 }
 #endif
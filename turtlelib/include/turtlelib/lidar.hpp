@@ -0,0 +1,51 @@
+#ifndef LIDAR_INCLUDE_GUARD_HPP
+#define LIDAR_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Simulation of a planar LIDAR scanning circular obstacles
+
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "turtlelib/rigid2d.hpp"
+#include "turtlelib/diff_drive.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief parameters of a simulated LIDAR whose beams are evenly
+    /// spaced counter-clockwise starting from the robot's x axis
+    struct LidarParams
+    {
+        /// @brief number of beams in one scan
+        size_t num_beams = 360;
+
+        /// @brief angle between consecutive beams in radians
+        double angle_increment = deg2rad(1.0);
+
+        /// @brief minimum range of the sensor in meters
+        double min_range = 0.160;
+
+        /// @brief maximum range of the sensor in meters
+        double max_range = 8.0;
+
+        /// @brief standard deviation of the Gaussian noise added to each return
+        double noise_stddev = 0.0;
+    };
+
+    /// @brief simulates one LIDAR scan of cylindrical obstacles. Only the obstacles
+    /// within range are considered and each one is only intersected with the beams
+    /// that can hit it, so the cost grows with the number of returns rather than
+    /// with beams * obstacles. Beams without a return are set to 0.0.
+    /// @param pose the pose of the sensor in the world frame
+    /// @param obstacles the centers of the obstacles in the world frame
+    /// @param obstacle_radius the radius of the obstacles
+    /// @param params the sensor parameters
+    /// @param rng random number generator used for the range noise
+    /// @param ranges [out] resized to params.num_beams and filled with the ranges
+    void simulate_lidar(
+        const Pose2D &pose, const std::vector<Vector2D> &obstacles, double obstacle_radius,
+        const LidarParams &params, std::mt19937 &rng, std::vector<float> &ranges);
+
+}
+
+#endif
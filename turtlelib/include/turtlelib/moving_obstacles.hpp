@@ -0,0 +1,95 @@
+#ifndef MOVING_OBSTACLES_INCLUDE_GUARD_HPP
+#define MOVING_OBSTACLES_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Obstacles which move through the simulator world, such as people or other robots
+
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "turtlelib/rigid2d.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief parameters shared by all moving obstacles
+    struct MovingObstacleParams
+    {
+        /// @brief speed of the obstacles in m/s
+        double speed = 0.2;
+
+        /// @brief standard deviation of the heading change of a random walk, in rad
+        /// per square root of a second
+        double turn_stddev = 1.0;
+
+        /// @brief length of the arena along x in meters, random walks stay inside it
+        double x_length = 5.0;
+
+        /// @brief length of the arena along y in meters, random walks stay inside it
+        double y_length = 5.0;
+
+        /// @brief random walks keep at least this far from the walls
+        double margin = 0.1;
+    };
+
+    /// @brief Moves a set of obstacles along their trajectories. An obstacle either
+    /// patrols back and forth between two points, or follows a random walk which
+    /// bounces off the walls of the arena
+    ///
+    /// The positions are stored contiguously and updated in place, so the simulator can
+    /// hand them to the lidar and collision checks every step without rebuilding them.
+    class MovingObstacles
+    {
+    private:
+        /// @brief the trajectory of one obstacle
+        struct Mover
+        {
+            bool patrol = false;
+            Vector2D start{};
+            Vector2D goal{};
+            bool returning = false; // a patrol heading back to its start
+            double heading = 0.0;   // of a random walk
+        };
+
+        MovingObstacleParams params;
+        std::vector<Mover> movers;
+        std::vector<Vector2D> centers;
+
+        /// @brief moves a patrol towards its current end point
+        void step_patrol(Mover &m, Vector2D &p, double distance) const;
+
+        /// @brief moves a random walk along its heading, turning away from the walls
+        void step_random_walk(Mover &m, Vector2D &p, double distance) const;
+
+    public:
+        /// @brief moving obstacles with the default parameters
+        MovingObstacles();
+
+        /// @brief moving obstacles with the given parameters
+        /// @param params the speed and the arena of the obstacles
+        explicit MovingObstacles(const MovingObstacleParams &params);
+
+        /// @brief adds an obstacle which patrols back and forth between two points
+        /// @param start where the obstacle starts
+        /// @param goal the other end of its patrol
+        void add_patrol(const Vector2D &start, const Vector2D &goal);
+
+        /// @brief adds an obstacle which follows a random walk
+        /// @param start where the obstacle starts
+        /// @param heading the direction it starts moving in
+        void add_random_walk(const Vector2D &start, double heading);
+
+        /// @brief moves all obstacles forward in time
+        /// @param dt the time step in seconds
+        /// @param rng random number generator for the random walks
+        void step(double dt, std::mt19937 &rng);
+
+        /// @brief returns the current centers of the obstacles, in the order they were added
+        const std::vector<Vector2D> &positions() const;
+
+        /// @brief returns the number of obstacles
+        size_t size() const;
+    };
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef ODOMETRY_INCLUDE_GUARD_HPP
+#define ODOMETRY_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Wheel odometry of a differential drive robot, shared by every node which
+/// integrates joint states
+
+#include "turtlelib/rigid2d.hpp"
+#include "turtlelib/diff_drive.hpp"
+#include <deque>
+
+namespace turtlelib
+{
+
+    /// @brief Integrates wheel angles and speeds into the pose and body twist of the robot
+    ///
+    /// Wheel slip shows up mostly as heading error, so the heading change between two
+    /// joint states can be blended with the integrated rate of a yaw gyro. The gyro bias
+    /// is estimated from the readings taken while the wheels do not move.
+    ///
+    /// Joint states and gyro readings arrive at their own rates, and wheel angles are
+    /// quantized by the encoders, so two joint states in a row often repeat the same angles
+    /// while the robot moves. The readings between two such joint states only count towards
+    /// the bias once the wheels have stayed still for a while after them; until then their
+    /// heading change is carried into the next joint state in which the wheels move.
+    class WheelOdometry
+    {
+    private:
+        DiffDrive ddrive;
+        Pose2D pose_now{0.0, 0.0, 0.0};
+        Twist2D V_now{0.0, 0.0, 0.0};
+        WheelState angles_now{0.0, 0.0};
+        size_t n_updates = 0;
+
+        /// @brief the gyro readings between two joint states
+        struct GyroInterval
+        {
+            double heading = 0.0;     // bias corrected heading change
+            double raw_heading = 0.0; // heading change, with the bias
+            double time = 0.0;        // seconds of readings
+        };
+
+        double gyro_weight = 0.0;   // fraction of the heading change taken from the gyro
+        double gyro_bias_now = 0.0; // estimated gyro bias in rad/s
+        GyroInterval gyro_now;      // readings since the last update
+        double last_gyro_stamp = 0.0;
+        bool gyro_started = false;
+
+        /// @brief the intervals since the wheels last moved which are not yet known to be
+        /// standstill, oldest first, and their total time
+        std::deque<GyroInterval> still_intervals;
+        double still_time = 0.0;
+
+    public:
+        /// @brief odometry of a robot with the default wheel radius and track width
+        WheelOdometry();
+
+        /// @brief odometry of a robot with the given kinematics
+        /// @param kinematics the wheel radius and track width of the robot
+        explicit WheelOdometry(const DiffDrive &kinematics);
+
+        /// @brief integrates a new joint state
+        /// @param angles the wheel angles in radians
+        /// @param speeds the wheel speeds in rad/s
+        void update(const WheelState &angles, const WheelState &speeds);
+
+        /// @brief sets how much of the heading change between joint states comes from the
+        /// gyro rather than the wheels
+        /// @param weight 0 to ignore the gyro, 1 to take the heading from the gyro only
+        void set_gyro_weight(double weight);
+
+        /// @brief integrates a reading of the yaw gyro until the next joint state
+        /// @param yaw_rate the measured yaw rate in rad/s
+        /// @param stamp_s the time of the reading in seconds
+        void add_gyro(double yaw_rate, double stamp_s);
+
+        /// @brief returns the estimated bias of the gyro in rad/s
+        double gyro_bias() const;
+
+        /// @brief sets the pose, keeping the wheel angles so the next update only adds
+        /// the motion since the last one
+        /// @param pose the new pose of the robot
+        void set_pose(const Pose2D &pose);
+
+        /// @brief returns the pose of the robot in the odometry frame
+        Pose2D pose() const;
+
+        /// @brief returns the body twist of the robot from the last wheel speeds
+        Twist2D twist() const;
+
+        /// @brief returns the wheel angles of the last update
+        WheelState wheel_angles() const;
+
+        /// @brief returns the number of joint states integrated
+        size_t updates() const;
+    };
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef POSE_EXTRAPOLATOR_INCLUDE_GUARD_HPP
+#define POSE_EXTRAPOLATOR_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Extrapolates a slow map frame estimate to the present with odometry, blending
+/// each new correction in over time
+
+#include "turtlelib/rigid2d.hpp"
+#include "turtlelib/diff_drive.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief Keeps the map -> odom transform behind an estimate of the robot in the map
+    ///
+    /// An estimate of the pose of the robot in the map refers to the odometry pose at the
+    /// time it was computed. Storing the map -> odom transform at that time, instead of
+    /// the pose itself, lets the latest odometry carry the estimate forward to whenever
+    /// it is published. When a new estimate arrives, the transform moves from where it
+    /// was towards the new one over the blend time, so the published pose does not jump.
+    class PoseExtrapolator
+    {
+    private:
+        double blend_time = 0.0;
+        Transform2D T_start;  // map -> odom when the last correction arrived
+        Transform2D T_target; // map -> odom from the last correction
+        double correction_time = 0.0;
+
+    public:
+        /// @brief an extrapolator whose map and odom frames start out the same
+        /// @param blend_s seconds over which a correction is applied, 0 to apply it at once
+        explicit PoseExtrapolator(double blend_s = 0.0);
+
+        /// @brief sets the time over which a correction is applied
+        /// @param blend_s seconds over which a correction is applied, 0 to apply it at once
+        void set_blend_time(double blend_s);
+
+        /// @brief incorporates a new estimate of the robot in the map
+        /// @param map_pose the estimated pose of the robot in the map
+        /// @param odom_pose the odometry pose the estimate was computed from
+        /// @param now_s the current time in seconds
+        void correct(const Pose2D &map_pose, const Pose2D &odom_pose, double now_s);
+
+        /// @brief the map -> odom transform at a time, part of the way through the blend
+        /// @param now_s the current time in seconds
+        Transform2D map_to_odom(double now_s) const;
+
+        /// @brief the pose of the robot in the map, extrapolated with the odometry
+        /// @param odom_pose the current odometry pose
+        /// @param now_s the current time in seconds
+        Pose2D predict(const Pose2D &odom_pose, double now_s) const;
+
+        /// @brief the map -> odom transform from the last correction, once fully blended
+        Transform2D target() const;
+    };
+
+}
+
+#endif
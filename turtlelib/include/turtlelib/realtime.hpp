@@ -0,0 +1,86 @@
+#ifndef REALTIME_INCLUDE_GUARD_HPP
+#define REALTIME_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Helpers for running node callbacks with real-time scheduling on Linux
+///
+/// A real-time profile locks the memory of the process, reserves a prefaulted heap so
+/// allocations do not page fault, runs the time critical callbacks on threads with
+/// SCHED_FIFO priorities pinned to chosen CPUs, and measures the jitter of the timers.
+/// Most of these need CAP_SYS_NICE and CAP_IPC_LOCK (or matching rlimits), and throw
+/// std::runtime_error when they are not granted.
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "turtlelib/benchmark.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief scheduling of a thread
+    struct ThreadSchedule
+    {
+        /// @brief SCHED_FIFO priority in [1, 99], or 0 for the default scheduler
+        int priority = 0;
+
+        /// @brief the CPUs the thread may run on, or empty for any CPU
+        std::vector<long> cpus{};
+    };
+
+    /// @brief locks all current and future pages of the process in memory
+    /// @throw std::runtime_error if the pages cannot be locked
+    void lock_memory();
+
+    /// @brief stops malloc from returning memory to the system or using mmap, then
+    /// allocates and touches a block of the given size, so the following allocations
+    /// are served from memory which is already mapped (and locked by lock_memory)
+    /// @param bytes the size of the heap to reserve
+    /// @throw std::runtime_error if malloc cannot be configured or the block allocated
+    void reserve_heap(size_t bytes);
+
+    /// @brief applies a schedule to the calling thread
+    /// @param schedule the priority and CPUs of the thread
+    /// @throw std::runtime_error if the priority or affinity cannot be set
+    void apply_thread_schedule(const ThreadSchedule &schedule);
+
+    /// @brief Measures how far the intervals between the ticks of a periodic timer
+    /// deviate from its period
+    class TimerJitter
+    {
+    private:
+        std::chrono::duration<double> period;
+        std::chrono::steady_clock::time_point last_tick{};
+        bool started = false;
+        SampleStats deviation_samples;
+
+    public:
+        /// @brief creates a jitter monitor for a timer
+        /// @param period_s the period of the timer in seconds
+        explicit TimerJitter(double period_s);
+
+        /// @brief records a tick of the timer at the current time
+        void tick();
+
+        /// @brief records a tick of the timer
+        /// @param t the time of the tick
+        void tick(std::chrono::steady_clock::time_point t);
+
+        /// @brief removes the recorded intervals, keeping the time of the last tick
+        void clear();
+
+        /// @brief returns the number of recorded intervals
+        size_t count() const;
+
+        /// @brief returns the deviation of each interval from the period in microseconds,
+        /// positive when the tick came late
+        const SampleStats &deviation_us() const;
+
+        /// @brief one line summary of the deviations
+        /// @param name the name of the timer
+        std::string summary(const std::string &name) const;
+    };
+
+}
+
+#endif
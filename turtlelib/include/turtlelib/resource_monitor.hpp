@@ -0,0 +1,160 @@
+#ifndef RESOURCE_MONITOR_INCLUDE_GUARD_HPP
+#define RESOURCE_MONITOR_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Accounting of the CPU time, memory and message rates of a process, read from
+/// /proc, for capacity planning on the robot
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "turtlelib/benchmark.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief the fields of a /proc/<pid>/stat or /proc/<pid>/task/<tid>/stat line
+    /// needed for accounting
+    struct ProcStat
+    {
+        /// @brief the name of the process or thread
+        std::string name;
+
+        /// @brief CPU time spent in user mode in seconds
+        double user_s = 0.0;
+
+        /// @brief CPU time spent in kernel mode in seconds
+        double system_s = 0.0;
+
+        /// @brief number of threads of the process
+        size_t threads = 0;
+    };
+
+    /// @brief parses a stat line of /proc. The name is the field in parentheses, which
+    /// may itself hold spaces and parentheses
+    /// @param line the contents of the stat file
+    /// @param ticks_per_second the clock ticks per second the times are counted in
+    /// @return the parsed fields
+    /// @throw std::runtime_error if the line is malformed
+    ProcStat parse_proc_stat(const std::string &line, double ticks_per_second);
+
+    /// @brief the CPU use of one thread over a report interval
+    struct ThreadUsage
+    {
+        /// @brief the id of the thread
+        int tid = 0;
+
+        /// @brief the name of the thread
+        std::string name;
+
+        /// @brief CPU time over the interval, as a percentage of one core
+        double cpu_percent = 0.0;
+    };
+
+    /// @brief the messages of one topic over a report interval
+    struct TopicRate
+    {
+        /// @brief the name of the topic
+        std::string topic;
+
+        /// @brief whether the node publishes (true) or subscribes to (false) the topic
+        bool published = false;
+
+        /// @brief number of messages over the interval
+        size_t messages = 0;
+
+        /// @brief messages per second over the interval
+        double rate_hz = 0.0;
+    };
+
+    /// @brief the resources used by a process since the previous report
+    struct ResourceReport
+    {
+        /// @brief length of the interval in seconds
+        double interval_s = 0.0;
+
+        /// @brief CPU time of the whole process over the interval, as a percentage of one
+        /// core
+        double cpu_percent = 0.0;
+
+        /// @brief CPU time of the process since it started, in seconds
+        double total_cpu_s = 0.0;
+
+        /// @brief resident memory in kB
+        size_t rss_kb = 0;
+
+        /// @brief peak resident memory in kB
+        size_t peak_rss_kb = 0;
+
+        /// @brief the threads of the process, busiest first
+        std::vector<ThreadUsage> threads;
+
+        /// @brief the counted topics, in the order they were added
+        std::vector<TopicRate> topics;
+
+        /// @brief returns the report as (key, value) pairs, e.g. for a diagnostic status
+        std::vector<std::pair<std::string, std::string>> key_values() const;
+
+        /// @brief returns a one line summary of the CPU and memory use
+        std::string summary() const;
+    };
+
+    /// @brief Samples the CPU time and memory of this process and its threads from /proc,
+    /// and counts the messages a node publishes and receives
+    ///
+    /// Every report covers the interval since the previous one, or since construction.
+    /// Sampling reads one file per thread, so reports are meant to be taken at a low rate,
+    /// about once a second or slower. Counting is a relaxed atomic increment, so it may be
+    /// done from several executor threads at once, including real-time ones, as long as
+    /// every topic is added before the callbacks start. Without /proc the CPU and memory
+    /// figures are 0.
+    class ResourceMonitor
+    {
+    private:
+        struct Topic
+        {
+            std::string name;
+            bool published = false;
+            std::atomic<size_t> messages{0};
+        };
+
+        std::mutex mutex;
+        std::deque<Topic> topics;
+        Stopwatch since_report;
+        double ticks_per_second = 100.0;
+        double last_cpu_s = 0.0;
+        std::map<int, double> last_thread_cpu_s;
+
+        /// @brief reads the CPU time of the process and of each thread, by thread id
+        double read_cpu(std::map<int, ProcStat> &threads) const;
+
+    public:
+        /// @brief starts the first interval
+        ResourceMonitor();
+
+        /// @brief starts counting the messages published on a topic
+        /// @param topic the name of the topic
+        /// @return the id to count the messages with
+        size_t add_publisher(const std::string &topic);
+
+        /// @brief starts counting the messages received on a topic
+        /// @param topic the name of the topic
+        /// @return the id to count the messages with
+        size_t add_subscription(const std::string &topic);
+
+        /// @brief counts one message
+        /// @param id the id returned by add_publisher or add_subscription
+        void count(size_t id);
+
+        /// @brief samples the process, reports the interval since the previous report and
+        /// starts the next one
+        ResourceReport report();
+    };
+
+}
+
+#endif
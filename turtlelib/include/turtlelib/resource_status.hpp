@@ -0,0 +1,42 @@
+#ifndef RESOURCE_STATUS_INCLUDE_GUARD_HPP
+#define RESOURCE_STATUS_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Diagnostics of a resource report, shared by the nodes which run a ResourceMonitor
+///
+/// Header only, so turtlelib itself does not depend on diagnostic_msgs; the nodes which
+/// include it already do.
+
+#include <string>
+#include "diagnostic_msgs/msg/diagnostic_status.hpp"
+#include "diagnostic_msgs/msg/key_value.hpp"
+#include "turtlelib/resource_monitor.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief describes the CPU time, memory, and message rates of a node over the
+    /// interval of a resource report
+    /// @param report the report
+    /// @param node_name the name of the node
+    /// @return the diagnostic status, always OK since there are no limits to check against
+    inline diagnostic_msgs::msg::DiagnosticStatus resource_status(const ResourceReport &report,
+                                                                  const std::string &node_name)
+    {
+        diagnostic_msgs::msg::DiagnosticStatus status;
+        status.name = node_name + ": resources";
+        status.hardware_id = node_name;
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+        status.message = report.summary();
+        for (const auto &[key, value] : report.key_values())
+        {
+            diagnostic_msgs::msg::KeyValue kv;
+            kv.key = key;
+            kv.value = value;
+            status.values.push_back(kv);
+        }
+        return status;
+    }
+
+}
+
+#endif
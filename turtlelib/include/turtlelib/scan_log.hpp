@@ -0,0 +1,114 @@
+#ifndef SCAN_LOG_INCLUDE_GUARD_HPP
+#define SCAN_LOG_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Recordings of LIDAR scans together with the ground truth they were taken in,
+/// for tuning and evaluating landmark detectors offline
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+#include "turtlelib/rigid2d.hpp"
+#include "turtlelib/diff_drive.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief one LIDAR scan and the true state of the world when it was taken
+    struct RecordedScan
+    {
+        /// @brief time of the scan in seconds
+        double stamp = 0.0;
+
+        /// @brief the true pose of the sensor in the world frame
+        Pose2D pose{0.0, 0.0, 0.0};
+
+        /// @brief angle of the first beam in radians
+        double angle_min = 0.0;
+
+        /// @brief angle between consecutive beams in radians
+        double angle_increment = 0.0;
+
+        /// @brief the range of each beam in meters, 0.0 for no return
+        std::vector<float> ranges;
+
+        /// @brief the true centers of the obstacles in the world frame
+        std::vector<Vector2D> obstacles;
+    };
+
+    /// @brief a recording of scans
+    struct ScanLog
+    {
+        /// @brief radius of the obstacles in meters
+        double obstacle_radius = 0.0;
+
+        /// @brief the scans in the order they were recorded
+        std::vector<RecordedScan> scans;
+    };
+
+    /// @brief the outcome of comparing detections with the ground truth
+    struct DetectionScore
+    {
+        /// @brief detections within the match distance of a visible obstacle
+        size_t true_positives = 0;
+
+        /// @brief detections which match no visible obstacle
+        size_t false_positives = 0;
+
+        /// @brief visible obstacles which no detection matches
+        size_t false_negatives = 0;
+
+        /// @brief returns the fraction of the detections which are obstacles, 1 without
+        /// detections
+        double precision() const;
+
+        /// @brief returns the fraction of the visible obstacles which were detected, 1
+        /// without visible obstacles
+        double recall() const;
+
+        /// @brief adds the counts of another score
+        DetectionScore &operator+=(const DetectionScore &rhs);
+    };
+
+    /// @brief writes the header of a scan log: the magic "TSCN", a uint32 version and the
+    /// obstacle radius as a double. Numbers are written in the byte order of the machine
+    /// @param os the stream to write to, which should be opened in binary mode
+    /// @param obstacle_radius radius of the obstacles in meters
+    void write_scan_log_header(std::ostream &os, double obstacle_radius);
+
+    /// @brief appends a scan to a scan log: the stamp, pose (x, y, theta), angle_min and
+    /// angle_increment as doubles, a uint64 range count followed by the ranges as floats,
+    /// and a uint64 obstacle count followed by the x, y of each obstacle as doubles
+    /// @param os the stream to write to, which should be opened in binary mode
+    /// @param scan the scan to write
+    void write_recorded_scan(std::ostream &os, const RecordedScan &scan);
+
+    /// @brief reads a scan log written by write_scan_log_header and write_recorded_scan.
+    /// A scan cut short at the end of the stream, as when the recording was interrupted,
+    /// is dropped
+    /// @param is the stream to read from, which should be opened in binary mode
+    /// @return the scan log
+    /// @throw std::runtime_error if the stream does not start with a valid header
+    ScanLog read_scan_log(std::istream &is);
+
+    /// @brief returns the obstacles the scan actually hit, in the frame of the sensor.
+    /// An obstacle was hit when enough returns lie within tolerance of its surface
+    /// @param scan the scan
+    /// @param obstacle_radius radius of the obstacles in meters
+    /// @param tolerance how far from the surface a return may be, in meters
+    /// @param min_returns the fewest returns that count as a hit
+    std::vector<Vector2D> visible_obstacles(
+        const RecordedScan &scan, double obstacle_radius, double tolerance,
+        size_t min_returns = 1);
+
+    /// @brief matches detected landmarks to visible obstacles, greedily closest first.
+    /// Each obstacle matches at most one detection
+    /// @param detections the detected landmark centers
+    /// @param truth the visible obstacle centers, in the same frame
+    /// @param match_distance the farthest a detection may be from its obstacle, in meters
+    DetectionScore score_detections(
+        const std::vector<Vector2D> &detections, const std::vector<Vector2D> &truth,
+        double match_distance);
+
+}
+
+#endif
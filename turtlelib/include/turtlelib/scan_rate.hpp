@@ -0,0 +1,139 @@
+#ifndef SCAN_RATE_INCLUDE_GUARD_HPP
+#define SCAN_RATE_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Chooses how often to process lidar scans from the uncertainty of the SLAM pose
+/// and the speed of the robot
+
+#include <array>
+#include <cstddef>
+
+namespace turtlelib
+{
+
+    /// @brief bounds and thresholds of the scan rate controller
+    struct ScanRateParams
+    {
+        /// @brief scans processed per second when the pose is certain and the robot slow
+        double min_rate = 1.0;
+
+        /// @brief most scans processed per second, when the pose is uncertain or the
+        /// robot fast
+        double max_rate = 5.0;
+
+        /// @brief standard deviation of the position, in m, below which it is certain
+        double confident_position_std = 0.02;
+
+        /// @brief standard deviation of the position, in m, above which it is uncertain
+        double uncertain_position_std = 0.1;
+
+        /// @brief standard deviation of the heading, in rad, below which it is certain
+        double confident_heading_std = 0.02;
+
+        /// @brief standard deviation of the heading, in rad, above which it is uncertain
+        double uncertain_heading_std = 0.1;
+
+        /// @brief linear speed in m/s below which the robot is slow
+        double slow_speed = 0.02;
+
+        /// @brief linear speed in m/s above which the robot is fast
+        double fast_speed = 0.1;
+
+        /// @brief turn rate in rad/s below which the robot is slow
+        double slow_turn_rate = 0.1;
+
+        /// @brief turn rate in rad/s above which the robot is fast
+        double fast_turn_rate = 0.5;
+
+        /// @brief seconds after which an uncertainty or speed is too old to rely on, and
+        /// scans are processed at max_rate again. Longer than the period of min_rate, as
+        /// the estimates only arrive after the scans which are processed
+        double timeout = 2.0;
+    };
+
+    /// @brief Throttles the scans fed to landmark detection and the EKF update
+    ///
+    /// The demand for scans is a number from 0 to 1, the largest of the uncertainty of the
+    /// position and heading and the linear and turn speeds, each placed linearly between
+    /// its confident (or slow) and uncertain (or fast) thresholds. The target rate goes
+    /// linearly from min_rate at no demand to max_rate at full demand. Demand is full
+    /// until both an uncertainty and a speed have been given, and when either is older
+    /// than the timeout, so a stalled estimator never starves itself of scans.
+    ///
+    /// A scan is accepted when the target period has passed since the last accepted
+    /// one, less half the interval between scans, so a rate which the sensor rate does
+    /// not divide is rounded to the nearest scan rather than always down.
+    class ScanRateController
+    {
+    private:
+        ScanRateParams params;
+        bool have_uncertainty = false;
+        double uncertainty_stamp = 0.0;
+        double position_std = 0.0;
+        double heading_std = 0.0;
+        bool have_speed = false;
+        double speed_stamp = 0.0;
+        double speed = 0.0;
+        double turn_rate = 0.0;
+        bool have_scan = false;
+        double last_scan = 0.0;
+        double scan_interval = 0.0;
+        bool have_accepted = false;
+        double last_accepted = 0.0;
+        size_t n_accepted = 0;
+        size_t n_skipped = 0;
+
+    public:
+        /// @brief a controller with the default parameters
+        ScanRateController();
+
+        /// @brief a controller with the given bounds and thresholds
+        /// @param params the bounds and thresholds
+        /// @throw std::invalid_argument if a rate or timeout is not positive, a lower
+        /// bound or threshold is above its upper one, or the timeout is shorter than the
+        /// period of min_rate
+        explicit ScanRateController(const ScanRateParams &params);
+
+        /// @brief sets the uncertainty of the pose from its covariance
+        /// @param stamp the time of the estimate in seconds
+        /// @param pose_covariance the covariance of (theta, x, y), row major. The position
+        /// uses the standard deviation along its most uncertain direction
+        void set_pose_covariance(double stamp, const std::array<double, 9> &pose_covariance);
+
+        /// @brief sets the uncertainty of the pose
+        /// @param stamp the time of the estimate in seconds
+        /// @param position_std standard deviation of the position in m
+        /// @param heading_std standard deviation of the heading in rad
+        void set_uncertainty(double stamp, double position_std, double heading_std);
+
+        /// @brief sets the speed of the robot
+        /// @param stamp the time of the measurement in seconds
+        /// @param speed linear speed in m/s, of either sign
+        /// @param turn_rate angular speed in rad/s, of either sign
+        void set_speed(double stamp, double speed, double turn_rate);
+
+        /// @brief returns the demand for scans, from 0 to 1
+        /// @param stamp the current time in seconds
+        double demand(double stamp) const;
+
+        /// @brief returns the target rate of processed scans in Hz
+        /// @param stamp the current time in seconds
+        double rate(double stamp) const;
+
+        /// @brief decides whether to process a scan, and counts the decision
+        /// @param stamp the time the scan arrived in seconds
+        /// @return true if the scan should be processed
+        bool accept(double stamp);
+
+        /// @brief returns the number of accepted scans
+        size_t accepted() const;
+
+        /// @brief returns the number of skipped scans
+        size_t skipped() const;
+
+        /// @brief sets the counts of accepted and skipped scans to 0
+        void reset_counts();
+    };
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef SCENARIO_INCLUDE_GUARD_HPP
+#define SCENARIO_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Scripted robot missions made of timed twists and waypoints
+///
+/// A scenario file is a plain text file with one command per line. Text after a '#'
+/// is ignored. The commands are:
+///     start <x> <y> <theta>         pose at which the mission starts (default 0 0 0),
+///                                   only used to plan waypoints
+///     twist <seconds> <v> <w>       drive with linear velocity v and angular velocity w
+///     wait <seconds>                stand still
+///     waypoint <x> <y> [v] [w]      turn in place at w (default 0.5 rad/s), then drive
+///                                   straight at v (default 0.1 m/s) to the point (x, y)
+/// Waypoints are planned open loop from the pose the previous commands end at, so the
+/// resulting twists only depend on the file and are the same on every run.
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+#include "turtlelib/rigid2d.hpp"
+#include "turtlelib/diff_drive.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief a constant body twist held for some time
+    struct ScenarioStep
+    {
+        /// @brief how long the twist is held in seconds
+        double duration = 0.0;
+
+        /// @brief the commanded body twist
+        Twist2D twist{};
+    };
+
+    /// @brief a mission as a sequence of timed twists
+    class Scenario
+    {
+    private:
+        std::vector<ScenarioStep> steps;
+
+        // time at which each step ends
+        std::vector<double> end_times;
+
+        Pose2D planned_pose{};
+
+    public:
+        /// @brief creates an empty scenario
+        Scenario() = default;
+
+        /// @brief creates an empty scenario whose waypoints are planned from the given pose
+        /// @param start the pose at which the mission starts
+        explicit Scenario(const Pose2D &start);
+
+        /// @brief appends a timed twist
+        /// @param duration how long the twist is held in seconds
+        /// @param twist the commanded body twist
+        void add_twist(double duration, const Twist2D &twist);
+
+        /// @brief appends the twists which drive from the end of the scenario to a point
+        /// by turning in place, then driving straight
+        /// @param goal the point to drive to
+        /// @param speed the linear speed in m/s
+        /// @param turn_rate the angular speed in rad/s
+        void add_waypoint(const Vector2D &goal, double speed, double turn_rate);
+
+        /// @brief returns the steps of the scenario
+        const std::vector<ScenarioStep> &get_steps() const;
+
+        /// @brief returns the pose reached at the end of the scenario if the robot
+        /// followed the twists exactly
+        Pose2D end_pose() const;
+
+        /// @brief returns the total duration of the scenario in seconds
+        double duration() const;
+
+        /// @brief returns the twist commanded at a time since the start of the scenario
+        /// @param t the time in seconds
+        /// @return the twist, which is zero before the start and after the end
+        Twist2D twist_at(double t) const;
+    };
+
+    /// @brief parses a scenario file
+    /// @param is the stream to read the scenario from
+    /// @return the scenario
+    /// @throw std::runtime_error with the line number if a line is not a valid command
+    Scenario parse_scenario(std::istream &is);
+
+}
+
+#endif
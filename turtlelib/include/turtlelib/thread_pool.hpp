@@ -0,0 +1,78 @@
+#ifndef THREAD_POOL_INCLUDE_GUARD_HPP
+#define THREAD_POOL_INCLUDE_GUARD_HPP
+/// @file
+/// @brief A fixed set of worker threads which split a range of independent work items
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace turtlelib
+{
+
+    /// @brief Splits a range of independent work items across a fixed set of threads
+    ///
+    /// The range is cut into one contiguous chunk per thread, and the calling thread
+    /// works on the first chunk itself, so a pool of N threads starts N - 1 workers. The
+    /// workers are started once and sleep between jobs; they run with the scheduling of
+    /// the thread which constructed the pool. One job runs at a time: concurrent calls to
+    /// parallel_for() wait for each other.
+    class ThreadPool
+    {
+    private:
+        std::vector<std::thread> workers;
+
+        /// @brief serializes calls to parallel_for()
+        std::mutex job_mutex;
+
+        /// @brief guards the job below
+        std::mutex mutex;
+        std::condition_variable start;
+        std::condition_variable done;
+        const std::function<void(size_t, size_t, size_t)> *job = nullptr;
+        size_t job_count = 0;
+        size_t generation = 0;
+        size_t pending = 0;
+        bool stopping = false;
+        std::exception_ptr error;
+
+        /// @brief returns the first item of a chunk of the current job
+        size_t chunk_begin(size_t chunk) const;
+
+        /// @brief runs one chunk of the current job, keeping the first exception
+        void run_chunk(size_t chunk);
+
+        /// @brief waits for jobs and runs its chunk of each
+        void work(size_t chunk);
+
+    public:
+        /// @brief starts the workers
+        /// @param threads the threads to split work across, including the caller
+        /// @throw std::invalid_argument if threads is 0
+        explicit ThreadPool(size_t threads);
+
+        /// @brief stops and joins the workers
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /// @brief returns the threads work is split across, including the caller
+        size_t size() const;
+
+        /// @brief calls fn(chunk, begin, end) for contiguous chunks covering [0, count),
+        /// one per thread, and returns when all have finished. Chunks are numbered from 0
+        /// in the order of their items, so fn can keep scratch memory per chunk
+        /// @param count the number of items
+        /// @param fn the work on the items [begin, end) of one chunk
+        /// @throw the first exception thrown by fn, after every chunk has finished
+        void parallel_for(size_t count, const std::function<void(size_t, size_t, size_t)> &fn);
+    };
+
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef WATCHDOG_INCLUDE_GUARD_HPP
+#define WATCHDOG_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Watchdog which checks callback durations against budgets and keeps track of
+/// how far behind and how lossy each subscription is
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "turtlelib/benchmark.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief a callback which ran longer than its budget
+    struct Overrun
+    {
+        /// @brief the name of the callback
+        std::string callback;
+
+        /// @brief how long the callback ran in microseconds
+        double duration_us = 0.0;
+
+        /// @brief the budget of the callback in microseconds
+        double budget_us = 0.0;
+    };
+
+    /// @brief what the watchdog knows about one callback since the last reset
+    struct CallbackHealth
+    {
+        /// @brief the name of the callback
+        std::string name;
+
+        /// @brief the longest the callback may run in microseconds, 0 for no limit
+        double budget_us = 0.0;
+
+        /// @brief number of invocations
+        size_t calls = 0;
+
+        /// @brief number of invocations which ran longer than the budget
+        size_t overruns = 0;
+
+        /// @brief longest invocation in microseconds
+        double max_duration_us = 0.0;
+
+        /// @brief number of messages the middleware reported lost
+        size_t messages_lost = 0;
+
+        /// @brief oldest message handled, in seconds from its stamp to the callback
+        double max_message_age_s = 0.0;
+
+        /// @brief largest estimated number of messages waiting behind a handled message
+        size_t max_queue_depth = 0;
+    };
+
+    /// @brief Checks the duration of every callback against a budget, and estimates
+    /// the queue depth of subscriptions from the age of their messages
+    ///
+    /// The middleware does not expose the queue of a subscription, so the depth is
+    /// estimated as the age of the message being handled divided by the period at
+    /// which messages are stamped: a message which waited for three periods has about
+    /// three newer messages queued behind it. All members may be called from several
+    /// executor threads at once.
+    class CallbackWatchdog
+    {
+    private:
+        struct Entry
+        {
+            CallbackHealth health;
+            double last_stamp_s = 0.0;
+            double period_s = 0.0;
+        };
+
+        mutable std::mutex mutex;
+        std::vector<Entry> entries;
+        std::vector<Overrun> pending_overruns;
+
+    public:
+        /// @brief Measures one invocation of a callback from construction to destruction
+        class Scope
+        {
+        private:
+            CallbackWatchdog &watchdog;
+            size_t id;
+            Stopwatch stopwatch;
+
+        public:
+            /// @brief starts measuring an invocation
+            /// @param w the watchdog to report to
+            /// @param callback_id the id returned by add_callback
+            Scope(CallbackWatchdog &w, size_t callback_id);
+
+            /// @brief stops measuring and reports the duration to the watchdog
+            ~Scope();
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+        };
+
+        /// @brief starts watching a callback
+        /// @param name the name of the callback
+        /// @param budget_us the longest the callback may run in microseconds, 0 for no limit
+        /// @return the id of the callback
+        size_t add_callback(const std::string &name, double budget_us);
+
+        /// @brief records the duration of an invocation
+        /// @param id the id of the callback
+        /// @param duration_us how long the invocation ran in microseconds
+        /// @return true if the invocation overran its budget
+        bool record_duration(size_t id, double duration_us);
+
+        /// @brief records the stamp of a message when its callback starts
+        /// @param id the id of the callback
+        /// @param stamp_s the stamp of the message in seconds
+        /// @param now_s the current time in seconds, on the same clock as the stamp
+        void record_message(size_t id, double stamp_s, double now_s);
+
+        /// @brief records messages the middleware reported lost
+        /// @param id the id of the callback
+        /// @param count the number of newly lost messages
+        void record_lost(size_t id, size_t count);
+
+        /// @brief returns the overruns since the last call and forgets them
+        std::vector<Overrun> take_overruns();
+
+        /// @brief returns what is known about a callback since the last reset
+        CallbackHealth health(size_t id) const;
+
+        /// @brief returns the number of watched callbacks
+        size_t size() const;
+
+        /// @brief clears the counts of every callback, keeping their budgets
+        void reset();
+    };
+
+}
+
+#endif
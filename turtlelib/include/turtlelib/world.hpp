@@ -0,0 +1,114 @@
+#ifndef WORLD_INCLUDE_GUARD_HPP
+#define WORLD_INCLUDE_GUARD_HPP
+/// @file
+/// @brief Procedural generation of simulator worlds filled with cylindrical obstacles
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "turtlelib/rigid2d.hpp"
+
+namespace turtlelib
+{
+
+    /// @brief parameters of a generated world. The world is a rectangular arena
+    /// centered at the origin, surrounded by walls, which contains randomly placed
+    /// obstacles and optional corridors
+    struct WorldParams
+    {
+        /// @brief length of the arena along x in meters
+        double x_length = 5.0;
+
+        /// @brief length of the arena along y in meters
+        double y_length = 5.0;
+
+        /// @brief radius of the obstacles in meters
+        double obstacle_radius = 0.038;
+
+        /// @brief number of randomly placed obstacles per square meter of arena
+        double density = 0.5;
+
+        /// @brief fraction in [0, 1] of the random obstacles which are placed
+        /// around cluster centers instead of uniformly over the arena
+        double clustering = 0.0;
+
+        /// @brief number of cluster centers, 0 for one cluster per 10 obstacles
+        size_t clusters = 0;
+
+        /// @brief radius around a cluster center in which its obstacles are placed
+        double cluster_radius = 0.5;
+
+        /// @brief minimum distance between the center of a random obstacle and any other
+        /// obstacle. Corridor walls are only spaced by post_spacing
+        double min_spacing = 0.3;
+
+        /// @brief number of corridors. A corridor is a pair of parallel, axis aligned
+        /// walls built from rows of obstacles, since the simulator only has cylinders
+        size_t corridors = 0;
+
+        /// @brief distance between the two walls of a corridor in meters
+        double corridor_width = 1.0;
+
+        /// @brief length of each corridor in meters, 0 for half the arena
+        double corridor_length = 0.0;
+
+        /// @brief distance between neighboring obstacles of a corridor wall
+        double post_spacing = 0.15;
+
+        /// @brief no obstacle is placed within this distance of the origin, so the
+        /// robot can start there
+        double start_clearance = 0.5;
+
+        /// @brief seed of the random number generator
+        uint32_t seed = 0;
+    };
+
+    /// @brief a generated world
+    struct World
+    {
+        /// @brief length of the arena along x in meters
+        double x_length = 0.0;
+
+        /// @brief length of the arena along y in meters
+        double y_length = 0.0;
+
+        /// @brief radius of the obstacles in meters
+        double obstacle_radius = 0.0;
+
+        /// @brief the centers of the obstacles
+        std::vector<Vector2D> obstacles;
+    };
+
+    /// @brief generates a world. The same parameters always generate the same world,
+    /// since the standard library distributions (whose output differs between
+    /// implementations) are not used. Random obstacles which cannot be placed while
+    /// keeping the minimum spacing are left out.
+    /// @param params the parameters of the world
+    /// @return the generated world
+    World generate_world(const WorldParams &params);
+
+    /// @brief writes the world as a nusim parameter file
+    /// @param world the world to write
+    /// @param os the stream to write to
+    /// @param node_name name of the node the parameters are for
+    void write_world_yaml(const World &world, std::ostream &os, const std::string &node_name = "nusim");
+
+    /// @brief writes the world in a compact binary format: the magic "TWLD", a uint32
+    /// version, the arena lengths and obstacle radius as doubles, a uint64 obstacle
+    /// count followed by the x, y coordinates of each obstacle as doubles. Numbers are
+    /// written in the byte order of the machine
+    /// @param world the world to write
+    /// @param os the stream to write to, which should be opened in binary mode
+    void write_world_binary(const World &world, std::ostream &os);
+
+    /// @brief reads a world written by write_world_binary
+    /// @param is the stream to read from, which should be opened in binary mode
+    /// @return the world
+    /// @throw std::runtime_error if the stream does not contain a valid world
+    World read_world_binary(std::istream &is);
+
+}
+
+#endif
@@ -0,0 +1,159 @@
+/// @file
+/// @brief Replacement global operator new and operator delete which count the heap
+/// activity of each thread. Built as the separate alloc_hooks library so only the
+/// executables which link it pay for the counting.
+
+#include "turtlelib/alloc_tracker.hpp"
+#include <cstdlib>
+#include <new>
+
+/// @cond
+namespace
+{
+
+    void *allocate(std::size_t size)
+    {
+        turtlelib::detail::record_allocation(size);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void *allocate_aligned(std::size_t size, std::align_val_t alignment)
+    {
+        turtlelib::detail::record_allocation(size);
+        const std::size_t align = static_cast<std::size_t>(alignment);
+        // aligned_alloc requires the size to be a multiple of the alignment
+        const std::size_t rounded = ((size == 0 ? 1 : size) + align - 1) / align * align;
+        return std::aligned_alloc(align, rounded);
+    }
+
+    void deallocate(void *ptr) noexcept
+    {
+        if (ptr)
+        {
+            turtlelib::detail::record_deallocation();
+            std::free(ptr);
+        }
+    }
+
+    struct EnableTracking
+    {
+        EnableTracking()
+        {
+            turtlelib::detail::set_allocation_tracking_enabled();
+        }
+    };
+
+    const EnableTracking enable_tracking;
+
+}
+
+void *operator new(std::size_t size)
+{
+    void *ptr = allocate(size);
+    if (not ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    void *ptr = allocate_aligned(size, alignment);
+    if (not ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate_aligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate_aligned(size, alignment);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    deallocate(ptr);
+}
+/// @endcond
@@ -0,0 +1,136 @@
+#include "turtlelib/alloc_tracker.hpp"
+#include <atomic>
+#include <sstream>
+
+namespace turtlelib
+{
+
+    namespace
+    {
+        // constant initialized and trivially destructible, so they are safe to use
+        // from operator new at any point in the life of a thread
+        thread_local AllocationCounts thread_counts;
+        std::atomic<bool> hooks_linked{false};
+    }
+
+    namespace detail
+    {
+        void record_allocation(size_t bytes) noexcept
+        {
+            thread_counts.allocations++;
+            thread_counts.bytes += bytes;
+        }
+
+        void record_deallocation() noexcept
+        {
+            thread_counts.deallocations++;
+        }
+
+        void set_allocation_tracking_enabled() noexcept
+        {
+            hooks_linked.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    bool allocation_tracking_enabled()
+    {
+        return hooks_linked.load(std::memory_order_relaxed);
+    }
+
+    AllocationCounts thread_allocation_counts()
+    {
+        return thread_counts;
+    }
+
+    // ===================
+    //   AllocationScope
+    // ===================
+
+    AllocationScope::AllocationScope()
+        : start(thread_counts)
+    {
+    }
+
+    void AllocationScope::reset()
+    {
+        start = thread_counts;
+    }
+
+    AllocationCounts AllocationScope::counts() const
+    {
+        return AllocationCounts{thread_counts.allocations - start.allocations,
+                                thread_counts.deallocations - start.deallocations,
+                                thread_counts.bytes - start.bytes};
+    }
+
+    // ===================
+    //   CallbackProfile
+    // ===================
+
+    CallbackProfile::Sample::Sample(CallbackProfile &p)
+        : profile(p)
+    {
+    }
+
+    CallbackProfile::Sample::~Sample()
+    {
+        // read both before adding, which may itself allocate
+        const double time_us = stopwatch.elapsed_us();
+        const AllocationCounts counts = scope.counts();
+        profile.add(time_us, counts);
+    }
+
+    void CallbackProfile::add(double time_us, const AllocationCounts &counts)
+    {
+        time_samples.add(time_us);
+        allocation_samples.add(static_cast<double>(counts.allocations));
+        byte_samples.add(static_cast<double>(counts.bytes));
+    }
+
+    void CallbackProfile::clear()
+    {
+        time_samples.clear();
+        allocation_samples.clear();
+        byte_samples.clear();
+    }
+
+    size_t CallbackProfile::count() const
+    {
+        return time_samples.count();
+    }
+
+    const SampleStats &CallbackProfile::time_us() const
+    {
+        return time_samples;
+    }
+
+    const SampleStats &CallbackProfile::allocations() const
+    {
+        return allocation_samples;
+    }
+
+    const SampleStats &CallbackProfile::bytes() const
+    {
+        return byte_samples;
+    }
+
+    std::string CallbackProfile::summary(const std::string &name) const
+    {
+        std::ostringstream ss;
+        ss << name << ": " << count() << " calls, time p50 " << time_samples.percentile(50.0)
+           << " us p99 " << time_samples.percentile(99.0) << " us max " << time_samples.max()
+           << " us";
+        if (allocation_tracking_enabled())
+        {
+            ss << ", allocations mean " << allocation_samples.mean() << " max "
+               << allocation_samples.max() << ", bytes mean " << byte_samples.mean() << " max "
+               << byte_samples.max();
+        }
+        else
+        {
+            ss << ", allocations not tracked";
+        }
+        return ss.str();
+    }
+
+}
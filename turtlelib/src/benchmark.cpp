@@ -0,0 +1,336 @@
+#include "turtlelib/benchmark.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace turtlelib
+{
+
+    // =============
+    //   Stopwatch
+    // =============
+
+    Stopwatch::Stopwatch()
+        : t_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    void Stopwatch::reset()
+    {
+        t_start = std::chrono::steady_clock::now();
+    }
+
+    double Stopwatch::elapsed_us() const
+    {
+        const std::chrono::duration<double, std::micro> dt = std::chrono::steady_clock::now() - t_start;
+        return dt.count();
+    }
+
+    double Stopwatch::elapsed_s() const
+    {
+        const std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t_start;
+        return dt.count();
+    }
+
+    // ===============
+    //   SampleStats
+    // ===============
+
+    void SampleStats::add(double value)
+    {
+        samples.push_back(value);
+        sum += value;
+    }
+
+    void SampleStats::clear()
+    {
+        samples.clear();
+        sum = 0.0;
+    }
+
+    size_t SampleStats::count() const
+    {
+        return samples.size();
+    }
+
+    double SampleStats::mean() const
+    {
+        if (samples.empty())
+        {
+            return 0.0;
+        }
+        return sum / static_cast<double>(samples.size());
+    }
+
+    double SampleStats::min() const
+    {
+        if (samples.empty())
+        {
+            return 0.0;
+        }
+        return *std::min_element(samples.begin(), samples.end());
+    }
+
+    double SampleStats::max() const
+    {
+        if (samples.empty())
+        {
+            return 0.0;
+        }
+        return *std::max_element(samples.begin(), samples.end());
+    }
+
+    double SampleStats::total() const
+    {
+        return sum;
+    }
+
+    double SampleStats::percentile(double p) const
+    {
+        if (samples.empty())
+        {
+            return 0.0;
+        }
+
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        p = std::clamp(p, 0.0, 100.0);
+        const double rank = (p / 100.0) * static_cast<double>(sorted.size() - 1);
+        const size_t lo = static_cast<size_t>(std::floor(rank));
+        const size_t hi = static_cast<size_t>(std::ceil(rank));
+        const double frac = rank - static_cast<double>(lo);
+        return sorted.at(lo) + frac * (sorted.at(hi) - sorted.at(lo));
+    }
+
+    // =============
+    //   Histogram
+    // =============
+
+    Histogram::Histogram(const std::vector<double> &edges)
+        : upper_edges(edges), bucket_counts(edges.size() + 1, 0)
+    {
+        if (not std::is_sorted(upper_edges.begin(), upper_edges.end()) or
+            std::adjacent_find(upper_edges.begin(), upper_edges.end()) != upper_edges.end())
+        {
+            throw std::invalid_argument("Histogram edges must be increasing");
+        }
+    }
+
+    void Histogram::add(double value)
+    {
+        const auto it = std::lower_bound(upper_edges.begin(), upper_edges.end(), value);
+        bucket_counts.at(static_cast<size_t>(it - upper_edges.begin()))++;
+    }
+
+    void Histogram::clear()
+    {
+        std::fill(bucket_counts.begin(), bucket_counts.end(), 0);
+    }
+
+    const std::vector<double> &Histogram::edges() const
+    {
+        return upper_edges;
+    }
+
+    const std::vector<size_t> &Histogram::counts() const
+    {
+        return bucket_counts;
+    }
+
+    size_t Histogram::total() const
+    {
+        return std::accumulate(bucket_counts.begin(), bucket_counts.end(), size_t{0});
+    }
+
+    // ==========
+    //   Memory
+    // ==========
+
+    namespace
+    {
+        // reads a "Name:   value kB" field from /proc/self/status
+        size_t read_status_kb(const std::string &field)
+        {
+            std::ifstream status("/proc/self/status");
+            std::string name;
+            while (status >> name)
+            {
+                if (name == field)
+                {
+                    size_t kb = 0;
+                    status >> kb;
+                    return kb;
+                }
+                status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }
+            return 0;
+        }
+    }
+
+    size_t resident_memory_kb()
+    {
+        return read_status_kb("VmRSS:");
+    }
+
+    size_t peak_resident_memory_kb()
+    {
+        return read_status_kb("VmHWM:");
+    }
+
+    // ==============
+    //   JsonWriter
+    // ==============
+
+    JsonWriter::JsonWriter(std::ostream &out)
+        : os(out)
+    {
+    }
+
+    void JsonWriter::separate()
+    {
+        // values directly after a key never need a comma
+        if (after_key)
+        {
+            after_key = false;
+            return;
+        }
+        if (not first_member.empty())
+        {
+            if (not first_member.back())
+            {
+                os << ",";
+            }
+            first_member.back() = false;
+        }
+    }
+
+    void JsonWriter::begin_object()
+    {
+        separate();
+        os << "{";
+        first_member.push_back(true);
+    }
+
+    void JsonWriter::end_object()
+    {
+        first_member.pop_back();
+        os << "}";
+    }
+
+    void JsonWriter::begin_array()
+    {
+        separate();
+        os << "[";
+        first_member.push_back(true);
+    }
+
+    void JsonWriter::end_array()
+    {
+        first_member.pop_back();
+        os << "]";
+    }
+
+    void JsonWriter::key(const std::string &name)
+    {
+        value(name);
+        os << ":";
+        after_key = true;
+    }
+
+    void JsonWriter::value(double v)
+    {
+        separate();
+        if (std::isfinite(v))
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.9g", v);
+            os << buf;
+        }
+        else
+        {
+            os << "null";
+        }
+    }
+
+    void JsonWriter::value(long long v)
+    {
+        separate();
+        os << v;
+    }
+
+    void JsonWriter::value(int v)
+    {
+        value(static_cast<long long>(v));
+    }
+
+    void JsonWriter::value(size_t v)
+    {
+        separate();
+        os << v;
+    }
+
+    void JsonWriter::value(bool v)
+    {
+        separate();
+        os << (v ? "true" : "false");
+    }
+
+    void JsonWriter::value(const std::string &v)
+    {
+        separate();
+        os << "\"";
+        for (const char c : v)
+        {
+            switch (c)
+            {
+            case '"':
+                os << "\\\"";
+                break;
+            case '\\':
+                os << "\\\\";
+                break;
+            case '\n':
+                os << "\\n";
+                break;
+            case '\t':
+                os << "\\t";
+                break;
+            default:
+                os << c;
+            }
+        }
+        os << "\"";
+    }
+
+    void JsonWriter::value(const char *v)
+    {
+        value(std::string{v});
+    }
+
+    void JsonWriter::value(const SampleStats &stats)
+    {
+        begin_object();
+        key("count");
+        value(stats.count());
+        key("mean");
+        value(stats.mean());
+        key("min");
+        value(stats.min());
+        key("max");
+        value(stats.max());
+        key("p50");
+        value(stats.percentile(50.0));
+        key("p90");
+        value(stats.percentile(90.0));
+        key("p99");
+        value(stats.percentile(99.0));
+        end_object();
+    }
+
+}
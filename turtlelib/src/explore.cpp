@@ -0,0 +1,212 @@
+#include "turtlelib/explore.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace turtlelib
+{
+
+    namespace
+    {
+        /// @brief distance from p to the segment from a to b
+        double distance_to_segment(const Vector2D &p, const Vector2D &a, const Vector2D &b)
+        {
+            const Vector2D ab = b - a;
+            const double len2 = ab.x * ab.x + ab.y * ab.y;
+            if (len2 <= 0.0)
+            {
+                return distance(p, a);
+            }
+            const double t = std::clamp(((p.x - a.x) * ab.x + (p.y - a.y) * ab.y) / len2, 0.0, 1.0);
+            return distance(p, a + ab * t);
+        }
+    }
+
+    ExplorationPlanner::ExplorationPlanner() : ExplorationPlanner(ExplorationParams{})
+    {
+    }
+
+    ExplorationPlanner::ExplorationPlanner(const ExplorationParams &p) : params(p)
+    {
+        if (params.x_length <= 0.0 or params.y_length <= 0.0 or params.cell_size <= 0.0)
+        {
+            throw std::invalid_argument("The arena and its cells must have a positive size");
+        }
+        if (params.sensor_range <= 0.0 or params.measurement_variance <= 0.0)
+        {
+            throw std::invalid_argument("The sensor range and measurement variance must be positive");
+        }
+        if (params.radii.empty() or params.headings == 0)
+        {
+            throw std::invalid_argument("The planner needs at least one radius and heading");
+        }
+        n_cols = static_cast<size_t>(std::ceil(params.x_length / params.cell_size));
+        n_rows = static_cast<size_t>(std::ceil(params.y_length / params.cell_size));
+        explored.assign(n_cols * n_rows, false);
+    }
+
+    void ExplorationPlanner::observe(const Pose2D &pose)
+    {
+        const double x0 = params.arena_center.x - params.x_length / 2.0;
+        const double y0 = params.arena_center.y - params.y_length / 2.0;
+        const Vector2D robot{pose.x, pose.y};
+        for (size_t r = 0; r < n_rows; r++)
+        {
+            for (size_t c = 0; c < n_cols; c++)
+            {
+                const Vector2D cell{x0 + (c + 0.5) * params.cell_size, y0 + (r + 0.5) * params.cell_size};
+                if (not explored.at(r * n_cols + c) and distance(cell, robot) <= params.sensor_range)
+                {
+                    explored.at(r * n_cols + c) = true;
+                    n_explored++;
+                }
+            }
+        }
+    }
+
+    double ExplorationPlanner::explored_fraction() const
+    {
+        return static_cast<double>(n_explored) / static_cast<double>(explored.size());
+    }
+
+    size_t ExplorationPlanner::unexplored_in_range(const Vector2D &p) const
+    {
+        // only the cells in the bounding box of the sensor range are checked
+        const double x0 = params.arena_center.x - params.x_length / 2.0;
+        const double y0 = params.arena_center.y - params.y_length / 2.0;
+        const auto first = [this](double v)
+        {
+            return static_cast<size_t>(std::max(0.0, std::floor(v / params.cell_size)));
+        };
+        const size_t c_min = first(p.x - params.sensor_range - x0);
+        const size_t r_min = first(p.y - params.sensor_range - y0);
+        const size_t c_max = std::min(n_cols, first(p.x + params.sensor_range - x0) + 1);
+        const size_t r_max = std::min(n_rows, first(p.y + params.sensor_range - y0) + 1);
+
+        size_t n = 0;
+        for (size_t r = r_min; r < r_max; r++)
+        {
+            for (size_t c = c_min; c < c_max; c++)
+            {
+                const Vector2D cell{x0 + (c + 0.5) * params.cell_size, y0 + (r + 0.5) * params.cell_size};
+                if (not explored.at(r * n_cols + c) and distance(cell, p) <= params.sensor_range)
+                {
+                    n++;
+                }
+            }
+        }
+        return n;
+    }
+
+    bool ExplorationPlanner::in_arena(const Vector2D &p) const
+    {
+        return std::abs(p.x - params.arena_center.x) <= params.x_length / 2.0 - params.clearance and
+               std::abs(p.y - params.arena_center.y) <= params.y_length / 2.0 - params.clearance;
+    }
+
+    double ExplorationPlanner::information_gain(
+        const Vector2D &waypoint,
+        const std::array<double, 3> &position_covariance,
+        const std::vector<LandmarkBelief> &landmarks) const
+    {
+        const double var = params.measurement_variance;
+        double map_gain = 0.0;
+
+        // sum of the information each visible landmark gives about the robot position,
+        // (var I + P_l)^-1, with the landmark uncertainty added to the measurement noise
+        double s_xx = 0.0, s_xy = 0.0, s_yy = 0.0;
+        for (const auto &l : landmarks)
+        {
+            if (distance(l.position, waypoint) > params.sensor_range)
+            {
+                continue;
+            }
+            const auto &[xx, xy, yy] = l.covariance;
+
+            // log det(I + P_l / var) / 2
+            map_gain += 0.5 * std::log((1.0 + xx / var) * (1.0 + yy / var) - (xy / var) * (xy / var));
+
+            const double a = var + xx, b = xy, d = var + yy;
+            const double det = a * d - b * b;
+            s_xx += d / det;
+            s_xy -= b / det;
+            s_yy += a / det;
+        }
+
+        // log det(I + P_r S) / 2
+        const auto &[p_xx, p_xy, p_yy] = position_covariance;
+        const double m00 = p_xx * s_xx + p_xy * s_xy;
+        const double m01 = p_xx * s_xy + p_xy * s_yy;
+        const double m10 = p_xy * s_xx + p_yy * s_xy;
+        const double m11 = p_xy * s_xy + p_yy * s_yy;
+        const double pose_gain = 0.5 * std::log((1.0 + m00) * (1.0 + m11) - m01 * m10);
+
+        // each new landmark starts with an isotropic variance, log det(I + P_0 / var) / 2
+        const double cell_area = params.cell_size * params.cell_size;
+        const double new_landmarks = unexplored_in_range(waypoint) * cell_area * params.landmark_density;
+        const double new_gain = new_landmarks * std::log(1.0 + params.new_landmark_variance / var);
+
+        return map_gain + pose_gain + new_gain;
+    }
+
+    std::vector<Waypoint> ExplorationPlanner::candidates(
+        const Pose2D &pose,
+        const std::array<double, 9> &pose_covariance,
+        const std::vector<LandmarkBelief> &landmarks) const
+    {
+        const Vector2D robot{pose.x, pose.y};
+        std::vector<Waypoint> waypoints;
+        waypoints.reserve(params.radii.size() * params.headings);
+        for (size_t h = 0; h < params.headings; h++)
+        {
+            const double angle = pose.theta + 2.0 * PI * h / params.headings;
+            const double turn = std::abs(normalize_angle(angle - pose.theta));
+            for (const double radius : params.radii)
+            {
+                const Vector2D p = robot + Vector2D{std::cos(angle), std::sin(angle)} * radius;
+                if (not in_arena(p))
+                {
+                    continue;
+                }
+                const bool blocked = std::any_of(
+                    landmarks.begin(), landmarks.end(), [&](const LandmarkBelief &l)
+                    { return distance_to_segment(l.position, robot, p) < params.clearance; });
+                if (blocked)
+                {
+                    continue;
+                }
+
+                // the robot position drifts on the way there
+                const double drift = params.drift_per_meter * radius;
+                const std::array<double, 3> arrival{
+                    pose_covariance.at(4) + drift, pose_covariance.at(5), pose_covariance.at(8) + drift};
+
+                Waypoint w;
+                w.position = p;
+                w.gain = information_gain(p, arrival, landmarks);
+                w.cost = radius + params.turn_cost * turn;
+                w.score = w.gain / w.cost;
+                waypoints.push_back(w);
+            }
+        }
+        return waypoints;
+    }
+
+    Waypoint ExplorationPlanner::plan(
+        const Pose2D &pose,
+        const std::array<double, 9> &pose_covariance,
+        const std::vector<LandmarkBelief> &landmarks) const
+    {
+        Waypoint best;
+        best.position = Vector2D{pose.x, pose.y};
+        for (const auto &w : candidates(pose, pose_covariance, landmarks))
+        {
+            if (w.gain >= params.min_gain and w.score > best.score)
+            {
+                best = w;
+            }
+        }
+        return best;
+    }
+
+}
@@ -1,9 +1,35 @@
 #include "turtlelib/kalman.hpp"
 #include "turtlelib/rigid2d.hpp"
 #include <rclcpp/logger.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
 
 static constexpr double BIG_NUMBER = 1e5;
 
+// A new landmark is at this mahalonobis distance from every measurement
+static constexpr double ASSOCIATION_THRESHOLD = 4e-5;
+
+// Scans with fewer (measurement, landmark) scores than this are associated on one thread,
+// as waking the workers would cost more than the scoring
+static constexpr size_t PARALLEL_SCORES = 2048;
+
+namespace
+{
+    /// @brief spreads the low 32 bits of v to the even bits of the result
+    uint64_t spread_bits(uint64_t v)
+    {
+        v &= 0xffffffff;
+        v = (v | (v << 16)) & 0x0000ffff0000ffff;
+        v = (v | (v << 8)) & 0x00ff00ff00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0f;
+        v = (v | (v << 2)) & 0x3333333333333333;
+        v = (v | (v << 1)) & 0x5555555555555555;
+        return v;
+    }
+}
+
 namespace turtlelib
 {
 
@@ -45,31 +71,30 @@ namespace turtlelib
         return z;
     }
 
-    KalmanFilter::KalmanFilter()
-        : Xi_hat(arma::mat(3, 1, arma::fill::zeros)), // mt appended to this as new measurements are added
-          sigma_hat(arma::mat(5, 5, arma::fill::zeros)),
-          Q_bar(arma::mat(5, 5, arma::fill::zeros)),
-          R_bar(arma::mat(2, 2, arma::fill::zeros)) // fix dimension
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    BasicKalmanFilter<RobotDim, LandmarkDim>::BasicKalmanFilter()
+        : Xi_hat(arma::mat(RobotDim, 1, arma::fill::zeros)), // mt appended to this as new measurements are added
+          sigma_hat(arma::mat(RobotDim, RobotDim, arma::fill::zeros)), // grows as landmarks are added
+          Q_bar(arma::fill::zeros),
+          R_bar(arma::fill::zeros)
     {
-        sigma_hat(3, 3) = BIG_NUMBER;
-        sigma_hat(4, 4) = BIG_NUMBER;
+        filter_stats.state_dimension = RobotDim;
     }
 
-    KalmanFilter::KalmanFilter(double Q, double R)
-        : Xi_hat(arma::mat(3, 1, arma::fill::zeros)), // mt appended to this as new measurements are added
-          sigma_hat(arma::mat(5, 5, arma::fill::zeros)),
-          Q_bar(arma::mat(5, 5, arma::fill::zeros)),
-          R_bar(R * arma::mat(2, 2, arma::fill::eye))
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    BasicKalmanFilter<RobotDim, LandmarkDim>::BasicKalmanFilter(double Q, double R)
+        : Xi_hat(arma::mat(RobotDim, 1, arma::fill::zeros)), // mt appended to this as new measurements are added
+          sigma_hat(arma::mat(RobotDim, RobotDim, arma::fill::zeros)), // grows as landmarks are added
+          Q_bar(Q * RobotMatrix(arma::fill::eye)),
+          R_bar(R * MeasurementMatrix(arma::fill::eye))
     {
-        sigma_hat(3, 3) = BIG_NUMBER;
-        sigma_hat(4, 4) = BIG_NUMBER;
-        Q_bar.submat(0, 0, 2, 2) = Q * arma::mat(3, 3, arma::fill::eye);
+        filter_stats.state_dimension = RobotDim;
     }
 
-    void KalmanFilter::update_measurements(const LandmarkMeasurement &measurement)
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::update_measurements(const LandmarkMeasurement &measurement)
     {
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "-----------Beginning incorporating measurements----------");
-        arma::mat mt_j(2, 1, arma::fill::zeros);
 
         // Landmark must be initialized if it hasn't been seen
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"),"id = " << measurement.marker_id);
@@ -81,37 +106,29 @@ namespace turtlelib
             double my_j = Xi_hat(2, 0) +
                    measurement.r * std::sin(normalize_angle(measurement.phi + Xi_hat(0, 0)));
 
-            mt_j = arma::mat{mx_j, my_j}.t();
-
-            // Update the complete state estimate by adding in the new mt_j vector
-            Xi_hat = arma::join_cols(Xi_hat, mt_j);
+            // Update the complete state estimate by adding in the new mt_j vector,
+            // whose components beyond (x,y) start at zero
+            const arma::uword ind = Xi_hat.n_rows;
+            Xi_hat.resize(ind + LandmarkDim, 1);
+            Xi_hat(ind, 0) = mx_j;
+            Xi_hat(ind + 1, 0) = my_j;
 
             // store the index of the x_j component for this landmark
-            landmarks_dict[measurement.marker_id] = Xi_hat.n_rows - 2;
+            landmarks_dict[measurement.marker_id] = ind;
 
-            n = (Xi_hat.n_rows - 3) / 2; // number of landmarks
+            n = (Xi_hat.n_rows - RobotDim) / LandmarkDim; // number of landmarks
 
-            // Update dimensions of the covariance matrix Sigma (3+2n x 3+2n)
-            // sigma_hat is initialed to the correct size already for n=1
-            if (n > 1)
+            // Update dimensions of the covariance matrix Sigma, the new landmark is
+            // uncorrelated with the rest of the state and very uncertain
+            sigma_hat.resize(Xi_hat.n_rows, Xi_hat.n_rows);
+            for (arma::uword i = ind; i < Xi_hat.n_rows; i++)
             {
-                // n has increased by 1 since the last time this function was called
-                // Sigma_hat goes from 3+2n x 3+2n to 3+2(n+1) x 3+2(n+1)
-                sigma_hat = arma::join_cols(sigma_hat, arma::mat(2, 3 + 2 * (n - 1), arma::fill::zeros));
-                sigma_hat = arma::join_rows(sigma_hat, arma::mat(3 + 2 * n, 2, arma::fill::zeros));
-                sigma_hat(sigma_hat.n_rows - 1, sigma_hat.n_cols - 1) = BIG_NUMBER;
-                sigma_hat(sigma_hat.n_rows - 2, sigma_hat.n_cols - 2) = BIG_NUMBER;
-
-                // Update the dimensions of the process noise matrix Q_bar
-                Q_bar = arma::join_cols(Q_bar, arma::mat(2, 3 + 2 * (n - 1), arma::fill::zeros));
-                Q_bar = arma::join_rows(Q_bar, arma::mat(3 + 2 * n, 2, arma::fill::zeros));
-
-                // Verify dimensions are correct
-                assert(sigma_hat.n_rows == sigma_hat.n_cols);
-                assert(sigma_hat.n_rows == (3 + 2 * n));
-                assert(Q_bar.n_rows == Q_bar.n_cols);
-                assert(Q_bar.n_rows == (3 + 2 * n));
+                sigma_hat(i, i) = BIG_NUMBER;
             }
+
+            // Verify dimensions are correct
+            assert(sigma_hat.n_rows == sigma_hat.n_cols);
+            assert(sigma_hat.n_rows == (RobotDim + LandmarkDim * n));
             RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "Landmarks updated");
             RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "Xi_hat = \n" << Xi_hat);
 
@@ -124,53 +141,55 @@ namespace turtlelib
     }
 
     
-    void KalmanFilter::predict_from_odometry(const Pose2D &pose, const Twist2D &V)
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::predict_from_odometry(const Pose2D &pose, const Twist2D &V)
     {
         // This must only be called once update_measurements() has been called
 
         // Note for the prediction step here, we set the noise
         // equal to zero and the map stays stationary
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "-----------Beginning prediction step----------");
-        arma::mat A_t(3, 3, arma::fill::zeros);
-        arma::mat qt_hat_new(3, 1, arma::fill::zeros);
-        arma::mat w_t(3, 1, arma::fill::zeros); // w_t = 0
 
-        Xi_hat(0, 0) = normalize_angle(Xi_hat(0, 0));
+        // G = derivative of g with respect to the robot state. The derivative with
+        // respect to the map is the identity, so only the robot rows and columns of
+        // the covariance change
+        RobotMatrix G(arma::fill::eye);
 
-        qt_hat_new(0, 0) = pose.theta;
-        qt_hat_new(1, 0) = pose.x;
-        qt_hat_new(2, 0) = pose.y;
+        Xi_hat(0, 0) = normalize_angle(Xi_hat(0, 0));
 
         // zero rotational velocity
         if (almost_equal(V.thetadot, 0.0))
         {
-            // A_t = derivative of g
-            A_t(0, 0) = 0.0;
-            A_t(1, 0) = -V.xdot * std::sin(Xi_hat(0, 0));
-            A_t(2, 0) = V.xdot * std::cos(Xi_hat(0, 0));
+            G(1, 0) += -V.xdot * std::sin(Xi_hat(0, 0));
+            G(2, 0) += V.xdot * std::cos(Xi_hat(0, 0));
         }
         else // non-zero rotational velocity
         {
-            // A_t = derivative of g
-            A_t(0, 0) = 0.0;
-            A_t(1, 0) = -(V.xdot / V.thetadot) * std::cos(Xi_hat(0, 0)) +
-                        (V.xdot / V.thetadot) * std::cos(Xi_hat(0, 0) + V.thetadot);
-            A_t(2, 0) = -(V.xdot / V.thetadot) * std::sin(Xi_hat(0, 0)) +
-                        (V.xdot / V.thetadot) * std::sin(Xi_hat(0, 0) + V.thetadot);
+            G(1, 0) += -(V.xdot / V.thetadot) * std::cos(Xi_hat(0, 0)) +
+                       (V.xdot / V.thetadot) * std::cos(Xi_hat(0, 0) + V.thetadot);
+            G(2, 0) += -(V.xdot / V.thetadot) * std::sin(Xi_hat(0, 0)) +
+                       (V.xdot / V.thetadot) * std::sin(Xi_hat(0, 0) + V.thetadot);
         }
 
-        // A_t should be (3+2n x 3+2n)
-        A_t = arma::join_rows(A_t, arma::mat(3, 2 * n, arma::fill::zeros));
-        A_t = arma::join_cols(A_t, arma::mat(2 * n, 3 + 2 * n, arma::fill::zeros));
-        A_t = A_t + arma::mat(arma::size(A_t), arma::fill::eye);
-        assert(A_t.n_rows == A_t.n_cols);
-        assert(A_t.n_rows == (3 + 2 * n));
-
         // Save the new prediction of the robot's configuration
-        Xi_hat.submat(0, 0, 2, 0) = qt_hat_new;
+        Xi_hat(0, 0) = pose.theta;
+        Xi_hat(1, 0) = pose.x;
+        Xi_hat(2, 0) = pose.y;
 
         // Now we propagate the uncertainty using the linear state transition model
-        sigma_hat = (A_t * sigma_hat * A_t.t()) + Q_bar;
+        // sigma = A sigma A^T + Q, with A = [G 0; 0 I]
+        const arma::uword N = Xi_hat.n_rows;
+        const RobotMatrix sigma_rr = sigma_hat.submat(0, 0, RobotDim - 1, RobotDim - 1);
+        sigma_hat.submat(0, 0, RobotDim - 1, RobotDim - 1) = G * sigma_rr * G.t() + Q_bar;
+        if (N > RobotDim)
+        {
+            const arma::mat sigma_rm = sigma_hat.submat(0, RobotDim, RobotDim - 1, N - 1);
+            const arma::mat sigma_mr = sigma_hat.submat(RobotDim, 0, N - 1, RobotDim - 1);
+            sigma_hat.submat(0, RobotDim, RobotDim - 1, N - 1) = G * sigma_rm;
+            sigma_hat.submat(RobotDim, 0, N - 1, RobotDim - 1) = sigma_mr * G.t();
+        }
+
+        state_version++;
 
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "sigma_hat size = " << arma::size(sigma_hat));
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "Xi_hat = \n"
@@ -180,61 +199,73 @@ namespace turtlelib
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "-----------Finished prediciton step-----------");
     }
 
-    arma::mat KalmanFilter::compute_h(unsigned int ind_in_Xi) const
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    typename BasicKalmanFilter<RobotDim, LandmarkDim>::MeasurementVector
+    BasicKalmanFilter<RobotDim, LandmarkDim>::compute_h(unsigned int ind_in_Xi) const
     {
 
         const double mj_x = Xi_hat(ind_in_Xi, 0);
         const double mj_y = Xi_hat(ind_in_Xi + 1, 0);
 
-        const double r_j = std::sqrt(
+        MeasurementVector h;
+        h(0, 0) = std::sqrt(
             std::pow((mj_x - Xi_hat(1, 0)), 2.0) +
             std::pow((mj_y - Xi_hat(2, 0)), 2.0));
 
-        const double phi_j = normalize_angle(
+        h(1, 0) = normalize_angle(
                 std::atan2(mj_y - Xi_hat(2, 0), mj_x - Xi_hat(1, 0)) - Xi_hat(0, 0));
 
-        arma::mat h = arma::mat{r_j, phi_j};
-
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "h = \n"
                                                                    << h);
         return h;
 
     }
 
-    arma::mat KalmanFilter::compute_H(unsigned int ind_in_Xi) const
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::compute_H(
+        unsigned int ind_in_Xi, RobotJacobian &Hr, LandmarkJacobian &Hm) const
     {
-        unsigned int j = (ind_in_Xi - 1) / 2;
         const double del_x = (Xi_hat(ind_in_Xi, 0) - Xi_hat(1, 0));
         const double del_y = (Xi_hat(ind_in_Xi + 1, 0) - Xi_hat(2, 0));
         const double d = std::pow(del_x, 2.0) + std::pow(del_y, 2.0);
-        
-        if (sigma_hat.n_cols == 5)
-        {
-            j = j - 1;
-        }
-        
-        arma::mat H = arma::mat(2, sigma_hat.n_cols, arma::fill::zeros);
-
-        H(0, 1) = -del_x / std::sqrt(d);
-        H(0, 2) = -del_y / std::sqrt(d);
-        H(1, 0) = -1.0;
-        H(1, 1) = del_y / d;
-        H(1, 2) = -del_x / d;
 
-        H(0, 3 + j) = del_x / std::sqrt(d);
-        H(0, 4 + j) = del_y / std::sqrt(d);
-        H(1, 3 + j) = -del_y / d;
-        H(1, 4 + j) = del_x / d;
-
-        assert(H.n_rows == 2);
-        assert(H.n_cols == (3+2*n));
+        Hr.zeros();
+        Hr(0, 1) = -del_x / std::sqrt(d);
+        Hr(0, 2) = -del_y / std::sqrt(d);
+        Hr(1, 0) = -1.0;
+        Hr(1, 1) = del_y / d;
+        Hr(1, 2) = -del_x / d;
+
+        Hm.zeros();
+        Hm(0, 0) = del_x / std::sqrt(d);
+        Hm(0, 1) = del_y / std::sqrt(d);
+        Hm(1, 0) = -del_y / d;
+        Hm(1, 1) = del_x / d;
+
+        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "Hr = \n"
+                                                                   << Hr << "Hm = \n" << Hm);
+    }
 
-        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "H = \n"
-                                                                   << H);
-        return H;
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    typename BasicKalmanFilter<RobotDim, LandmarkDim>::MeasurementMatrix
+    BasicKalmanFilter<RobotDim, LandmarkDim>::innovation_covariance(
+        unsigned int ind_in_Xi, const RobotJacobian &Hr, const LandmarkJacobian &Hm) const
+    {
+        const arma::uword k = ind_in_Xi;
+        const RobotMatrix sigma_rr = sigma_hat.submat(0, 0, RobotDim - 1, RobotDim - 1);
+        const arma::mat::fixed<RobotDim, LandmarkDim> sigma_rm =
+            sigma_hat.submat(0, k, RobotDim - 1, k + LandmarkDim - 1);
+        const arma::mat::fixed<LandmarkDim, RobotDim> sigma_mr =
+            sigma_hat.submat(k, 0, k + LandmarkDim - 1, RobotDim - 1);
+        const arma::mat::fixed<LandmarkDim, LandmarkDim> sigma_mm =
+            sigma_hat.submat(k, k, k + LandmarkDim - 1, k + LandmarkDim - 1);
+
+        return Hr * sigma_rr * Hr.t() + Hr * sigma_rm * Hm.t() +
+               Hm * sigma_mr * Hr.t() + Hm * sigma_mm * Hm.t() + R_bar;
     }
 
-    void KalmanFilter::update(const std::vector<LandmarkMeasurement> &measurements)
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::update(const std::vector<LandmarkMeasurement> &measurements)
     {
         // for each measurement
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "------------Beginning update step-----------");
@@ -242,248 +273,618 @@ namespace turtlelib
         // Note: if the vector has multiple measurments with the same id,
         // this will fail! The duplicate id measurement will not get added
         // measurements.size() will be greater than the number of unique measurements
+        const arma::uword N = Xi_hat.n_rows;
+        if (consider_dist > 0.0)
+        {
+            consider_update(measurements);
+            return;
+        }
+        filter_stats.last_active_landmarks = n;
         for (size_t i = 0; i < measurements.size(); i++)
         {
             // Get the index of this landmark in the state vector
             const unsigned int ind_in_Xi = landmarks_dict[measurements.at(i).marker_id];
+            const arma::uword last = ind_in_Xi + LandmarkDim - 1;
 
             // 1. Compute theoretical measurement zi_hat = h_j
-            arma::mat zi_hat = compute_h(ind_in_Xi); // index is location in Xi, we want j for compute_h
-
-            // 2. Compute the Kalman gain (Eq 26)
-            arma::mat H = compute_H(ind_in_Xi);
-            arma::mat K = (sigma_hat * H.t()) * arma::inv(H * sigma_hat * H.t() + R_bar);
+            const MeasurementVector zi_hat = compute_h(ind_in_Xi);
+
+            // 2. Compute the Kalman gain (Eq 26). H is zero outside the robot and
+            // landmark columns, so sigma H^T only needs those columns of sigma
+            RobotJacobian Hr;
+            LandmarkJacobian Hm;
+            compute_H(ind_in_Xi, Hr, Hm);
+            const arma::mat sigma_Ht = sigma_hat.submat(0, 0, N - 1, RobotDim - 1) * Hr.t() +
+                                       sigma_hat.submat(0, ind_in_Xi, N - 1, last) * Hm.t();
+            const MeasurementMatrix S = Hr * sigma_Ht.submat(0, 0, RobotDim - 1, 1) +
+                                        Hm * sigma_Ht.submat(ind_in_Xi, 0, last, 1) + R_bar;
+            const arma::mat K = sigma_Ht * arma::inv(S);
 
             // 3. Compute the posterior state update Xi_t_hat
-            arma::mat zi = measurements.at(i).to_mat();
+            const MeasurementVector zi = measurements.at(i).to_mat();
             RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "(zi - zi_hat)\n"
-                                                                       << zi << " - " << zi_hat.t());
-            arma::mat z_diff = zi - zi_hat.t();
+                                                                       << zi << " - " << zi_hat);
+            MeasurementVector z_diff = zi - zi_hat;
             z_diff(1, 0) = normalize_angle(z_diff(1, 0));
             Xi_hat = Xi_hat + K * z_diff;
             Xi_hat(0, 0) = normalize_angle(Xi_hat(0, 0)); // Normalize the angle
 
-            // 4. Compute the posterior covariance sigma_t
-            arma::mat I = arma::mat(arma::size(sigma_hat), arma::fill::eye);
-            sigma_hat = (I - K * H) * sigma_hat;
+            // 4. Compute the posterior covariance sigma_t = (I - K H) sigma
+            const arma::mat H_sigma = Hr * sigma_hat.submat(0, 0, RobotDim - 1, N - 1) +
+                                      Hm * sigma_hat.submat(ind_in_Xi, 0, last, N - 1);
+            sigma_hat = sigma_hat - K * H_sigma;
+            state_version++;
         }
 
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "---------Finished update step---------");
     }
-    
-    
-    double KalmanFilter::mahalanobis_distance(arma::mat zi, arma::mat zk, arma::mat covariance) const
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::consider_update(const std::vector<LandmarkMeasurement> &measurements)
     {
-        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "zi = \n" << zi);
-        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "zk = \n" << zk);
-        arma::mat d_mat = (zi - zk).t() * arma::inv(covariance) * (zi - zk);
-        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "mahalanobis distance = " << d_mat(0));
-        return d_mat(0);
-    }
+        // The robot, the measured landmarks, and the landmarks within consider_dist of the
+        // robot are active. The rest are consider states, whose means and mutual
+        // covariances are frozen, so each update costs O(n_active * N) instead of O(N^2)
+        const arma::uword N = Xi_hat.n_rows;
+        std::vector<bool> is_active(n, false);
+        for (const auto &m : measurements)
+        {
+            is_active.at((landmarks_dict.at(m.marker_id) - RobotDim) / LandmarkDim) = true;
+        }
+        const double dist2 = consider_dist * consider_dist;
+        for (uint64_t j = 0; j < n; j++)
+        {
+            const arma::uword k = RobotDim + j * LandmarkDim;
+            const double dx = Xi_hat(k, 0) - Xi_hat(1, 0);
+            const double dy = Xi_hat(k + 1, 0) - Xi_hat(2, 0);
+            is_active.at(j) = is_active.at(j) or dx * dx + dy * dy <= dist2;
+        }
 
+        std::vector<arma::uword> active_ind;
+        std::vector<arma::uword> consider_ind;
+        for (arma::uword i = 0; i < RobotDim; i++)
+        {
+            active_ind.push_back(i);
+        }
+        for (uint64_t j = 0; j < n; j++)
+        {
+            auto &ind = is_active.at(j) ? active_ind : consider_ind;
+            for (arma::uword i = 0; i < LandmarkDim; i++)
+            {
+                ind.push_back(RobotDim + j * LandmarkDim + i);
+            }
+        }
+        const arma::uvec active(active_ind);
+        const arma::uvec consider(consider_ind);
+        filter_stats.last_active_landmarks = (active.n_elem - RobotDim) / LandmarkDim;
 
-    LandmarkMeasurement KalmanFilter::associate_measurement(LandmarkMeasurement measurement)
+        for (size_t i = 0; i < measurements.size(); i++)
+        {
+            const unsigned int ind_in_Xi = landmarks_dict.at(measurements.at(i).marker_id);
+            const arma::uword last = ind_in_Xi + LandmarkDim - 1;
+
+            // H is zero on the consider states, so they only enter the gain through the
+            // cross covariance of the active states with them
+            RobotJacobian Hr;
+            LandmarkJacobian Hm;
+            compute_H(ind_in_Xi, Hr, Hm);
+            const arma::mat sigma_Ht = sigma_hat.submat(active, arma::regspace<arma::uvec>(0, RobotDim - 1)) * Hr.t() +
+                                       sigma_hat.submat(active, arma::regspace<arma::uvec>(ind_in_Xi, last)) * Hm.t();
+            const MeasurementMatrix S = innovation_covariance(ind_in_Xi, Hr, Hm);
+            const arma::mat K = sigma_Ht * arma::inv(S);
+
+            MeasurementVector z_diff = measurements.at(i).to_mat() - compute_h(ind_in_Xi);
+            z_diff(1, 0) = normalize_angle(z_diff(1, 0));
+            Xi_hat.rows(active) += K * z_diff;
+            Xi_hat(0, 0) = normalize_angle(Xi_hat(0, 0));
+
+            // the active rows become sigma - K H sigma, and the consider rows their mirror
+            const arma::mat H_sigma = Hr * sigma_hat.submat(0, 0, RobotDim - 1, N - 1) +
+                                      Hm * sigma_hat.submat(ind_in_Xi, 0, last, N - 1);
+            sigma_hat.rows(active) -= K * H_sigma;
+            if (not consider.is_empty())
+            {
+                sigma_hat.submat(consider, active) = sigma_hat.submat(active, consider).t();
+            }
+            state_version++;
+        }
+
+        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "---------Finished consider update step---------");
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    bool BasicKalmanFilter<RobotDim, LandmarkDim>::reorder_landmarks()
     {
-        // takes in a LandmarkMeasurement with unknown association and associates it
-        // in other words, assigns the appropriate id to it and returns it.
-        
-        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "------------Beginning data association-----------");
-        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "State = " << Xi_hat);
+        if (n < 2)
+        {
+            return false;
+        }
 
-        // Create temporary variables
-        arma::mat Xi_hat_temp = Xi_hat;
-        arma::mat sigma_hat_temp = sigma_hat;
-        arma::mat Q_bar_temp = Q_bar;
-        auto n_temp = n;
-        auto landmarks_dict_temp = landmarks_dict;
-
-        // Temporarily add landmark via inverted measurement model
-        arma::mat mt_j = arma::mat(2,1,arma::fill::zeros);
-        const double mx_j = Xi_hat_temp(1, 0) +
-               measurement.r * std::cos(normalize_angle(measurement.phi + Xi_hat_temp(0, 0)));
-        const double my_j = Xi_hat_temp(2, 0) +
-               measurement.r * std::sin(normalize_angle(measurement.phi + Xi_hat_temp(0, 0)));
-        mt_j = arma::mat{mx_j, my_j}.t();
-        
-        Xi_hat_temp = arma::join_cols(Xi_hat_temp, mt_j);
-        
-        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "Current measurement = " << mx_j << "," << my_j);
+        // Morton code of each landmark on a 2^16 x 2^16 grid over the bounding box of the map
+        double min_x = Xi_hat(RobotDim, 0), max_x = min_x;
+        double min_y = Xi_hat(RobotDim + 1, 0), max_y = min_y;
+        for (uint64_t j = 0; j < n; j++)
+        {
+            const arma::uword k = RobotDim + j * LandmarkDim;
+            min_x = std::min(min_x, Xi_hat(k, 0));
+            max_x = std::max(max_x, Xi_hat(k, 0));
+            min_y = std::min(min_y, Xi_hat(k + 1, 0));
+            max_y = std::max(max_y, Xi_hat(k + 1, 0));
+        }
+        const double cells = 65535.0;
+        const double scale = cells / std::max({max_x - min_x, max_y - min_y, 1e-9});
+        std::vector<std::pair<uint64_t, uint64_t>> codes; // (code, current slot)
+        codes.reserve(n);
+        for (uint64_t j = 0; j < n; j++)
+        {
+            const arma::uword k = RobotDim + j * LandmarkDim;
+            const auto qx = static_cast<uint64_t>((Xi_hat(k, 0) - min_x) * scale);
+            const auto qy = static_cast<uint64_t>((Xi_hat(k + 1, 0) - min_y) * scale);
+            codes.emplace_back(spread_bits(qx) | (spread_bits(qy) << 1), j);
+        }
+        std::stable_sort(codes.begin(), codes.end());
+        bool sorted = true;
+        for (uint64_t j = 0; j < n and sorted; j++)
+        {
+            sorted = codes.at(j).second == j;
+        }
+        if (sorted)
+        {
+            return false;
+        }
 
-        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "Temp State = " << Xi_hat_temp);
+        // Move the landmark which belongs in slot j there with swaps of whole blocks, so
+        // the state and covariance are permuted in place. at[j] is the landmark now in
+        // slot j and slot_of[l] the slot of landmark l, both by first-seen order
+        std::vector<uint64_t> at(n);
+        std::vector<uint64_t> slot_of(n);
+        for (uint64_t j = 0; j < n; j++)
+        {
+            at.at(j) = j;
+            slot_of.at(j) = j;
+        }
+        for (uint64_t j = 0; j < n; j++)
+        {
+            const uint64_t wanted = codes.at(j).second;
+            const uint64_t from = slot_of.at(wanted);
+            if (from == j)
+            {
+                continue;
+            }
+            for (arma::uword c = 0; c < LandmarkDim; c++)
+            {
+                const arma::uword a = RobotDim + j * LandmarkDim + c;
+                const arma::uword b = RobotDim + from * LandmarkDim + c;
+                Xi_hat.swap_rows(a, b);
+                sigma_hat.swap_rows(a, b);
+                sigma_hat.swap_cols(a, b);
+            }
+            const uint64_t displaced = at.at(j);
+            at.at(from) = displaced;
+            slot_of.at(displaced) = from;
+            at.at(j) = wanted;
+            slot_of.at(wanted) = j;
+        }
 
-        // temporarily updated number of landmarks
-        n_temp = (Xi_hat_temp.n_rows - 3) / 2;
-        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "n_temp = " << n_temp);
-        
-        // store the temporary new landmark in the landmarks_dict
-        measurement.marker_id = n_temp-1;
-        landmarks_dict_temp[measurement.marker_id] = Xi_hat_temp.n_rows - 2;
+        // landmarks_dict holds state indices, which moved with their blocks
+        for (auto &landmark : landmarks_dict)
+        {
+            const uint64_t before = (landmark.second - RobotDim) / LandmarkDim;
+            landmark.second = RobotDim + slot_of.at(before) * LandmarkDim;
+        }
+        state_version++;
+        return true;
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::set_reorder_period(size_t runs)
+    {
+        reorder_period = runs;
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::set_association_threads(size_t threads)
+    {
+        if (threads == association_threads())
+        {
+            return;
+        }
+        association_pool = threads > 1 ? std::make_shared<ThreadPool>(threads) : nullptr;
+    }
 
-        // Update dimensions of the covariance matrix Sigma (3+2n x 3+2n)
-        // sigma_hat is initialed to the correct size already for n=1
-        if (n_temp > 1)
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    size_t BasicKalmanFilter<RobotDim, LandmarkDim>::association_threads() const
+    {
+        return association_pool ? association_pool->size() : 1;
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    std::vector<unsigned int> BasicKalmanFilter<RobotDim, LandmarkDim>::landmark_ids() const
+    {
+        std::vector<unsigned int> ids(n);
+        for (const auto &landmark : landmarks_dict)
         {
-            // n has increased by 1 since the last time this function was called
-            // Sigma_hat goes from 3+2n x 3+2n to 3+2(n+1) x 3+2(n+1)
-            sigma_hat_temp = arma::join_cols(sigma_hat_temp, arma::mat(2, 3 + 2 * (n_temp - 1), arma::fill::zeros));
-            sigma_hat_temp = arma::join_rows(sigma_hat_temp, arma::mat(3 + 2 * n_temp, 2, arma::fill::zeros));
-            sigma_hat_temp(sigma_hat_temp.n_rows - 1, sigma_hat_temp.n_cols - 1) = BIG_NUMBER;
-            sigma_hat_temp(sigma_hat_temp.n_rows - 2, sigma_hat_temp.n_cols - 2) = BIG_NUMBER;
+            ids.at((landmark.second - RobotDim) / LandmarkDim) = landmark.first;
+        }
+        return ids;
+    }
 
-            // Update the dimensions of the process noise matrix Q_bar
-            Q_bar_temp = arma::join_cols(Q_bar_temp, arma::mat(2, 3 + 2 * (n_temp - 1), arma::fill::zeros));
-            Q_bar_temp = arma::join_rows(Q_bar_temp, arma::mat(3 + 2 * n_temp, 2, arma::fill::zeros));
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::set_consider_distance(double distance)
+    {
+        if (distance < 0.0)
+        {
+            throw std::invalid_argument("The consider distance cannot be negative");
+        }
+        consider_dist = distance;
+    }
 
-            // Verify dimensions are correct
-            assert(sigma_hat_temp.n_rows == sigma_hat_temp.n_cols);
-            assert(sigma_hat_temp.n_rows == (3 + 2 * n_temp));
-            assert(Q_bar_temp.n_rows == Q_bar_temp.n_cols);
-            assert(Q_bar_temp.n_rows == (3 + 2 * n_temp));
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    double BasicKalmanFilter<RobotDim, LandmarkDim>::consider_distance() const
+    {
+        return consider_dist;
+    }
+    
+    
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::sync_landmark_arrays() const
+    {
+        LandmarkArrays &a = landmark_arrays;
+        if (a.version == state_version and a.id.size() == n)
+        {
+            return;
         }
 
-        double threshold = 4e-5;
-        std::map<double, unsigned int> d_map; // mahalonobis distance : marker_id
-        arma::mat zi = arma::mat{measurement.r, measurement.phi}.t();
-        for (auto &landmark : landmarks_dict_temp)
+        // Landmarks are only ever appended without a change of version, and leave the
+        // rest of the state alone, so only their slots need filling
+        const size_t first = a.version == state_version ? a.id.size() : 0;
+        a.id.resize(n);
+        for (auto *v : {&a.x, &a.y, &a.xx, &a.xy, &a.yy, &a.theta_x, &a.theta_y, &a.x_x, &a.x_y,
+                        &a.y_x, &a.y_y, &a.range, &a.bearing, &a.info_rr, &a.info_rb, &a.info_bb})
         {
-            const unsigned int k = landmark.second; // k = index in Xi_hat
-                                
-            RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"),"k = " << k);
-            
-            auto current_x = Xi_hat_temp(k,0);
-            auto current_y = Xi_hat_temp(k+1,0);
-            RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"),
-                    "Checking landmark ID: " << landmark.first << ", " << current_x << "," << current_y);
-
-            // Compute H
-            arma::mat H = arma::mat(2, sigma_hat_temp.n_cols, arma::fill::zeros);
-            unsigned int j = (k - 1) / 2;
-            RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"),"j = " << j);
-            const double del_x = (Xi_hat_temp(k, 0) - Xi_hat_temp(1, 0));
-            const double del_y = (Xi_hat_temp(k + 1, 0) - Xi_hat_temp(2, 0));
-            const double d = std::pow(del_x, 2.0) + std::pow(del_y, 2.0);
-
-            H(0, 1) = -del_x / std::sqrt(d);
-            H(0, 2) = -del_y / std::sqrt(d);
-            H(1, 0) = -1.0;
-            H(1, 1) = del_y / d;
-            H(1, 2) = -del_x / d;
-
-            H(0, k) = del_x / std::sqrt(d);
-            H(0, k+1) = del_y / std::sqrt(d);
-            H(1, k) = -del_y / d;
-            H(1, k+1) = del_x / d;
-            assert(H.n_rows == 2);
-            assert(H.n_cols == (3+2*n_temp));
-            RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"),"H = \n" << H);
-
-            arma::mat cov = H * sigma_hat_temp * H.t() + R_bar;
-            
-            // compute theoretical measurement zk
-            const double mj_x = Xi_hat_temp(k, 0);
-            const double mj_y = Xi_hat_temp(k + 1, 0);
-            const double r_j = std::sqrt(
-                std::pow((mj_x - Xi_hat_temp(1, 0)), 2.0) +
-                std::pow((mj_y - Xi_hat_temp(2, 0)), 2.0));
-            const double phi_j = normalize_angle(
-                    std::atan2(mj_y - Xi_hat_temp(2, 0), mj_x - Xi_hat_temp(1, 0)) - Xi_hat_temp(0, 0));
-            arma::mat zk = arma::mat{r_j, phi_j};
-            zk = zk.t();
-           
-            if (landmark.second != Xi_hat_temp.n_rows-2)
+            v->resize(n);
+        }
+        for (const auto &landmark : landmarks_dict)
+        {
+            const arma::uword k = landmark.second;
+            const size_t j = (k - RobotDim) / LandmarkDim;
+            if (j < first)
             {
-                // Get mahalanobis_distance for each landmark except temp
-                double dk = mahalanobis_distance(zi,zk,cov);
-                d_map[dk] = landmark.first;
+                continue;
             }
-            else
+            a.id[j] = landmark.first;
+            a.x[j] = Xi_hat(k, 0);
+            a.y[j] = Xi_hat(k + 1, 0);
+            a.xx[j] = sigma_hat(k, k);
+            a.xy[j] = sigma_hat(k, k + 1);
+            a.yy[j] = sigma_hat(k + 1, k + 1);
+            a.theta_x[j] = sigma_hat(0, k);
+            a.theta_y[j] = sigma_hat(0, k + 1);
+            a.x_x[j] = sigma_hat(1, k);
+            a.x_y[j] = sigma_hat(1, k + 1);
+            a.y_x[j] = sigma_hat(2, k);
+            a.y_y[j] = sigma_hat(2, k + 1);
+        }
+
+        // the robot pose, its covariance, and the measurement noise are shared by all
+        const double rt = Xi_hat(0, 0), rx = Xi_hat(1, 0), ry = Xi_hat(2, 0);
+        const double p_tt = sigma_hat(0, 0), p_tx = sigma_hat(0, 1), p_ty = sigma_hat(0, 2);
+        const double p_xx = sigma_hat(1, 1), p_xy = sigma_hat(1, 2), p_yy = sigma_hat(2, 2);
+        const double r00 = R_bar(0, 0), r01 = R_bar(0, 1), r11 = R_bar(1, 1);
+
+        // The range is u = a.p and the bearing v = -theta + b.p to first order in theta
+        // and p = m - (x, y), with a = p/|p| and b = (-p_y, p_x)/|p|^2. So the innovation
+        // covariance S = H sigma H^T + R only needs the covariance C of (theta, p), which
+        // comes from the robot block and the arrays of the landmark
+        for (size_t j = first; j < n; j++)
+        {
+            const double dx = a.x[j] - rx;
+            const double dy = a.y[j] - ry;
+            const double q = dx * dx + dy * dy;
+            const double sq = std::sqrt(q);
+            const double a1 = dx / sq, a2 = dy / sq;
+            const double b1 = -dy / q, b2 = dx / q;
+
+            const double c_t1 = a.theta_x[j] - p_tx;
+            const double c_t2 = a.theta_y[j] - p_ty;
+            const double c_11 = a.xx[j] - 2.0 * a.x_x[j] + p_xx;
+            const double c_12 = a.xy[j] - a.x_y[j] - a.y_x[j] + p_xy;
+            const double c_22 = a.yy[j] - 2.0 * a.y_y[j] + p_yy;
+            const double ca1 = c_11 * a1 + c_12 * a2, ca2 = c_12 * a1 + c_22 * a2;
+            const double cb1 = c_11 * b1 + c_12 * b2, cb2 = c_12 * b1 + c_22 * b2;
+
+            const double s00 = a1 * ca1 + a2 * ca2 + r00;
+            const double s01 = b1 * ca1 + b2 * ca2 - (a1 * c_t1 + a2 * c_t2) + r01;
+            const double s11 = p_tt - 2.0 * (b1 * c_t1 + b2 * c_t2) + b1 * cb1 + b2 * cb2 + r11;
+            const double det = s00 * s11 - s01 * s01;
+
+            a.range[j] = sq;
+            a.bearing[j] = normalize_angle(std::atan2(dy, dx) - rt);
+            a.info_rr[j] = s11 / det;
+            a.info_rb[j] = -s01 / det;
+            a.info_bb[j] = s00 / det;
+        }
+        a.version = state_version;
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    size_t BasicKalmanFilter<RobotDim, LandmarkDim>::association_bytes() const
+    {
+        const LandmarkArrays &a = landmark_arrays;
+        size_t bytes = a.id.capacity() * sizeof(unsigned int);
+        for (const auto *v : {&a.x, &a.y, &a.xx, &a.xy, &a.yy, &a.theta_x, &a.theta_y, &a.x_x,
+                              &a.x_y, &a.y_x, &a.y_y, &a.range, &a.bearing, &a.info_rr,
+                              &a.info_rb, &a.info_bb})
+        {
+            bytes += v->capacity() * sizeof(double);
+        }
+        bytes += association_distances.capacity() * sizeof(double);
+        bytes += scan_candidates.capacity() * sizeof(Candidate);
+        bytes += chunk_distances.capacity() * sizeof(std::vector<double>);
+        for (const auto &distances : chunk_distances)
+        {
+            bytes += distances.capacity() * sizeof(double);
+        }
+        return bytes;
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::score_landmarks(
+        const LandmarkMeasurement &measurement, size_t first, std::vector<double> &distances) const
+    {
+        sync_landmark_arrays();
+        const size_t count = landmark_arrays.id.size() - std::min(first, landmark_arrays.id.size());
+        distances.resize(count);
+
+        // Branch free and without calls over contiguous arrays, so the compiler vectorizes
+        // it. The bearing innovation is not wrapped, as before
+        const double *range = landmark_arrays.range.data() + first;
+        const double *bearing = landmark_arrays.bearing.data() + first;
+        const double *info_rr = landmark_arrays.info_rr.data() + first;
+        const double *info_rb = landmark_arrays.info_rb.data() + first;
+        const double *info_bb = landmark_arrays.info_bb.data() + first;
+        double *d = distances.data();
+        const double r = measurement.r, phi = measurement.phi;
+        for (size_t j = 0; j < count; j++)
+        {
+            const double e0 = r - range[j];
+            const double e1 = phi - bearing[j];
+            d[j] = info_rr[j] * e0 * e0 + 2.0 * info_rb[j] * e0 * e1 + info_bb[j] * e1 * e1;
+        }
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    std::vector<double> BasicKalmanFilter<RobotDim, LandmarkDim>::mahalanobis_distances(
+        const LandmarkMeasurement &measurement) const
+    {
+        std::vector<double> distances;
+        score_landmarks(measurement, 0, distances);
+        return distances;
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    typename BasicKalmanFilter<RobotDim, LandmarkDim>::Candidate
+    BasicKalmanFilter<RobotDim, LandmarkDim>::closest_landmark(
+        const LandmarkMeasurement &measurement, Candidate closest, std::vector<double> &distances) const
+    {
+        score_landmarks(measurement, closest.scored, distances);
+
+        // The closest landmark wins, the one with the larger id on a tie. A new landmark
+        // is at the threshold distance and wins a tie with an existing landmark. The
+        // order the slots are scored in does not matter
+        const std::vector<unsigned int> &ids = landmark_arrays.id;
+        for (size_t j = 0; j < distances.size(); j++)
+        {
+            const double d = distances[j];
+            const unsigned int id = ids[closest.scored + j];
+            if (d < closest.d or (closest.found and d == closest.d and id > closest.id))
             {
-                // Set the temporary a landmarks's distance to the threshold
-                RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"),"temp dk = " << threshold);
-                d_map[threshold] = landmark.first;
+                closest.d = d;
+                closest.id = id;
+                closest.found = true;
             }
         }
-   
-        // std::map is ordered, so first key (distance) is the smallest
-        // double d_star = d_map.begin()->first;
-        double d_star_id = d_map.begin()->second;
-        if (d_star_id == measurement.marker_id)
+        closest.scored = ids.size();
+        return closest;
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    bool BasicKalmanFilter<RobotDim, LandmarkDim>::score_scan(
+        const std::vector<LandmarkMeasurement> &measurements)
+    {
+        sync_landmark_arrays();
+        const size_t unknown = std::count_if(
+            measurements.begin(), measurements.end(),
+            [](const LandmarkMeasurement &m) { return not m.known; });
+        if (not association_pool or unknown < 2 or unknown * n < PARALLEL_SCORES)
+        {
+            return false;
+        }
+
+        // Each chunk only reads the landmark arrays, which are in sync, and writes the
+        // candidates of its own measurements
+        scan_candidates.assign(measurements.size(), Candidate{ASSOCIATION_THRESHOLD, 0, false, 0});
+        chunk_distances.resize(association_pool->size());
+        association_pool->parallel_for(
+            measurements.size(),
+            [&](size_t chunk, size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    if (not measurements[i].known)
+                    {
+                        scan_candidates[i] = closest_landmark(
+                            measurements[i], scan_candidates[i], chunk_distances[chunk]);
+                    }
+                }
+            });
+        return true;
+    }
+
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    LandmarkMeasurement BasicKalmanFilter<RobotDim, LandmarkDim>::associate_measurement(
+        LandmarkMeasurement measurement, Candidate closest) const
+    {
+        // takes in a LandmarkMeasurement with unknown association and associates it
+        // in other words, assigns the appropriate id to it and returns it.
+        
+        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "------------Beginning data association-----------");
+        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "State = " << Xi_hat);
+
+        // Position of the landmark via inverted measurement model
+        const double mx_j = Xi_hat(1, 0) +
+               measurement.r * std::cos(normalize_angle(measurement.phi + Xi_hat(0, 0)));
+        const double my_j = Xi_hat(2, 0) +
+               measurement.r * std::sin(normalize_angle(measurement.phi + Xi_hat(0, 0)));
+        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "Current measurement = " << mx_j << "," << my_j);
+
+        // the id the landmark gets if it is new
+        const unsigned int new_id = n;
+
+        // score the landmarks not scored yet, which were added earlier in the scan if the
+        // scan was scored in parallel
+        closest = closest_landmark(measurement, closest, association_distances);
+        const unsigned int d_star_id = closest.found ? closest.id : new_id;
+        RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"),"new landmark dk = " << ASSOCIATION_THRESHOLD << ", closest dk = " << closest.d);
+        if (not closest.found)
         {
-            // New landmark
-            auto winner_ind = landmarks_dict_temp[d_star_id];
-            auto winnerx = Xi_hat_temp(winner_ind,0);
-            auto winnery = Xi_hat_temp(winner_ind+1,0);
             RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"),"Adding new landmark with ID = " 
-                    << d_star_id << " and x,y " << winnerx << "," << winnery);
-            measurement.marker_id = d_star_id;
-            measurement.known = true;
+                    << d_star_id << " and x,y " << mx_j << "," << my_j);
         }
         else 
         {
             // Associate this measurement with the landmark cooresponding to d_star
-            auto winner_ind = landmarks_dict_temp[d_star_id];
-            auto winnerx = Xi_hat_temp(winner_ind,0);
-            auto winnery = Xi_hat_temp(winner_ind+1,0);
+            const auto winner_ind = landmarks_dict.at(d_star_id);
             RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"),"Found association with landmark ID = "
-                    << d_star_id << " and x,y " << winnerx << "," << winnery);
-            measurement.marker_id = d_star_id;
-            measurement.known = true;
+                    << d_star_id << " and x,y " << Xi_hat(winner_ind, 0) << "," << Xi_hat(winner_ind + 1, 0));
         }
+        measurement.marker_id = d_star_id;
+        measurement.known = true;
 
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "------------Data association complete-----------");
         return measurement;
     }
 
 
-    void KalmanFilter::run(const Pose2D &pose, const Twist2D &V, const std::vector<LandmarkMeasurement> &measurements)
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    void BasicKalmanFilter<RobotDim, LandmarkDim>::run(const Pose2D &pose, const Twist2D &V, const std::vector<LandmarkMeasurement> &measurements)
     {
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "-------------Start run-------------");
        
         std::vector<LandmarkMeasurement> meas_copy = measurements;
-
-        // associate and incorporate measurments
+        FilterStats &st = filter_stats;
+        st.last_associated = 0;
+        st.last_new_landmarks = 0;
+
+        // associate and incorporate measurments. The scores against the landmarks already
+        // in the map may come from the pool; the measurements are resolved in order here
+        Stopwatch sw;
+        const bool parallel = score_scan(meas_copy);
+        st.last_association_threads = parallel ? association_pool->size() : 1;
         for (size_t i = 0; i < meas_copy.size(); i++)
         {
-            if (not meas_copy.at(i).known)
+            const bool unknown = not meas_copy.at(i).known;
+            if (unknown)
             {
                 // Returns the same measurement with updated marker_id
-                meas_copy.at(i) = associate_measurement(meas_copy.at(i));
+                const Candidate unscored{ASSOCIATION_THRESHOLD, 0, false, 0};
+                meas_copy.at(i) = associate_measurement(
+                    meas_copy.at(i), parallel ? scan_candidates.at(i) : unscored);
             }
             
             if (meas_copy.at(i).known)
             {
+                if (landmarks_dict.count(meas_copy.at(i).marker_id))
+                {
+                    st.last_associated += unknown ? 1 : 0;
+                }
+                else
+                {
+                    st.last_new_landmarks++;
+                }
+
                 // Add new measurments with known association
                 update_measurements(meas_copy.at(i));
             }
         }
+        st.last_associate_us = sw.elapsed_us();
         
         /// Kalman filter prediction step
+        sw.reset();
         predict_from_odometry(pose, V);
+        st.last_predict_us = sw.elapsed_us();
 
         // Kalman filter update step
+        sw.reset();
         update(meas_copy);
+        st.last_update_us = sw.elapsed_us();
+        last_measurements = meas_copy;
+
+        st.runs++;
+        if (reorder_period > 0 and st.runs % reorder_period == 0 and reorder_landmarks())
+        {
+            st.reorders++;
+        }
+        st.landmarks = n;
+        st.state_dimension = Xi_hat.n_rows;
+        st.bytes = (Xi_hat.n_elem + sigma_hat.n_elem + Q_bar.n_elem + R_bar.n_elem) * sizeof(double) +
+                   last_measurements.capacity() * sizeof(LandmarkMeasurement) +
+                   association_bytes() +
+                   // each node of the std::map holds the pair and about four pointers
+                   landmarks_dict.size() * (sizeof(std::pair<const unsigned int, unsigned int>) + 4 * sizeof(void *));
+        st.total_associate_us += st.last_associate_us;
+        st.total_predict_us += st.last_predict_us;
+        st.total_update_us += st.last_update_us;
+        st.last_measurements = meas_copy.size();
+        st.total_measurements += st.last_measurements;
+        st.total_associated += st.last_associated;
+        st.total_new_landmarks += st.last_new_landmarks;
 
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "State = " << Xi_hat);
         RCLCPP_DEBUG_STREAM(rclcpp::get_logger("KalmanFilter"), "-------------Run complete-------------\n");
     }
 
-    arma::mat KalmanFilter::pose_prediction() const
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    arma::mat BasicKalmanFilter<RobotDim, LandmarkDim>::pose_prediction() const
     {
         arma::mat robot_pose = Xi_hat.submat(0, 0, 2, 0);
         robot_pose(0, 0) = normalize_angle(robot_pose(0, 0));
         return robot_pose;
     }
 
-    arma::mat KalmanFilter::map_prediction() const
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    arma::mat BasicKalmanFilter<RobotDim, LandmarkDim>::map_prediction() const
     {
-        return Xi_hat.submat(3, 0, Xi_hat.n_rows - 1, 0);
+        return Xi_hat.submat(RobotDim, 0, Xi_hat.n_rows - 1, 0);
     }
 
-    arma::mat KalmanFilter::state_prediction() const
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    arma::mat BasicKalmanFilter<RobotDim, LandmarkDim>::state_prediction() const
     {
         arma::mat full_state = Xi_hat;
         full_state(0, 0) = normalize_angle(full_state(0, 0));
         return Xi_hat;
     }
 
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    arma::mat BasicKalmanFilter<RobotDim, LandmarkDim>::covariance() const
+    {
+        return sigma_hat;
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    const std::vector<LandmarkMeasurement> &BasicKalmanFilter<RobotDim, LandmarkDim>::associated_measurements() const
+    {
+        return last_measurements;
+    }
+
+    template <arma::uword RobotDim, arma::uword LandmarkDim>
+    const FilterStats &BasicKalmanFilter<RobotDim, LandmarkDim>::stats() const
+    {
+        return filter_stats;
+    }
+
+    template class BasicKalmanFilter<3, 2>;
+
 }
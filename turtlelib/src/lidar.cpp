@@ -0,0 +1,91 @@
+#include "turtlelib/lidar.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace turtlelib
+{
+
+    void simulate_lidar(
+        const Pose2D &pose, const std::vector<Vector2D> &obstacles, double obstacle_radius,
+        const LidarParams &params, std::mt19937 &rng, std::vector<float> &ranges)
+    {
+        ranges.assign(params.num_beams, 0.0f);
+        if (params.num_beams == 0 or params.angle_increment <= 0.0)
+        {
+            return;
+        }
+
+        const auto n_beams = static_cast<long>(params.num_beams);
+        const bool full_circle = params.num_beams * params.angle_increment >= 2.0 * PI - 1e-9;
+        const double r2 = std::pow(obstacle_radius, 2.0);
+
+        // Transform from the world frame to the sensor frame, computed once per scan
+        const Transform2D T_bw = Transform2D(Vector2D{pose.x, pose.y}, pose.theta).inv();
+
+        for (const auto &obstacle : obstacles)
+        {
+            // Obstacle center in the sensor frame
+            const Vector2D c = T_bw(obstacle);
+            const double c2 = std::pow(c.x, 2.0) + std::pow(c.y, 2.0);
+            const double dist = std::sqrt(c2);
+            if (dist - obstacle_radius > params.max_range or dist <= obstacle_radius)
+            {
+                continue;
+            }
+
+            // Only the beams within the angular extent of the obstacle can hit it
+            const double bearing = std::atan2(c.y, c.x);
+            const double half_width = std::asin(obstacle_radius / dist);
+            const auto first = static_cast<long>(std::ceil((bearing - half_width) / params.angle_increment));
+            const auto last = static_cast<long>(std::floor((bearing + half_width) / params.angle_increment));
+
+            for (long k = first; k <= last; k++)
+            {
+                long i = k;
+                if (full_circle)
+                {
+                    i = ((k % n_beams) + n_beams) % n_beams;
+                }
+                else if (k < 0 or k >= n_beams)
+                {
+                    continue;
+                }
+
+                // Ray-circle intersection along the unit beam direction u:
+                // the closest approach is at t = u.c, at a squared distance of c2 - t^2
+                const double angle = k * params.angle_increment;
+                const double t = std::cos(angle) * c.x + std::sin(angle) * c.y;
+                const double d2 = c2 - std::pow(t, 2.0);
+                if (t <= 0.0 or d2 > r2)
+                {
+                    continue;
+                }
+                const double hit = t - std::sqrt(r2 - d2);
+                if (hit < params.min_range or hit > params.max_range)
+                {
+                    continue;
+                }
+
+                // the nearest obstacle occludes the ones behind it
+                auto &range = ranges.at(static_cast<size_t>(i));
+                if (range == 0.0f or hit < range)
+                {
+                    range = static_cast<float>(hit);
+                }
+            }
+        }
+
+        if (params.noise_stddev > 0.0)
+        {
+            std::normal_distribution<> noise_d(0.0, params.noise_stddev);
+            for (auto &range : ranges)
+            {
+                if (range != 0.0f)
+                {
+                    range += static_cast<float>(noise_d(rng));
+                }
+            }
+        }
+    }
+
+}
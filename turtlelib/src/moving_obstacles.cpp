@@ -0,0 +1,114 @@
+#include "turtlelib/moving_obstacles.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace turtlelib
+{
+
+    MovingObstacles::MovingObstacles() : MovingObstacles(MovingObstacleParams{})
+    {
+    }
+
+    MovingObstacles::MovingObstacles(const MovingObstacleParams &p) : params(p)
+    {
+        if (params.speed < 0.0 or params.turn_stddev < 0.0)
+        {
+            throw std::invalid_argument("The speed and turn rate of moving obstacles cannot be negative");
+        }
+        if (params.x_length <= 2.0 * params.margin or params.y_length <= 2.0 * params.margin)
+        {
+            throw std::invalid_argument("The arena is too small for moving obstacles");
+        }
+    }
+
+    void MovingObstacles::add_patrol(const Vector2D &start, const Vector2D &goal)
+    {
+        Mover m;
+        m.patrol = true;
+        m.start = start;
+        m.goal = goal;
+        movers.push_back(m);
+        centers.push_back(start);
+    }
+
+    void MovingObstacles::add_random_walk(const Vector2D &start, double heading)
+    {
+        Mover m;
+        m.start = start;
+        m.heading = normalize_angle(heading);
+        movers.push_back(m);
+        centers.push_back(start);
+    }
+
+    void MovingObstacles::step_patrol(Mover &m, Vector2D &p, double dist) const
+    {
+        // a patrol turns around at either end, carrying over what is left of the step
+        for (int turns = 0; turns < 2 and dist > 0.0; turns++)
+        {
+            const Vector2D target = m.returning ? m.start : m.goal;
+            const double remaining = distance(p, target);
+            if (remaining > dist)
+            {
+                p = p + (target - p) * (dist / remaining);
+                return;
+            }
+            p = target;
+            dist -= remaining;
+            m.returning = not m.returning;
+        }
+    }
+
+    void MovingObstacles::step_random_walk(Mover &m, Vector2D &p, double dist) const
+    {
+        p.x += dist * std::cos(m.heading);
+        p.y += dist * std::sin(m.heading);
+
+        // bounce off the walls
+        const double x_max = params.x_length / 2.0 - params.margin;
+        const double y_max = params.y_length / 2.0 - params.margin;
+        if (std::abs(p.x) > x_max)
+        {
+            p.x = std::clamp(2.0 * std::copysign(x_max, p.x) - p.x, -x_max, x_max);
+            m.heading = normalize_angle(PI - m.heading);
+        }
+        if (std::abs(p.y) > y_max)
+        {
+            p.y = std::clamp(2.0 * std::copysign(y_max, p.y) - p.y, -y_max, y_max);
+            m.heading = normalize_angle(-m.heading);
+        }
+    }
+
+    void MovingObstacles::step(double dt, std::mt19937 &rng)
+    {
+        const double dist = params.speed * dt;
+        std::normal_distribution<double> turn(0.0, params.turn_stddev * std::sqrt(std::max(dt, 0.0)));
+        for (size_t i = 0; i < movers.size(); i++)
+        {
+            Mover &m = movers.at(i);
+            if (m.patrol)
+            {
+                step_patrol(m, centers.at(i), dist);
+            }
+            else
+            {
+                if (params.turn_stddev > 0.0)
+                {
+                    m.heading = normalize_angle(m.heading + turn(rng));
+                }
+                step_random_walk(m, centers.at(i), dist);
+            }
+        }
+    }
+
+    const std::vector<Vector2D> &MovingObstacles::positions() const
+    {
+        return centers;
+    }
+
+    size_t MovingObstacles::size() const
+    {
+        return movers.size();
+    }
+
+}
@@ -0,0 +1,132 @@
+#include "turtlelib/odometry.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace turtlelib
+{
+
+    namespace
+    {
+        // seconds the wheels must stay still after gyro readings before they count as bias
+        constexpr double STANDSTILL_TIME = 0.25;
+
+        // time constant in seconds of the running estimate of the gyro bias
+        constexpr double BIAS_TIME_CONSTANT = 0.1;
+    }
+
+    WheelOdometry::WheelOdometry()
+    {
+    }
+
+    WheelOdometry::WheelOdometry(const DiffDrive &kinematics) : ddrive(kinematics)
+    {
+    }
+
+    void WheelOdometry::update(const WheelState &angles, const WheelState &speeds)
+    {
+        // the body twist which moves the robot from the last wheel angles to the new ones
+        const WheelState dphi{angles.left - angles_now.left, angles.right - angles_now.right};
+        Twist2D dV = ddrive.body_twist(dphi);
+
+        if (almost_equal(dphi.left, 0.0) and almost_equal(dphi.right, 0.0))
+        {
+            if (gyro_now.time > 0.0)
+            {
+                still_intervals.push_back(gyro_now);
+                still_time += gyro_now.time;
+            }
+
+            // the wheels have not moved since the oldest intervals for long enough that
+            // the robot stood still, so all the gyro measured then is its bias
+            while (not still_intervals.empty() and
+                   still_time - still_intervals.front().time >= STANDSTILL_TIME)
+            {
+                const GyroInterval &still = still_intervals.front();
+                const double weight = 1.0 - std::exp(-still.time / BIAS_TIME_CONSTANT);
+                gyro_bias_now += weight * (still.raw_heading / still.time - gyro_bias_now);
+                still_time -= still.time;
+                still_intervals.pop_front();
+            }
+        }
+        else
+        {
+            // the wheels only reported the motion of the intervals since they last moved
+            // now, so the gyro heading of those intervals belongs to this one
+            double gyro_heading = gyro_now.heading;
+            double gyro_time = gyro_now.time;
+            for (const auto &interval : still_intervals)
+            {
+                gyro_heading += interval.heading;
+                gyro_time += interval.time;
+            }
+            still_intervals.clear();
+            still_time = 0.0;
+
+            if (gyro_time > 0.0)
+            {
+                dV.thetadot = gyro_weight * gyro_heading + (1.0 - gyro_weight) * dV.thetadot;
+            }
+        }
+        gyro_now = GyroInterval{};
+
+        const Transform2D Twb(Vector2D{pose_now.x, pose_now.y}, pose_now.theta);
+        const Transform2D Tw_bprime = Twb * Twb.integrate_twist(dV);
+        pose_now = Pose2D{Tw_bprime.translation().x, Tw_bprime.translation().y, Tw_bprime.rotation()};
+        V_now = ddrive.body_twist(speeds);
+        angles_now = angles;
+        n_updates++;
+    }
+
+    void WheelOdometry::set_gyro_weight(double weight)
+    {
+        if (weight < 0.0 or weight > 1.0)
+        {
+            throw std::invalid_argument("The gyro weight must be between 0 and 1");
+        }
+        gyro_weight = weight;
+    }
+
+    void WheelOdometry::add_gyro(double yaw_rate, double stamp_s)
+    {
+        if (gyro_started and stamp_s > last_gyro_stamp)
+        {
+            const double dt = stamp_s - last_gyro_stamp;
+            gyro_now.heading += (yaw_rate - gyro_bias_now) * dt;
+            gyro_now.raw_heading += yaw_rate * dt;
+            gyro_now.time += dt;
+        }
+        last_gyro_stamp = stamp_s;
+        gyro_started = true;
+    }
+
+    double WheelOdometry::gyro_bias() const
+    {
+        return gyro_bias_now;
+    }
+
+    void WheelOdometry::set_pose(const Pose2D &pose)
+    {
+        pose_now = pose;
+    }
+
+    Pose2D WheelOdometry::pose() const
+    {
+        return pose_now;
+    }
+
+    Twist2D WheelOdometry::twist() const
+    {
+        return V_now;
+    }
+
+    WheelState WheelOdometry::wheel_angles() const
+    {
+        return angles_now;
+    }
+
+    size_t WheelOdometry::updates() const
+    {
+        return n_updates;
+    }
+
+}
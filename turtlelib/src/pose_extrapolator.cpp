@@ -0,0 +1,65 @@
+#include "turtlelib/pose_extrapolator.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace turtlelib
+{
+
+    PoseExtrapolator::PoseExtrapolator(double blend_s)
+    {
+        set_blend_time(blend_s);
+    }
+
+    void PoseExtrapolator::set_blend_time(double blend_s)
+    {
+        if (blend_s < 0.0)
+        {
+            throw std::invalid_argument("The blend time cannot be negative");
+        }
+        blend_time = blend_s;
+    }
+
+    void PoseExtrapolator::correct(const Pose2D &map_pose, const Pose2D &odom_pose, double now_s)
+    {
+        const Transform2D T_MB(Vector2D{map_pose.x, map_pose.y}, map_pose.theta);
+        const Transform2D T_OB(Vector2D{odom_pose.x, odom_pose.y}, odom_pose.theta);
+
+        // start the new blend from wherever the last one had got to
+        T_start = map_to_odom(now_s);
+        T_target = T_MB * T_OB.inv();
+        correction_time = now_s;
+    }
+
+    Transform2D PoseExtrapolator::map_to_odom(double now_s) const
+    {
+        if (blend_time <= 0.0)
+        {
+            return T_target;
+        }
+        const double alpha = std::clamp((now_s - correction_time) / blend_time, 0.0, 1.0);
+        if (alpha >= 1.0)
+        {
+            return T_target;
+        }
+
+        // interpolate the translation and the rotation, the short way around
+        const Vector2D p0 = T_start.translation();
+        const Vector2D p1 = T_target.translation();
+        const double dtheta = normalize_angle(T_target.rotation() - T_start.rotation());
+        return Transform2D(Vector2D{p0.x + alpha * (p1.x - p0.x), p0.y + alpha * (p1.y - p0.y)},
+                           normalize_angle(T_start.rotation() + alpha * dtheta));
+    }
+
+    Pose2D PoseExtrapolator::predict(const Pose2D &odom_pose, double now_s) const
+    {
+        const Transform2D T_OB(Vector2D{odom_pose.x, odom_pose.y}, odom_pose.theta);
+        const Transform2D T_MB = map_to_odom(now_s) * T_OB;
+        return Pose2D{T_MB.translation().x, T_MB.translation().y, normalize_angle(T_MB.rotation())};
+    }
+
+    Transform2D PoseExtrapolator::target() const
+    {
+        return T_target;
+    }
+
+}
@@ -0,0 +1,147 @@
+#include "turtlelib/realtime.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace turtlelib
+{
+
+    namespace
+    {
+        std::runtime_error system_error(const std::string &what, int err)
+        {
+            return std::runtime_error(what + ": " + std::strerror(err));
+        }
+    }
+
+    void lock_memory()
+    {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        {
+            throw system_error("Unable to lock memory", errno);
+        }
+    }
+
+    void reserve_heap(size_t bytes)
+    {
+        // keep freed memory in the heap and serve large blocks from it too
+        if (mallopt(M_TRIM_THRESHOLD, -1) == 0 or mallopt(M_MMAP_MAX, 0) == 0)
+        {
+            throw std::runtime_error("Unable to configure malloc");
+        }
+        if (bytes == 0)
+        {
+            return;
+        }
+
+        char *block = static_cast<char *>(std::malloc(bytes));
+        if (not block)
+        {
+            throw std::runtime_error("Unable to reserve " + std::to_string(bytes) + " bytes of heap");
+        }
+        // touch every page so it is mapped before it is needed
+        const long page = sysconf(_SC_PAGESIZE);
+        for (size_t i = 0; i < bytes; i += static_cast<size_t>(page))
+        {
+            block[i] = 0;
+        }
+        std::free(block);
+    }
+
+    void apply_thread_schedule(const ThreadSchedule &schedule)
+    {
+        if (schedule.priority < 0 or schedule.priority > 99)
+        {
+            throw std::invalid_argument("Thread priorities must be in [0, 99]");
+        }
+
+        sched_param param{};
+        param.sched_priority = schedule.priority;
+        const int policy = schedule.priority > 0 ? SCHED_FIFO : SCHED_OTHER;
+        const int err = pthread_setschedparam(pthread_self(), policy, &param);
+        if (err != 0)
+        {
+            throw system_error(
+                "Unable to set thread priority to " + std::to_string(schedule.priority), err);
+        }
+
+        if (schedule.cpus.empty())
+        {
+            return;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const auto cpu : schedule.cpus)
+        {
+            if (cpu < 0 or cpu >= CPU_SETSIZE)
+            {
+                throw std::invalid_argument("Invalid CPU " + std::to_string(cpu));
+            }
+            CPU_SET(static_cast<size_t>(cpu), &set);
+        }
+        const int aff_err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (aff_err != 0)
+        {
+            throw system_error("Unable to set thread affinity", aff_err);
+        }
+    }
+
+    // ===============
+    //   TimerJitter
+    // ===============
+
+    TimerJitter::TimerJitter(double period_s)
+        : period(period_s)
+    {
+    }
+
+    void TimerJitter::tick()
+    {
+        tick(std::chrono::steady_clock::now());
+    }
+
+    void TimerJitter::tick(std::chrono::steady_clock::time_point t)
+    {
+        if (started)
+        {
+            const std::chrono::duration<double, std::micro> deviation = (t - last_tick) - period;
+            deviation_samples.add(deviation.count());
+        }
+        started = true;
+        last_tick = t;
+    }
+
+    void TimerJitter::clear()
+    {
+        deviation_samples.clear();
+    }
+
+    size_t TimerJitter::count() const
+    {
+        return deviation_samples.count();
+    }
+
+    const SampleStats &TimerJitter::deviation_us() const
+    {
+        return deviation_samples;
+    }
+
+    std::string TimerJitter::summary(const std::string &name) const
+    {
+        std::ostringstream ss;
+        ss << name << " jitter: " << count() << " intervals, deviation p1 "
+           << deviation_samples.percentile(1.0) << " us p50 " << deviation_samples.percentile(50.0)
+           << " us p99 " << deviation_samples.percentile(99.0) << " us, max late "
+           << std::max(0.0, deviation_samples.max()) << " us";
+        return ss.str();
+    }
+
+}
@@ -0,0 +1,203 @@
+#include "turtlelib/resource_monitor.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace turtlelib
+{
+
+    namespace
+    {
+        // position of the fields after the name, counting the state as 0
+        constexpr size_t UTIME_FIELD = 11;
+        constexpr size_t STIME_FIELD = 12;
+        constexpr size_t NUM_THREADS_FIELD = 17;
+
+        /// @brief reads a whole file, returning an empty string if it cannot be read
+        std::string read_file(const std::string &path)
+        {
+            std::ifstream in(path);
+            std::stringstream ss;
+            ss << in.rdbuf();
+            return ss.str();
+        }
+
+        std::string format(double v, int precision)
+        {
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision(precision) << v;
+            return ss.str();
+        }
+    }
+
+    ProcStat parse_proc_stat(const std::string &line, double ticks_per_second)
+    {
+        const auto open = line.find('(');
+        const auto close = line.rfind(')');
+        if (open == std::string::npos or close == std::string::npos or close < open)
+        {
+            throw std::runtime_error("Malformed stat line");
+        }
+
+        ProcStat stat;
+        stat.name = line.substr(open + 1, close - open - 1);
+
+        std::istringstream fields(line.substr(close + 1));
+        std::vector<std::string> values;
+        std::string value;
+        while (fields >> value and values.size() <= NUM_THREADS_FIELD)
+        {
+            values.push_back(value);
+        }
+        if (values.size() <= NUM_THREADS_FIELD)
+        {
+            throw std::runtime_error("Malformed stat line");
+        }
+        stat.user_s = std::stod(values.at(UTIME_FIELD)) / ticks_per_second;
+        stat.system_s = std::stod(values.at(STIME_FIELD)) / ticks_per_second;
+        stat.threads = std::stoul(values.at(NUM_THREADS_FIELD));
+        return stat;
+    }
+
+    std::vector<std::pair<std::string, std::string>> ResourceReport::key_values() const
+    {
+        std::vector<std::pair<std::string, std::string>> kv;
+        kv.emplace_back("interval (s)", format(interval_s, 2));
+        kv.emplace_back("cpu (%)", format(cpu_percent, 1));
+        kv.emplace_back("total cpu (s)", format(total_cpu_s, 2));
+        kv.emplace_back("rss (kB)", std::to_string(rss_kb));
+        kv.emplace_back("peak rss (kB)", std::to_string(peak_rss_kb));
+        kv.emplace_back("threads", std::to_string(threads.size()));
+        for (const auto &t : threads)
+        {
+            kv.emplace_back(
+                "thread " + std::to_string(t.tid) + " " + t.name + " cpu (%)", format(t.cpu_percent, 1));
+        }
+        for (const auto &t : topics)
+        {
+            const std::string direction = t.published ? "publish " : "subscribe ";
+            kv.emplace_back(direction + t.topic + " (Hz)", format(t.rate_hz, 2));
+        }
+        return kv;
+    }
+
+    std::string ResourceReport::summary() const
+    {
+        std::ostringstream ss;
+        ss << format(cpu_percent, 1) << "% cpu, " << rss_kb / 1024 << " MB resident, "
+           << threads.size() << " threads";
+        return ss.str();
+    }
+
+    ResourceMonitor::ResourceMonitor()
+    {
+        const long ticks = sysconf(_SC_CLK_TCK);
+        if (ticks > 0)
+        {
+            ticks_per_second = static_cast<double>(ticks);
+        }
+        std::map<int, ProcStat> threads;
+        last_cpu_s = read_cpu(threads);
+        for (const auto &[tid, stat] : threads)
+        {
+            last_thread_cpu_s[tid] = stat.user_s + stat.system_s;
+        }
+    }
+
+    double ResourceMonitor::read_cpu(std::map<int, ProcStat> &threads) const
+    {
+        namespace fs = std::filesystem;
+        threads.clear();
+        std::error_code ec;
+        for (fs::directory_iterator it("/proc/self/task", ec), end; not ec and it != end; it.increment(ec))
+        {
+            try
+            {
+                const int tid = std::stoi(it->path().filename().string());
+                threads[tid] = parse_proc_stat(read_file((it->path() / "stat").string()), ticks_per_second);
+            }
+            catch (const std::exception &)
+            {
+                // the thread exited while the directory was read
+            }
+        }
+
+        try
+        {
+            const ProcStat process = parse_proc_stat(read_file("/proc/self/stat"), ticks_per_second);
+            return process.user_s + process.system_s;
+        }
+        catch (const std::exception &)
+        {
+            return 0.0;
+        }
+    }
+
+    size_t ResourceMonitor::add_publisher(const std::string &topic)
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        auto &t = topics.emplace_back();
+        t.name = topic;
+        t.published = true;
+        return topics.size() - 1;
+    }
+
+    size_t ResourceMonitor::add_subscription(const std::string &topic)
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        topics.emplace_back().name = topic;
+        return topics.size() - 1;
+    }
+
+    void ResourceMonitor::count(size_t id)
+    {
+        topics.at(id).messages.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ResourceReport ResourceMonitor::report()
+    {
+        std::map<int, ProcStat> threads;
+        const double cpu_s = read_cpu(threads);
+
+        const std::lock_guard<std::mutex> lock(mutex);
+        ResourceReport report;
+        report.interval_s = since_report.elapsed_s();
+        since_report.reset();
+        const double to_percent = report.interval_s > 0.0 ? 100.0 / report.interval_s : 0.0;
+
+        report.total_cpu_s = cpu_s;
+        report.cpu_percent = std::max(0.0, cpu_s - last_cpu_s) * to_percent;
+        last_cpu_s = cpu_s;
+        report.rss_kb = resident_memory_kb();
+        report.peak_rss_kb = peak_resident_memory_kb();
+
+        // threads which started during the interval count from 0
+        std::map<int, double> thread_cpu_s;
+        for (const auto &[tid, stat] : threads)
+        {
+            const double used = stat.user_s + stat.system_s;
+            const auto last = last_thread_cpu_s.find(tid);
+            const double before = last == last_thread_cpu_s.end() ? 0.0 : last->second;
+            report.threads.push_back(ThreadUsage{tid, stat.name, std::max(0.0, used - before) * to_percent});
+            thread_cpu_s[tid] = used;
+        }
+        last_thread_cpu_s = std::move(thread_cpu_s);
+        std::stable_sort(
+            report.threads.begin(), report.threads.end(),
+            [](const ThreadUsage &a, const ThreadUsage &b)
+            { return a.cpu_percent > b.cpu_percent; });
+
+        for (auto &t : topics)
+        {
+            const size_t messages = t.messages.exchange(0, std::memory_order_relaxed);
+            const double rate = report.interval_s > 0.0 ? messages / report.interval_s : 0.0;
+            report.topics.push_back(TopicRate{t.name, t.published, messages, rate});
+        }
+        return report;
+    }
+
+}
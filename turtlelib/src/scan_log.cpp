@@ -0,0 +1,208 @@
+#include "turtlelib/scan_log.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <tuple>
+
+namespace turtlelib
+{
+
+    namespace
+    {
+        constexpr char SCAN_LOG_MAGIC[4] = {'T', 'S', 'C', 'N'};
+        constexpr uint32_t SCAN_LOG_VERSION = 1;
+
+        template <class T>
+        void write_raw(std::ostream &os, const T &v)
+        {
+            os.write(reinterpret_cast<const char *>(&v), sizeof(T));
+        }
+
+        /// @brief reads one value, returning false at the end of the stream
+        template <class T>
+        bool read_raw(std::istream &is, T &v)
+        {
+            return static_cast<bool>(is.read(reinterpret_cast<char *>(&v), sizeof(T)));
+        }
+    }
+
+    double DetectionScore::precision() const
+    {
+        const size_t detections = true_positives + false_positives;
+        return detections == 0 ? 1.0 : static_cast<double>(true_positives) / detections;
+    }
+
+    double DetectionScore::recall() const
+    {
+        const size_t visible = true_positives + false_negatives;
+        return visible == 0 ? 1.0 : static_cast<double>(true_positives) / visible;
+    }
+
+    DetectionScore &DetectionScore::operator+=(const DetectionScore &rhs)
+    {
+        true_positives += rhs.true_positives;
+        false_positives += rhs.false_positives;
+        false_negatives += rhs.false_negatives;
+        return *this;
+    }
+
+    void write_scan_log_header(std::ostream &os, double obstacle_radius)
+    {
+        os.write(SCAN_LOG_MAGIC, sizeof(SCAN_LOG_MAGIC));
+        write_raw(os, SCAN_LOG_VERSION);
+        write_raw(os, obstacle_radius);
+    }
+
+    void write_recorded_scan(std::ostream &os, const RecordedScan &scan)
+    {
+        write_raw(os, scan.stamp);
+        write_raw(os, scan.pose.x);
+        write_raw(os, scan.pose.y);
+        write_raw(os, scan.pose.theta);
+        write_raw(os, scan.angle_min);
+        write_raw(os, scan.angle_increment);
+        write_raw(os, static_cast<uint64_t>(scan.ranges.size()));
+        os.write(reinterpret_cast<const char *>(scan.ranges.data()), scan.ranges.size() * sizeof(float));
+        write_raw(os, static_cast<uint64_t>(scan.obstacles.size()));
+        for (const auto &p : scan.obstacles)
+        {
+            write_raw(os, p.x);
+            write_raw(os, p.y);
+        }
+    }
+
+    ScanLog read_scan_log(std::istream &is)
+    {
+        char magic[sizeof(SCAN_LOG_MAGIC)] = {};
+        if (not is.read(magic, sizeof(magic)) or not std::equal(magic, magic + sizeof(magic), SCAN_LOG_MAGIC))
+        {
+            throw std::runtime_error("Not a scan log");
+        }
+        uint32_t version = 0;
+        if (not read_raw(is, version) or version != SCAN_LOG_VERSION)
+        {
+            throw std::runtime_error("Unsupported scan log version");
+        }
+
+        ScanLog log;
+        if (not read_raw(is, log.obstacle_radius))
+        {
+            throw std::runtime_error("Unexpected end of scan log");
+        }
+
+        while (true)
+        {
+            RecordedScan scan;
+            uint64_t n_ranges = 0;
+            uint64_t n_obstacles = 0;
+            if (not(read_raw(is, scan.stamp) and read_raw(is, scan.pose.x) and
+                    read_raw(is, scan.pose.y) and read_raw(is, scan.pose.theta) and
+                    read_raw(is, scan.angle_min) and read_raw(is, scan.angle_increment) and
+                    read_raw(is, n_ranges)))
+            {
+                break;
+            }
+            scan.ranges.resize(n_ranges);
+            if (not is.read(reinterpret_cast<char *>(scan.ranges.data()), n_ranges * sizeof(float)) or
+                not read_raw(is, n_obstacles))
+            {
+                break;
+            }
+            bool complete = true;
+            for (uint64_t i = 0; i < n_obstacles and complete; i++)
+            {
+                Vector2D p;
+                complete = read_raw(is, p.x) and read_raw(is, p.y);
+                scan.obstacles.push_back(p);
+            }
+            if (not complete)
+            {
+                break;
+            }
+            log.scans.push_back(std::move(scan));
+        }
+        return log;
+    }
+
+    std::vector<Vector2D> visible_obstacles(
+        const RecordedScan &scan, double obstacle_radius, double tolerance,
+        size_t min_returns)
+    {
+        // obstacles in the frame of the sensor
+        const Transform2D T_sw = Transform2D(Vector2D{scan.pose.x, scan.pose.y}, scan.pose.theta).inv();
+        std::vector<Vector2D> obstacles;
+        obstacles.reserve(scan.obstacles.size());
+        for (const auto &p : scan.obstacles)
+        {
+            obstacles.push_back(T_sw(p));
+        }
+
+        std::vector<size_t> returns(obstacles.size(), 0);
+        for (size_t i = 0; i < scan.ranges.size(); i++)
+        {
+            const double r = scan.ranges.at(i);
+            if (r <= 0.0)
+            {
+                continue;
+            }
+            const Vector2D end = Vector2D::from_polar(r, scan.angle_min + i * scan.angle_increment);
+            for (size_t j = 0; j < obstacles.size(); j++)
+            {
+                if (std::abs(distance(end, obstacles.at(j)) - obstacle_radius) <= tolerance)
+                {
+                    returns.at(j)++;
+                }
+            }
+        }
+
+        std::vector<Vector2D> visible;
+        for (size_t j = 0; j < obstacles.size(); j++)
+        {
+            if (returns.at(j) >= min_returns)
+            {
+                visible.push_back(obstacles.at(j));
+            }
+        }
+        return visible;
+    }
+
+    DetectionScore score_detections(
+        const std::vector<Vector2D> &detections, const std::vector<Vector2D> &truth,
+        double match_distance)
+    {
+        // every close enough pair, closest first
+        std::vector<std::tuple<double, size_t, size_t>> pairs;
+        for (size_t i = 0; i < detections.size(); i++)
+        {
+            for (size_t j = 0; j < truth.size(); j++)
+            {
+                const double d = distance(detections.at(i), truth.at(j));
+                if (d <= match_distance)
+                {
+                    pairs.emplace_back(d, i, j);
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+
+        std::vector<bool> detection_matched(detections.size(), false);
+        std::vector<bool> truth_matched(truth.size(), false);
+        DetectionScore score;
+        for (const auto &[d, i, j] : pairs)
+        {
+            if (not detection_matched.at(i) and not truth_matched.at(j))
+            {
+                detection_matched.at(i) = true;
+                truth_matched.at(j) = true;
+                score.true_positives++;
+            }
+        }
+        score.false_positives = detections.size() - score.true_positives;
+        score.false_negatives = truth.size() - score.true_positives;
+        return score;
+    }
+
+}
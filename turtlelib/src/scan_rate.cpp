@@ -0,0 +1,128 @@
+#include "turtlelib/scan_rate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace turtlelib
+{
+
+    namespace
+    {
+        /// @brief places value between its low and high thresholds, from 0 to 1
+        double ramp(double value, double low, double high)
+        {
+            if (high <= low)
+            {
+                return value > low ? 1.0 : 0.0;
+            }
+            return std::clamp((value - low) / (high - low), 0.0, 1.0);
+        }
+    }
+
+    ScanRateController::ScanRateController() : ScanRateController(ScanRateParams{})
+    {
+    }
+
+    ScanRateController::ScanRateController(const ScanRateParams &p) : params(p)
+    {
+        if (params.min_rate <= 0.0 or params.max_rate < params.min_rate)
+        {
+            throw std::invalid_argument("The scan rates must be positive, min_rate at most max_rate");
+        }
+        if (params.confident_position_std > params.uncertain_position_std or
+            params.confident_heading_std > params.uncertain_heading_std or
+            params.slow_speed > params.fast_speed or
+            params.slow_turn_rate > params.fast_turn_rate)
+        {
+            throw std::invalid_argument("Each lower threshold must be at most its upper threshold");
+        }
+        if (params.timeout * params.min_rate <= 1.0)
+        {
+            throw std::invalid_argument("The timeout must be longer than the period of min_rate");
+        }
+    }
+
+    void ScanRateController::set_pose_covariance(double stamp, const std::array<double, 9> &cov)
+    {
+        // largest eigenvalue of the (x, y) block
+        const double half_trace = 0.5 * (cov.at(4) + cov.at(8));
+        const double half_diff = 0.5 * (cov.at(4) - cov.at(8));
+        const double largest = half_trace + std::sqrt(half_diff * half_diff + cov.at(5) * cov.at(5));
+        set_uncertainty(stamp, std::sqrt(std::max(0.0, largest)), std::sqrt(std::max(0.0, cov.at(0))));
+    }
+
+    void ScanRateController::set_uncertainty(double stamp, double pos_std, double head_std)
+    {
+        have_uncertainty = true;
+        uncertainty_stamp = stamp;
+        position_std = pos_std;
+        heading_std = head_std;
+    }
+
+    void ScanRateController::set_speed(double stamp, double linear, double angular)
+    {
+        have_speed = true;
+        speed_stamp = stamp;
+        speed = std::abs(linear);
+        turn_rate = std::abs(angular);
+    }
+
+    double ScanRateController::demand(double stamp) const
+    {
+        if (not have_uncertainty or not have_speed or
+            stamp - uncertainty_stamp > params.timeout or stamp - speed_stamp > params.timeout)
+        {
+            return 1.0;
+        }
+        return std::max(
+            {ramp(position_std, params.confident_position_std, params.uncertain_position_std),
+             ramp(heading_std, params.confident_heading_std, params.uncertain_heading_std),
+             ramp(speed, params.slow_speed, params.fast_speed),
+             ramp(turn_rate, params.slow_turn_rate, params.fast_turn_rate)});
+    }
+
+    double ScanRateController::rate(double stamp) const
+    {
+        return params.min_rate + demand(stamp) * (params.max_rate - params.min_rate);
+    }
+
+    bool ScanRateController::accept(double stamp)
+    {
+        if (have_scan and stamp > last_scan)
+        {
+            // a running average smooths out jitter in the arrival of scans
+            const double interval = stamp - last_scan;
+            scan_interval = scan_interval > 0.0 ? 0.9 * scan_interval + 0.1 * interval : interval;
+        }
+        have_scan = true;
+        last_scan = stamp;
+
+        const double period = 1.0 / rate(stamp);
+        if (have_accepted and stamp - last_accepted + 0.5 * scan_interval < period)
+        {
+            n_skipped++;
+            return false;
+        }
+        have_accepted = true;
+        last_accepted = stamp;
+        n_accepted++;
+        return true;
+    }
+
+    size_t ScanRateController::accepted() const
+    {
+        return n_accepted;
+    }
+
+    size_t ScanRateController::skipped() const
+    {
+        return n_skipped;
+    }
+
+    void ScanRateController::reset_counts()
+    {
+        n_accepted = 0;
+        n_skipped = 0;
+    }
+
+}
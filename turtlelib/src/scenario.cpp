@@ -0,0 +1,164 @@
+#include "turtlelib/scenario.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace turtlelib
+{
+
+    Scenario::Scenario(const Pose2D &start)
+        : planned_pose(start)
+    {
+    }
+
+    void Scenario::add_twist(double duration, const Twist2D &twist)
+    {
+        if (duration < 0.0)
+        {
+            throw std::invalid_argument("Scenario step durations cannot be negative");
+        }
+        if (almost_equal(duration, 0.0))
+        {
+            return;
+        }
+
+        steps.push_back(ScenarioStep{duration, twist});
+        end_times.push_back(this->duration() + duration);
+
+        // integrate the twist held for the whole step
+        const Transform2D T_wb(Vector2D{planned_pose.x, planned_pose.y}, planned_pose.theta);
+        const Transform2D T_wbp = T_wb * T_wb.integrate_twist(
+            Twist2D{twist.thetadot * duration, twist.xdot * duration, twist.ydot * duration});
+        planned_pose = Pose2D{T_wbp.translation().x, T_wbp.translation().y, T_wbp.rotation()};
+    }
+
+    void Scenario::add_waypoint(const Vector2D &goal, double speed, double turn_rate)
+    {
+        if (speed <= 0.0 or turn_rate <= 0.0)
+        {
+            throw std::invalid_argument("Waypoint speeds must be positive");
+        }
+
+        const Vector2D delta = goal - Vector2D{planned_pose.x, planned_pose.y};
+        const double dist = delta.magnitude();
+        if (almost_equal(dist, 0.0))
+        {
+            return;
+        }
+
+        // turn in place to face the goal, the short way around
+        const double turn = normalize_angle(std::atan2(delta.y, delta.x) - planned_pose.theta);
+        add_twist(std::abs(turn) / turn_rate, Twist2D{std::copysign(turn_rate, turn), 0.0, 0.0});
+
+        add_twist(dist / speed, Twist2D{0.0, speed, 0.0});
+    }
+
+    const std::vector<ScenarioStep> &Scenario::get_steps() const
+    {
+        return steps;
+    }
+
+    Pose2D Scenario::end_pose() const
+    {
+        return planned_pose;
+    }
+
+    double Scenario::duration() const
+    {
+        return end_times.empty() ? 0.0 : end_times.back();
+    }
+
+    Twist2D Scenario::twist_at(double t) const
+    {
+        if (t < 0.0)
+        {
+            return Twist2D{};
+        }
+        const auto it = std::upper_bound(end_times.begin(), end_times.end(), t);
+        if (it == end_times.end())
+        {
+            return Twist2D{};
+        }
+        return steps.at(static_cast<size_t>(it - end_times.begin())).twist;
+    }
+
+    Scenario parse_scenario(std::istream &is)
+    {
+        constexpr double DEFAULT_SPEED = 0.1;
+        constexpr double DEFAULT_TURN_RATE = 0.5;
+
+        Scenario scenario;
+        bool started = false;
+        std::string line;
+        size_t line_number = 0;
+        while (std::getline(is, line))
+        {
+            line_number++;
+            line = line.substr(0, line.find('#'));
+            std::istringstream ss(line);
+            std::string command;
+            if (not(ss >> command))
+            {
+                continue;
+            }
+
+            const auto fail = [&]()
+            {
+                throw std::runtime_error(
+                    "Invalid scenario command on line " + std::to_string(line_number) + ": " + line);
+            };
+
+            std::vector<double> args;
+            double arg = 0.0;
+            while (ss >> arg)
+            {
+                args.push_back(arg);
+            }
+            if (not ss.eof())
+            {
+                fail();
+            }
+
+            try
+            {
+                if (command == "start" and args.size() == 3)
+                {
+                    if (started)
+                    {
+                        fail();
+                    }
+                    scenario = Scenario(Pose2D{args.at(0), args.at(1), args.at(2)});
+                }
+                else if (command == "twist" and args.size() == 3)
+                {
+                    scenario.add_twist(args.at(0), Twist2D{args.at(2), args.at(1), 0.0});
+                }
+                else if (command == "wait" and args.size() == 1)
+                {
+                    scenario.add_twist(args.at(0), Twist2D{});
+                }
+                else if (command == "waypoint" and args.size() >= 2 and args.size() <= 4)
+                {
+                    scenario.add_waypoint(
+                        Vector2D{args.at(0), args.at(1)},
+                        args.size() > 2 ? args.at(2) : DEFAULT_SPEED,
+                        args.size() > 3 ? args.at(3) : DEFAULT_TURN_RATE);
+                }
+                else
+                {
+                    fail();
+                }
+            }
+            catch (const std::invalid_argument &)
+            {
+                fail();
+            }
+            started = true;
+        }
+        return scenario;
+    }
+
+}
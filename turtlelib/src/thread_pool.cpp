@@ -0,0 +1,138 @@
+#include "turtlelib/thread_pool.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace turtlelib
+{
+
+    ThreadPool::ThreadPool(size_t threads)
+    {
+        if (threads == 0)
+        {
+            throw std::invalid_argument("A thread pool needs at least one thread");
+        }
+        workers.reserve(threads - 1);
+        for (size_t chunk = 1; chunk < threads; chunk++)
+        {
+            workers.emplace_back(&ThreadPool::work, this, chunk);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        start.notify_all();
+        for (auto &w : workers)
+        {
+            w.join();
+        }
+    }
+
+    size_t ThreadPool::size() const
+    {
+        return workers.size() + 1;
+    }
+
+    size_t ThreadPool::chunk_begin(size_t chunk) const
+    {
+        // the first count % size() chunks get one item more than the others
+        const size_t per_chunk = job_count / size();
+        const size_t extra = job_count % size();
+        return chunk * per_chunk + std::min(chunk, extra);
+    }
+
+    void ThreadPool::run_chunk(size_t chunk)
+    {
+        const size_t begin = chunk_begin(chunk);
+        const size_t end = chunk_begin(chunk + 1);
+        if (begin == end)
+        {
+            return;
+        }
+        try
+        {
+            (*job)(chunk, begin, end);
+        }
+        catch (...)
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            if (not error)
+            {
+                error = std::current_exception();
+            }
+        }
+    }
+
+    void ThreadPool::work(size_t chunk)
+    {
+        size_t seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start.wait(lock, [&]
+                           { return stopping or generation != seen; });
+                if (stopping)
+                {
+                    return;
+                }
+                seen = generation;
+            }
+
+            run_chunk(chunk);
+
+            bool last = false;
+            {
+                const std::lock_guard<std::mutex> lock(mutex);
+                last = --pending == 0;
+            }
+            if (last)
+            {
+                done.notify_one();
+            }
+        }
+    }
+
+    void ThreadPool::parallel_for(size_t count, const std::function<void(size_t, size_t, size_t)> &fn)
+    {
+        const std::lock_guard<std::mutex> job_lock(job_mutex);
+        if (workers.empty() or count < 2)
+        {
+            if (count > 0)
+            {
+                fn(0, 0, count);
+            }
+            return;
+        }
+
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            job_count = count;
+            pending = workers.size();
+            error = nullptr;
+            generation++;
+        }
+        start.notify_all();
+
+        run_chunk(0);
+
+        std::exception_ptr thrown;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&]
+                      { return pending == 0; });
+            job = nullptr;
+            thrown = error;
+            error = nullptr;
+        }
+        if (thrown)
+        {
+            std::rethrow_exception(thrown);
+        }
+    }
+
+}
@@ -0,0 +1,115 @@
+#include "turtlelib/watchdog.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace turtlelib
+{
+
+    namespace
+    {
+        // weight of the newest interval in the running estimate of a message period
+        constexpr double PERIOD_SMOOTHING = 0.1;
+    }
+
+    CallbackWatchdog::Scope::Scope(CallbackWatchdog &w, size_t callback_id)
+        : watchdog(w), id(callback_id)
+    {
+    }
+
+    CallbackWatchdog::Scope::~Scope()
+    {
+        watchdog.record_duration(id, stopwatch.elapsed_us());
+    }
+
+    size_t CallbackWatchdog::add_callback(const std::string &name, double budget_us)
+    {
+        if (budget_us < 0.0)
+        {
+            throw std::invalid_argument("Callback budgets cannot be negative");
+        }
+        Entry entry;
+        entry.health.name = name;
+        entry.health.budget_us = budget_us;
+        const std::lock_guard<std::mutex> lock(mutex);
+        entries.push_back(entry);
+        return entries.size() - 1;
+    }
+
+    bool CallbackWatchdog::record_duration(size_t id, double duration_us)
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        CallbackHealth &h = entries.at(id).health;
+        h.calls++;
+        h.max_duration_us = std::max(h.max_duration_us, duration_us);
+        if (h.budget_us > 0.0 and duration_us > h.budget_us)
+        {
+            h.overruns++;
+            pending_overruns.push_back(Overrun{h.name, duration_us, h.budget_us});
+            return true;
+        }
+        return false;
+    }
+
+    void CallbackWatchdog::record_message(size_t id, double stamp_s, double now_s)
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        Entry &e = entries.at(id);
+        const double age = std::max(0.0, now_s - stamp_s);
+        e.health.max_message_age_s = std::max(e.health.max_message_age_s, age);
+
+        if (e.last_stamp_s > 0.0 and stamp_s > e.last_stamp_s)
+        {
+            const double interval = stamp_s - e.last_stamp_s;
+            e.period_s = e.period_s > 0.0 ? (1.0 - PERIOD_SMOOTHING) * e.period_s + PERIOD_SMOOTHING * interval
+                                          : interval;
+        }
+        e.last_stamp_s = stamp_s;
+
+        if (e.period_s > 0.0)
+        {
+            const auto depth = static_cast<size_t>(std::floor(age / e.period_s));
+            e.health.max_queue_depth = std::max(e.health.max_queue_depth, depth);
+        }
+    }
+
+    void CallbackWatchdog::record_lost(size_t id, size_t count)
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        entries.at(id).health.messages_lost += count;
+    }
+
+    std::vector<Overrun> CallbackWatchdog::take_overruns()
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        std::vector<Overrun> overruns;
+        overruns.swap(pending_overruns);
+        return overruns;
+    }
+
+    CallbackHealth CallbackWatchdog::health(size_t id) const
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        return entries.at(id).health;
+    }
+
+    size_t CallbackWatchdog::size() const
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    void CallbackWatchdog::reset()
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        for (auto &e : entries)
+        {
+            CallbackHealth cleared;
+            cleared.name = e.health.name;
+            cleared.budget_us = e.health.budget_us;
+            e.health = cleared;
+        }
+        pending_overruns.clear();
+    }
+
+}
@@ -0,0 +1,286 @@
+#include "turtlelib/world.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+namespace turtlelib
+{
+
+    namespace
+    {
+        constexpr char WORLD_MAGIC[4] = {'T', 'W', 'L', 'D'};
+        constexpr uint32_t WORLD_VERSION = 1;
+
+        // uniform number in [0, 1) computed directly from the generator output, since the
+        // standard distributions are implementation defined and would break reproducibility
+        double uniform01(std::mt19937 &rng)
+        {
+            return static_cast<double>(rng()) / 4294967296.0;
+        }
+
+        double uniform(std::mt19937 &rng, double lo, double hi)
+        {
+            return lo + (hi - lo) * uniform01(rng);
+        }
+
+        // Uniform grid of already placed obstacles, so checking the minimum spacing
+        // only looks at the neighboring cells instead of every obstacle
+        class SpacingGrid
+        {
+        private:
+            double spacing;
+            double cell;
+            double x_min;
+            double y_min;
+            long nx = 0;
+            long ny = 0;
+            std::vector<std::vector<Vector2D>> cells;
+
+            long clamp_index(double v, double v_min, long n) const
+            {
+                return std::clamp(static_cast<long>(std::floor((v - v_min) / cell)), 0L, n - 1);
+            }
+
+        public:
+            SpacingGrid(double min_spacing, double x_length, double y_length)
+                : spacing(min_spacing),
+                  cell(std::max(min_spacing, std::max(x_length, y_length) / 1024.0)),
+                  x_min(-x_length / 2.0),
+                  y_min(-y_length / 2.0)
+            {
+                if (spacing > 0.0)
+                {
+                    nx = static_cast<long>(std::ceil(x_length / cell)) + 1;
+                    ny = static_cast<long>(std::ceil(y_length / cell)) + 1;
+                    cells.resize(static_cast<size_t>(nx * ny));
+                }
+            }
+
+            bool is_free(const Vector2D &p) const
+            {
+                if (cells.empty())
+                {
+                    return true;
+                }
+                const long ix = clamp_index(p.x, x_min, nx);
+                const long iy = clamp_index(p.y, y_min, ny);
+                for (long i = std::max(ix - 1, 0L); i <= std::min(ix + 1, nx - 1); i++)
+                {
+                    for (long j = std::max(iy - 1, 0L); j <= std::min(iy + 1, ny - 1); j++)
+                    {
+                        for (const auto &q : cells.at(static_cast<size_t>(i * ny + j)))
+                        {
+                            if (distance(p, q) < spacing)
+                            {
+                                return false;
+                            }
+                        }
+                    }
+                }
+                return true;
+            }
+
+            void insert(const Vector2D &p)
+            {
+                if (cells.empty())
+                {
+                    return;
+                }
+                const long ix = clamp_index(p.x, x_min, nx);
+                const long iy = clamp_index(p.y, y_min, ny);
+                cells.at(static_cast<size_t>(ix * ny + iy)).push_back(p);
+            }
+        };
+
+        template <class T>
+        void write_raw(std::ostream &os, const T &v)
+        {
+            os.write(reinterpret_cast<const char *>(&v), sizeof(T));
+        }
+
+        template <class T>
+        T read_raw(std::istream &is)
+        {
+            T v{};
+            if (not is.read(reinterpret_cast<char *>(&v), sizeof(T)))
+            {
+                throw std::runtime_error("Unexpected end of world file");
+            }
+            return v;
+        }
+    }
+
+    World generate_world(const WorldParams &params)
+    {
+        if (params.x_length <= 0.0 or params.y_length <= 0.0)
+        {
+            throw std::invalid_argument("World dimensions must be positive");
+        }
+
+        std::mt19937 rng{params.seed};
+
+        World world;
+        world.x_length = params.x_length;
+        world.y_length = params.y_length;
+        world.obstacle_radius = params.obstacle_radius;
+
+        // keep whole obstacles inside the walls
+        const double x_max = params.x_length / 2.0 - params.obstacle_radius;
+        const double y_max = params.y_length / 2.0 - params.obstacle_radius;
+        const auto inside = [&](const Vector2D &p)
+        {
+            return std::abs(p.x) <= x_max and std::abs(p.y) <= y_max and
+                   p.magnitude() >= params.start_clearance;
+        };
+
+        SpacingGrid grid(params.min_spacing, params.x_length, params.y_length);
+
+        // Corridors: two parallel rows of obstacles, alternating between along x and along y
+        const double corridor_length = params.corridor_length > 0.0
+                                           ? params.corridor_length
+                                           : std::min(params.x_length, params.y_length) / 2.0;
+        const double post_spacing = std::max(params.post_spacing, 2.0 * params.obstacle_radius);
+        for (size_t c = 0; c < params.corridors; c++)
+        {
+            const bool along_x = (c % 2 == 0);
+            const Vector2D center{uniform(rng, -x_max, x_max), uniform(rng, -y_max, y_max)};
+            const auto n_posts = static_cast<size_t>(std::floor(corridor_length / post_spacing)) + 1;
+            for (size_t i = 0; i < n_posts; i++)
+            {
+                const double along = -corridor_length / 2.0 + i * post_spacing;
+                for (const double side : {-0.5, 0.5})
+                {
+                    const double across = side * params.corridor_width;
+                    const Vector2D p = along_x ? center + Vector2D{along, across}
+                                               : center + Vector2D{across, along};
+                    if (inside(p))
+                    {
+                        world.obstacles.push_back(p);
+                        grid.insert(p);
+                    }
+                }
+            }
+        }
+
+        // Random obstacles, some of them clustered
+        const double area = params.x_length * params.y_length;
+        const auto n_random = static_cast<size_t>(std::round(params.density * area));
+        const double clustering = std::clamp(params.clustering, 0.0, 1.0);
+
+        std::vector<Vector2D> cluster_centers;
+        if (clustering > 0.0)
+        {
+            const size_t n_clusters = params.clusters > 0 ? params.clusters
+                                                          : std::max<size_t>(1, n_random / 10);
+            for (size_t i = 0; i < n_clusters; i++)
+            {
+                cluster_centers.push_back(Vector2D{uniform(rng, -x_max, x_max), uniform(rng, -y_max, y_max)});
+            }
+        }
+
+        constexpr size_t MAX_ATTEMPTS = 100;
+        for (size_t i = 0; i < n_random; i++)
+        {
+            const bool clustered = not cluster_centers.empty() and uniform01(rng) < clustering;
+            const Vector2D center = clustered
+                                        ? cluster_centers.at(static_cast<size_t>(uniform01(rng) * cluster_centers.size()))
+                                        : Vector2D{};
+            for (size_t attempt = 0; attempt < MAX_ATTEMPTS; attempt++)
+            {
+                Vector2D p;
+                if (clustered)
+                {
+                    // uniform over the disc around the cluster center
+                    const double r = params.cluster_radius * std::sqrt(uniform01(rng));
+                    const double theta = uniform(rng, -PI, PI);
+                    p = center + Vector2D::from_polar(r, theta);
+                }
+                else
+                {
+                    p = Vector2D{uniform(rng, -x_max, x_max), uniform(rng, -y_max, y_max)};
+                }
+
+                if (inside(p) and grid.is_free(p))
+                {
+                    world.obstacles.push_back(p);
+                    grid.insert(p);
+                    break;
+                }
+            }
+        }
+
+        return world;
+    }
+
+    void write_world_yaml(const World &world, std::ostream &os, const std::string &node_name)
+    {
+        const auto write_array = [&](const std::string &name, double Vector2D::*coord)
+        {
+            os << "    " << name << ": [";
+            for (size_t i = 0; i < world.obstacles.size(); i++)
+            {
+                if (i > 0)
+                {
+                    os << ", ";
+                }
+                os << world.obstacles.at(i).*coord;
+            }
+            os << "]\n";
+        };
+
+        const auto precision = os.precision(9);
+        os << node_name << ":\n";
+        os << "  ros__parameters:\n";
+        os << "    wall_x_length: " << world.x_length << "\n";
+        os << "    wall_y_length: " << world.y_length << "\n";
+        write_array("obstacles/x", &Vector2D::x);
+        write_array("obstacles/y", &Vector2D::y);
+        os << "    obstacles/r: " << world.obstacle_radius << "\n";
+        os.precision(precision);
+    }
+
+    void write_world_binary(const World &world, std::ostream &os)
+    {
+        os.write(WORLD_MAGIC, sizeof(WORLD_MAGIC));
+        write_raw(os, WORLD_VERSION);
+        write_raw(os, world.x_length);
+        write_raw(os, world.y_length);
+        write_raw(os, world.obstacle_radius);
+        write_raw(os, static_cast<uint64_t>(world.obstacles.size()));
+        for (const auto &p : world.obstacles)
+        {
+            write_raw(os, p.x);
+            write_raw(os, p.y);
+        }
+    }
+
+    World read_world_binary(std::istream &is)
+    {
+        char magic[sizeof(WORLD_MAGIC)] = {};
+        if (not is.read(magic, sizeof(magic)) or not std::equal(magic, magic + sizeof(magic), WORLD_MAGIC))
+        {
+            throw std::runtime_error("Not a world file");
+        }
+        if (read_raw<uint32_t>(is) != WORLD_VERSION)
+        {
+            throw std::runtime_error("Unsupported world file version");
+        }
+
+        World world;
+        world.x_length = read_raw<double>(is);
+        world.y_length = read_raw<double>(is);
+        world.obstacle_radius = read_raw<double>(is);
+        const auto n = read_raw<uint64_t>(is);
+        for (uint64_t i = 0; i < n; i++)
+        {
+            const double x = read_raw<double>(is);
+            const double y = read_raw<double>(is);
+            world.obstacles.push_back(Vector2D{x, y});
+        }
+        return world;
+    }
+
+}
@@ -2,9 +2,30 @@
 #include "turtlelib/rigid2d.hpp"
 #include "turtlelib/diff_drive.hpp"
 #include "turtlelib/kalman.hpp"
+#include "turtlelib/benchmark.hpp"
+#include "turtlelib/lidar.hpp"
+#include "turtlelib/world.hpp"
+#include "turtlelib/scenario.hpp"
+#include "turtlelib/alloc_tracker.hpp"
+#include "turtlelib/realtime.hpp"
+#include "turtlelib/watchdog.hpp"
+#include "turtlelib/pose_extrapolator.hpp"
+#include "turtlelib/odometry.hpp"
+#include "turtlelib/moving_obstacles.hpp"
+#include "turtlelib/explore.hpp"
+#include "turtlelib/scan_log.hpp"
+#include "turtlelib/resource_monitor.hpp"
+#include "turtlelib/scan_rate.hpp"
+#include "turtlelib/thread_pool.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <cmath>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 namespace turtlelib
 {
@@ -513,4 +534,1059 @@ namespace turtlelib
         
     }
 
+    TEST_CASE("stats()", "[KalmanFilter]")
+    {
+        KalmanFilter ekf(0.001, 0.01);
+        REQUIRE(ekf.stats().runs == 0);
+        REQUIRE(ekf.stats().state_dimension == 3);
+
+        // two new landmarks with known association
+        const std::vector<LandmarkMeasurement> known{
+            LandmarkMeasurement::from_cartesian(1.0, 0.0, 1),
+            LandmarkMeasurement::from_cartesian(0.0, 2.0, 2)};
+        ekf.run(Pose2D{}, Twist2D{}, known);
+        FilterStats st = ekf.stats();
+        REQUIRE(st.runs == 1);
+        REQUIRE(st.landmarks == 2);
+        REQUIRE(st.state_dimension == 7);
+        REQUIRE(st.bytes >= (7 + 49 + 9 + 4) * sizeof(double));
+        const size_t known_bytes = st.bytes;
+        REQUIRE(st.last_measurements == 2);
+        REQUIRE(st.last_new_landmarks == 2);
+        REQUIRE(st.last_associated == 0);
+        REQUIRE(st.last_update_us >= 0.0);
+
+        // the same landmarks again, with unknown association
+        const std::vector<LandmarkMeasurement> unknown{
+            LandmarkMeasurement::from_cartesian(1.0, 0.0),
+            LandmarkMeasurement::from_cartesian(0.0, 2.0)};
+        ekf.run(Pose2D{}, Twist2D{}, unknown);
+        st = ekf.stats();
+        REQUIRE(st.runs == 2);
+        REQUIRE(st.landmarks == 2);
+        REQUIRE(st.last_associated == 2);
+        REQUIRE(st.last_new_landmarks == 0);
+        REQUIRE(st.total_measurements == 4);
+        REQUIRE(st.total_new_landmarks == 2);
+        REQUIRE(st.total_associated == 2);
+        REQUIRE(st.total_update_us >= st.last_update_us);
+
+        // association mirrored both landmarks into 16 arrays of doubles and one of ids, and
+        // kept the distances of the measurements
+        REQUIRE(st.bytes >= known_bytes + 2 * (16 + 1) * sizeof(double) + 2 * sizeof(unsigned int));
+    }
+
+    TEST_CASE("mahalanobis_distances()", "[KalmanFilter]")
+    {
+        KalmanFilter ekf(0.001, 0.01);
+        ekf.run(Pose2D{}, Twist2D{},
+                {LandmarkMeasurement::from_cartesian(1.2, 0.0, 4),
+                 LandmarkMeasurement::from_cartesian(-0.5, 1.0, 1),
+                 LandmarkMeasurement::from_cartesian(0.3, -2.0, 7),
+                 LandmarkMeasurement::from_cartesian(1.1, 0.1, 2)});
+        ekf.run(Pose2D{0.2, 0.05, -0.02}, Twist2D{0.2, 0.05, 0.0},
+                {LandmarkMeasurement::from_cartesian(1.0, -0.2, 4),
+                 LandmarkMeasurement::from_cartesian(-0.7, 0.9, 1)});
+
+        // the reference is H sigma H^T + R of the full state
+        const auto reference = [](const KalmanFilter &f, const LandmarkMeasurement &z)
+        {
+            const arma::mat Xi = f.state_prediction();
+            const arma::mat sigma = f.covariance();
+            std::vector<double> d;
+            for (arma::uword k = 3; k < Xi.n_rows; k += 2)
+            {
+                const double dx = Xi(k, 0) - Xi(1, 0);
+                const double dy = Xi(k + 1, 0) - Xi(2, 0);
+                const double q = dx * dx + dy * dy;
+                const double sq = std::sqrt(q);
+                arma::mat H(2, Xi.n_rows, arma::fill::zeros);
+                H(0, 1) = -dx / sq;
+                H(0, 2) = -dy / sq;
+                H(0, k) = dx / sq;
+                H(0, k + 1) = dy / sq;
+                H(1, 0) = -1.0;
+                H(1, 1) = dy / q;
+                H(1, 2) = -dx / q;
+                H(1, k) = -dy / q;
+                H(1, k + 1) = dx / q;
+                const arma::mat S = H * sigma * H.t() + 0.01 * arma::mat(2, 2, arma::fill::eye);
+                arma::mat e(2, 1);
+                e(0, 0) = z.r - sq;
+                e(1, 0) = z.phi - normalize_angle(std::atan2(dy, dx) - Xi(0, 0));
+                d.push_back(arma::mat(e.t() * arma::inv(S) * e)(0, 0));
+            }
+            return d;
+        };
+
+        const auto z = LandmarkMeasurement::from_cartesian(0.9, -0.1);
+        const auto check = [&](const KalmanFilter &f)
+        {
+            const std::vector<double> d = f.mahalanobis_distances(z);
+            const std::vector<double> expected = reference(f, z);
+            REQUIRE(d.size() == 4);
+            REQUIRE(expected.size() == 4);
+            for (size_t j = 0; j < d.size(); j++)
+            {
+                REQUIRE(almost_equal(d.at(j) / expected.at(j), 1.0, 1e-9));
+            }
+        };
+        check(ekf);
+
+        // the arrays follow the landmarks when they move in the state
+        REQUIRE(ekf.reorder_landmarks());
+        check(ekf);
+
+        // and are refreshed after the prediction and every update step of a run
+        ekf.run(Pose2D{0.35, 0.1, 0.03}, Twist2D{0.15, 0.05, 0.0},
+                {LandmarkMeasurement::from_cartesian(0.8, -0.3, 4),
+                 LandmarkMeasurement::from_cartesian(-0.1, -2.1, 7)});
+        check(ekf);
+
+        // a measurement of the estimate of the second landmark is associated with it
+        const arma::mat Xi = ekf.state_prediction();
+        const double dx = Xi(5, 0) - Xi(1, 0);
+        const double dy = Xi(6, 0) - Xi(2, 0);
+        const LandmarkMeasurement exact(std::sqrt(dx * dx + dy * dy),
+                                        normalize_angle(std::atan2(dy, dx) - Xi(0, 0)));
+        REQUIRE(ekf.mahalanobis_distances(exact).at(1) < 1e-20);
+        ekf.run(Pose2D{0.35, 0.1, 0.03}, Twist2D{}, {exact});
+        REQUIRE(ekf.stats().last_associated == 1);
+        REQUIRE(ekf.associated_measurements().at(0).marker_id == ekf.landmark_ids().at(1));
+    }
+
+    TEST_CASE("set_association_threads()", "[KalmanFilter]")
+    {
+        // a grid of landmarks, enough that a scan is worth scoring in parallel
+        std::vector<LandmarkMeasurement> grid;
+        for (unsigned int id = 0; id < 200; id++)
+        {
+            grid.push_back(LandmarkMeasurement::from_cartesian(1.0 + 0.5 * (id % 20), -2.5 + 0.5 * (id / 20), id));
+        }
+        KalmanFilter sequential(0.001, 0.01);
+        KalmanFilter parallel(0.001, 0.01);
+        parallel.set_association_threads(4);
+        REQUIRE(sequential.association_threads() == 1);
+        REQUIRE(parallel.association_threads() == 4);
+        sequential.run(Pose2D{}, Twist2D{}, grid);
+        parallel.run(Pose2D{}, Twist2D{}, grid);
+        REQUIRE(parallel.stats().last_association_threads == 1);
+
+        // landmarks of the map, and new ones, the second of which is near enough to the
+        // first to be associated with it although it was only added by this scan
+        std::vector<LandmarkMeasurement> scan;
+        for (unsigned int id = 3; id < 200; id += 20)
+        {
+            scan.push_back(LandmarkMeasurement::from_cartesian(grid.at(id).r * std::cos(grid.at(id).phi),
+                                                               grid.at(id).r * std::sin(grid.at(id).phi)));
+        }
+        scan.push_back(LandmarkMeasurement::from_cartesian(-3.0, -3.0));
+        scan.push_back(LandmarkMeasurement::from_cartesian(-3.2, -3.0));
+        scan.push_back(LandmarkMeasurement::from_cartesian(-6.0, 4.0));
+        sequential.run(Pose2D{}, Twist2D{}, scan);
+        parallel.run(Pose2D{}, Twist2D{}, scan);
+        REQUIRE(sequential.stats().last_association_threads == 1);
+        REQUIRE(parallel.stats().last_association_threads == 4);
+        REQUIRE(parallel.stats().last_associated == 11);
+        REQUIRE(parallel.stats().last_new_landmarks == 2);
+        REQUIRE(parallel.associated_measurements().at(11).marker_id == 200);
+
+        const auto &expected = sequential.associated_measurements();
+        const auto &actual = parallel.associated_measurements();
+        REQUIRE(actual.size() == expected.size());
+        for (size_t i = 0; i < actual.size(); i++)
+        {
+            REQUIRE(actual.at(i).marker_id == expected.at(i).marker_id);
+        }
+        REQUIRE(arma::approx_equal(parallel.covariance(), sequential.covariance(), "absdiff", 0.0));
+        REQUIRE(arma::approx_equal(parallel.state_prediction(), sequential.state_prediction(), "absdiff", 0.0));
+
+        // a copy shares the threads
+        KalmanFilter copy = parallel;
+        REQUIRE(copy.association_threads() == 4);
+        parallel.set_association_threads(0);
+        REQUIRE(parallel.association_threads() == 1);
+    }
+
+    TEST_CASE("reorder_landmarks()", "[KalmanFilter]")
+    {
+        // first seen alternately at two ends of the map
+        const std::vector<LandmarkMeasurement> ms{
+            LandmarkMeasurement::from_cartesian(1.0, 0.0, 1),
+            LandmarkMeasurement::from_cartesian(-1.0, 3.0, 2),
+            LandmarkMeasurement::from_cartesian(1.1, 0.1, 3),
+            LandmarkMeasurement::from_cartesian(-1.1, 3.1, 4),
+            LandmarkMeasurement::from_cartesian(1.2, 0.0, 5)};
+        KalmanFilter plain(0.001, 0.01);
+        KalmanFilter sorted(0.001, 0.01);
+        sorted.set_reorder_period(1);
+        Pose2D pose{};
+        for (int i = 0; i < 4; i++)
+        {
+            pose.x += 0.01;
+            plain.run(pose, Twist2D{0.0, 0.01, 0.0}, ms);
+            sorted.run(pose, Twist2D{0.0, 0.01, 0.0}, ms);
+        }
+        REQUIRE(plain.landmark_ids() == std::vector<unsigned int>{1, 2, 3, 4, 5});
+        REQUIRE(sorted.landmark_ids() == std::vector<unsigned int>{1, 5, 3, 2, 4});
+        REQUIRE(sorted.stats().reorders == 1);
+        REQUIRE(not sorted.reorder_landmarks());
+
+        // the estimate is the same, permuted
+        REQUIRE(arma::approx_equal(sorted.pose_prediction(), plain.pose_prediction(), "absdiff", 1e-9));
+        const std::vector<arma::uword> slot{0, 3, 2, 4, 1};
+        const arma::mat map = sorted.map_prediction();
+        const arma::mat sigma = sorted.covariance();
+        const arma::mat plain_map = plain.map_prediction();
+        const arma::mat plain_sigma = plain.covariance();
+        for (arma::uword a = 0; a < 5; a++)
+        {
+            REQUIRE(almost_equal(map(2 * slot.at(a), 0), plain_map(2 * a, 0)));
+            REQUIRE(almost_equal(map(2 * slot.at(a) + 1, 0), plain_map(2 * a + 1, 0)));
+            for (arma::uword b = 0; b < 5; b++)
+            {
+                REQUIRE(arma::approx_equal(
+                    sigma.submat(3 + 2 * slot.at(a), 3 + 2 * slot.at(b), 4 + 2 * slot.at(a), 4 + 2 * slot.at(b)),
+                    plain_sigma.submat(3 + 2 * a, 3 + 2 * b, 4 + 2 * a, 4 + 2 * b), "absdiff", 1e-9));
+            }
+            REQUIRE(arma::approx_equal(
+                sigma.submat(0, 3 + 2 * slot.at(a), 2, 4 + 2 * slot.at(a)),
+                plain_sigma.submat(0, 3 + 2 * a, 2, 4 + 2 * a), "absdiff", 1e-9));
+        }
+
+        // and later updates find the landmarks where they moved
+        pose.x += 0.01;
+        plain.run(pose, Twist2D{0.0, 0.01, 0.0}, ms);
+        sorted.run(pose, Twist2D{0.0, 0.01, 0.0}, ms);
+        REQUIRE(arma::approx_equal(sorted.pose_prediction(), plain.pose_prediction(), "absdiff", 1e-9));
+        REQUIRE(almost_equal(sorted.map_prediction()(2, 0), plain.map_prediction()(8, 0)));
+    }
+
+    TEST_CASE("set_consider_distance()", "[KalmanFilter]")
+    {
+        // two landmarks near the robot and two far from it, seen together at first
+        const std::vector<LandmarkMeasurement> all{
+            LandmarkMeasurement::from_cartesian(1.0, 0.0, 1),
+            LandmarkMeasurement::from_cartesian(0.0, 1.0, 2),
+            LandmarkMeasurement::from_cartesian(5.0, 0.0, 3),
+            LandmarkMeasurement::from_cartesian(0.0, 5.0, 4)};
+        const std::vector<LandmarkMeasurement> near{
+            LandmarkMeasurement::from_cartesian(0.99, 0.01, 1),
+            LandmarkMeasurement::from_cartesian(-0.01, 0.99, 2)};
+        KalmanFilter full(0.001, 0.01);
+        KalmanFilter consider(0.001, 0.01);
+        KalmanFilter everything(0.001, 0.01);
+        for (int i = 0; i < 3; i++)
+        {
+            full.run(Pose2D{}, Twist2D{}, all);
+            consider.run(Pose2D{}, Twist2D{}, all);
+            everything.run(Pose2D{}, Twist2D{}, all);
+        }
+        REQUIRE(full.stats().last_active_landmarks == 4);
+        REQUIRE_THROWS_AS(consider.set_consider_distance(-1.0), std::invalid_argument);
+        consider.set_consider_distance(2.0);
+        everything.set_consider_distance(100.0);
+        REQUIRE(almost_equal(consider.consider_distance(), 2.0));
+
+        const arma::mat map_before = consider.map_prediction();
+        const arma::mat sigma_before = consider.covariance();
+        Pose2D pose{};
+        for (int i = 0; i < 5; i++)
+        {
+            pose.x += 0.002;
+            full.run(pose, Twist2D{0.0, 0.002, 0.0}, near);
+            consider.run(pose, Twist2D{0.0, 0.002, 0.0}, near);
+            everything.run(pose, Twist2D{0.0, 0.002, 0.0}, near);
+        }
+        REQUIRE(consider.stats().last_active_landmarks == 2);
+        REQUIRE(everything.stats().last_active_landmarks == 4);
+
+        // with every landmark in range the consider update is the full update
+        REQUIRE(arma::approx_equal(everything.state_prediction(), full.state_prediction(), "absdiff", 1e-9));
+        REQUIRE(arma::approx_equal(everything.covariance(), full.covariance(), "absdiff", 1e-9));
+
+        // the far landmarks keep their means and their covariances with each other
+        const arma::mat map = consider.map_prediction();
+        const arma::mat sigma = consider.covariance();
+        REQUIRE(arma::approx_equal(map.rows(4, 7), map_before.rows(4, 7), "absdiff", 1e-12));
+        REQUIRE(arma::approx_equal(
+            sigma.submat(7, 7, 10, 10), sigma_before.submat(7, 7, 10, 10), "absdiff", 1e-12));
+        REQUIRE(not arma::approx_equal(map.rows(0, 3), map_before.rows(0, 3), "absdiff", 1e-12));
+
+        // the covariance stays symmetric, and is never more confident than the full update
+        REQUIRE(arma::approx_equal(sigma, sigma.t(), "absdiff", 1e-12));
+        REQUIRE(arma::trace(sigma.submat(0, 0, 2, 2)) >= arma::trace(full.covariance().submat(0, 0, 2, 2)) - 1e-12);
+        REQUIRE(arma::approx_equal(consider.pose_prediction(), full.pose_prediction(), "absdiff", 1e-3));
+    }
+
+    // =================
+    //      benchmark
+    // =================
+
+    TEST_CASE("percentile()", "[SampleStats]")
+    {
+        SampleStats stats;
+        REQUIRE(almost_equal(stats.percentile(50.0), 0.0));
+        for (int i = 1; i <= 5; i++)
+        {
+            stats.add(static_cast<double>(i));
+        }
+        REQUIRE(stats.count() == 5);
+        REQUIRE(almost_equal(stats.mean(), 3.0));
+        REQUIRE(almost_equal(stats.min(), 1.0));
+        REQUIRE(almost_equal(stats.max(), 5.0));
+        REQUIRE(almost_equal(stats.percentile(0.0), 1.0));
+        REQUIRE(almost_equal(stats.percentile(50.0), 3.0));
+        REQUIRE(almost_equal(stats.percentile(90.0), 4.6));
+        REQUIRE(almost_equal(stats.percentile(100.0), 5.0));
+    }
+
+    TEST_CASE("Histogram", "[Histogram]")
+    {
+        Histogram hist({1.0, 2.0, 5.0});
+        for (const double v : {0.5, 1.0, 1.5, 3.0, 4.0, 10.0})
+        {
+            hist.add(v);
+        }
+        REQUIRE(hist.counts() == std::vector<size_t>{2, 1, 2, 1});
+        REQUIRE(hist.total() == 6);
+
+        hist.clear();
+        REQUIRE(hist.total() == 0);
+        REQUIRE_THROWS(Histogram({2.0, 1.0}));
+    }
+
+    TEST_CASE("JsonWriter", "[JsonWriter]")
+    {
+        std::stringstream ss;
+        JsonWriter json(ss);
+        json.begin_object();
+        json.key("name");
+        json.value("a\"b");
+        json.key("values");
+        json.begin_array();
+        json.value(1);
+        json.value(2.5);
+        json.value(true);
+        json.end_array();
+        json.end_object();
+        REQUIRE(ss.str() == "{\"name\":\"a\\\"b\",\"values\":[1,2.5,true]}");
+    }
+
+    // =================
+    //       lidar
+    // =================
+
+    TEST_CASE("simulate_lidar()", "[lidar]")
+    {
+        std::mt19937 rng{0};
+        LidarParams params;
+        std::vector<float> ranges;
+
+        // an obstacle straight ahead of a robot facing +y
+        simulate_lidar(Pose2D{1.0, 1.0, PI / 2.0}, {Vector2D{1.0, 3.0}}, 0.1, params, rng, ranges);
+        REQUIRE(ranges.size() == params.num_beams);
+        REQUIRE(almost_equal(ranges.at(0), 1.9, 1e-5));
+        REQUIRE(ranges.at(90) == 0.0f);
+
+        // the nearer obstacle occludes the one behind it, in either order
+        const std::vector<Vector2D> obstacles{Vector2D{3.0, 0.0}, Vector2D{2.0, 0.0}};
+        simulate_lidar(Pose2D{0.0, 0.0, 0.0}, obstacles, 0.1, params, rng, ranges);
+        REQUIRE(almost_equal(ranges.at(0), 1.9, 1e-5));
+        simulate_lidar(Pose2D{0.0, 0.0, 0.0}, {obstacles.at(1), obstacles.at(0)}, 0.1, params, rng, ranges);
+        REQUIRE(almost_equal(ranges.at(0), 1.9, 1e-5));
+
+        // obstacles beyond the maximum range are not seen
+        params.max_range = 1.0;
+        simulate_lidar(Pose2D{0.0, 0.0, 0.0}, obstacles, 0.1, params, rng, ranges);
+        REQUIRE(ranges.at(0) == 0.0f);
+    }
+
+    // =================
+    //       world
+    // =================
+
+    TEST_CASE("generate_world()", "[world]")
+    {
+        WorldParams params;
+        params.x_length = 10.0;
+        params.y_length = 6.0;
+        params.density = 1.0;
+        params.clustering = 0.5;
+        params.seed = 7;
+        const World world = generate_world(params);
+        REQUIRE(not world.obstacles.empty());
+        REQUIRE(world.obstacles.size() <= 60);
+
+        // the same parameters generate the same world
+        const World again = generate_world(params);
+        REQUIRE(again.obstacles.size() == world.obstacles.size());
+        for (size_t i = 0; i < world.obstacles.size(); i++)
+        {
+            REQUIRE(again.obstacles.at(i).x == world.obstacles.at(i).x);
+            REQUIRE(again.obstacles.at(i).y == world.obstacles.at(i).y);
+        }
+
+        for (size_t i = 0; i < world.obstacles.size(); i++)
+        {
+            const auto &p = world.obstacles.at(i);
+            REQUIRE(std::abs(p.x) < 5.0);
+            REQUIRE(std::abs(p.y) < 3.0);
+            REQUIRE(p.magnitude() >= params.start_clearance);
+            for (size_t j = i + 1; j < world.obstacles.size(); j++)
+            {
+                REQUIRE(distance(p, world.obstacles.at(j)) >= params.min_spacing);
+            }
+        }
+    }
+
+    TEST_CASE("read_world_binary()", "[world]")
+    {
+        WorldParams params;
+        params.corridors = 1;
+        const World world = generate_world(params);
+
+        std::stringstream ss;
+        write_world_binary(world, ss);
+        const World read = read_world_binary(ss);
+        REQUIRE(almost_equal(read.x_length, world.x_length));
+        REQUIRE(almost_equal(read.y_length, world.y_length));
+        REQUIRE(almost_equal(read.obstacle_radius, world.obstacle_radius));
+        REQUIRE(read.obstacles.size() == world.obstacles.size());
+        REQUIRE(almost_equal(read.obstacles.back().x, world.obstacles.back().x));
+
+        std::stringstream bad("not a world");
+        REQUIRE_THROWS(read_world_binary(bad));
+    }
+
+    // =================
+    //     scenario
+    // =================
+
+    TEST_CASE("parse_scenario()", "[Scenario]")
+    {
+        std::stringstream ss;
+        ss << "# a square mission\n"
+           << "start 0 0 0\n"
+           << "twist 2.0 0.1 0.0   # drive forward\n"
+           << "wait 1.0\n"
+           << "waypoint 0.2 0.5 0.25 1.0\n";
+        const Scenario scenario = parse_scenario(ss);
+
+        REQUIRE(scenario.get_steps().size() == 4);
+        REQUIRE(almost_equal(scenario.twist_at(1.0).xdot, 0.1));
+        REQUIRE(almost_equal(scenario.twist_at(2.5).xdot, 0.0));
+        REQUIRE(almost_equal(scenario.twist_at(3.1).thetadot, 1.0));
+        REQUIRE(almost_equal(scenario.duration(), 3.0 + PI / 2.0 + 2.0));
+        REQUIRE(almost_equal(scenario.twist_at(scenario.duration() + 1.0).xdot, 0.0));
+
+        const Pose2D end = scenario.end_pose();
+        REQUIRE(almost_equal(end.x, 0.2, 1e-9));
+        REQUIRE(almost_equal(end.y, 0.5, 1e-9));
+        REQUIRE(almost_equal(end.theta, PI / 2.0, 1e-9));
+    }
+
+    TEST_CASE("parse_scenario() errors", "[Scenario]")
+    {
+        std::stringstream bad_command("fly 1.0 2.0\n");
+        REQUIRE_THROWS(parse_scenario(bad_command));
+        std::stringstream bad_number("twist 1.0 fast 0.0\n");
+        REQUIRE_THROWS(parse_scenario(bad_number));
+        std::stringstream negative("wait -1.0\n");
+        REQUIRE_THROWS(parse_scenario(negative));
+    }
+
+    TEST_CASE("AllocationScope", "[alloc_tracker]")
+    {
+        // turtlelib_test links the alloc_hooks library
+        REQUIRE(allocation_tracking_enabled());
+
+        AllocationScope scope;
+        auto p = std::make_unique<std::array<double, 16>>();
+        std::vector<int> v;
+        v.reserve(100);
+        p.reset();
+        const AllocationCounts counts = scope.counts();
+        REQUIRE(counts.allocations == 2);
+        REQUIRE(counts.deallocations == 1);
+        REQUIRE(counts.bytes == 16 * sizeof(double) + 100 * sizeof(int));
+
+        // no heap activity in this scope
+        scope.reset();
+        v.push_back(1);
+        REQUIRE(scope.counts().allocations == 0);
+    }
+
+    TEST_CASE("CallbackProfile", "[alloc_tracker]")
+    {
+        CallbackProfile profile;
+        for (int i = 0; i < 10; i++)
+        {
+            const CallbackProfile::Sample sample(profile);
+            std::vector<double> v(i + 1);
+        }
+        REQUIRE(profile.count() == 10);
+        REQUIRE(almost_equal(profile.allocations().mean(), 1.0));
+        REQUIRE(almost_equal(profile.bytes().max(), 10.0 * sizeof(double)));
+
+        profile.clear();
+        REQUIRE(profile.count() == 0);
+    }
+
+
+    TEST_CASE("TimerJitter", "[realtime]")
+    {
+        using namespace std::chrono_literals;
+        TimerJitter jitter(0.005);
+        const auto t0 = std::chrono::steady_clock::now();
+        jitter.tick(t0);
+        jitter.tick(t0 + 5ms);
+        jitter.tick(t0 + 11ms);
+        jitter.tick(t0 + 15ms);
+        REQUIRE(jitter.count() == 3);
+        REQUIRE(almost_equal(jitter.deviation_us().min(), -1000.0, 1e-6));
+        REQUIRE(almost_equal(jitter.deviation_us().max(), 1000.0, 1e-6));
+        REQUIRE(almost_equal(jitter.deviation_us().mean(), 0.0, 1e-6));
+
+        // the next interval is measured from the last tick
+        jitter.clear();
+        jitter.tick(t0 + 20ms);
+        REQUIRE(jitter.count() == 1);
+        REQUIRE(almost_equal(jitter.deviation_us().max(), 0.0, 1e-6));
+    }
+
+    TEST_CASE("apply_thread_schedule()", "[realtime]")
+    {
+        // the default scheduler needs no privileges
+        REQUIRE_NOTHROW(apply_thread_schedule(ThreadSchedule{}));
+        REQUIRE_THROWS_AS(apply_thread_schedule(ThreadSchedule{100, {}}), std::invalid_argument);
+        REQUIRE_THROWS_AS(apply_thread_schedule(ThreadSchedule{0, {-1}}), std::invalid_argument);
+    }
+
+    TEST_CASE("CallbackWatchdog", "[watchdog]")
+    {
+        CallbackWatchdog watchdog;
+        const auto scan = watchdog.add_callback("scan", 100.0);
+        const auto unbounded = watchdog.add_callback("unbounded", 0.0);
+        REQUIRE(watchdog.size() == 2);
+        REQUIRE_THROWS_AS(watchdog.add_callback("bad", -1.0), std::invalid_argument);
+
+        REQUIRE_FALSE(watchdog.record_duration(scan, 50.0));
+        REQUIRE(watchdog.record_duration(scan, 150.0));
+        REQUIRE_FALSE(watchdog.record_duration(unbounded, 1e9));
+        REQUIRE(watchdog.health(scan).calls == 2);
+        REQUIRE(watchdog.health(scan).overruns == 1);
+        REQUIRE(almost_equal(watchdog.health(scan).max_duration_us, 150.0));
+
+        const auto overruns = watchdog.take_overruns();
+        REQUIRE(overruns.size() == 1);
+        REQUIRE(overruns.at(0).callback == "scan");
+        REQUIRE(almost_equal(overruns.at(0).duration_us, 150.0));
+        REQUIRE(watchdog.take_overruns().empty());
+
+        // messages stamped every 0.2 s, the last one handled 0.65 s after its stamp
+        watchdog.record_message(scan, 1.0, 1.0);
+        watchdog.record_message(scan, 1.2, 1.2);
+        watchdog.record_message(scan, 1.4, 2.05);
+        REQUIRE(watchdog.health(scan).max_queue_depth == 3);
+        REQUIRE(almost_equal(watchdog.health(scan).max_message_age_s, 0.65, 1e-9));
+
+        watchdog.record_lost(scan, 4);
+        REQUIRE(watchdog.health(scan).messages_lost == 4);
+
+        {
+            CallbackWatchdog::Scope scope(watchdog, unbounded);
+        }
+        REQUIRE(watchdog.health(unbounded).calls == 2);
+
+        watchdog.reset();
+        REQUIRE(watchdog.health(scan).calls == 0);
+        REQUIRE(watchdog.health(scan).messages_lost == 0);
+        REQUIRE(almost_equal(watchdog.health(scan).budget_us, 100.0));
+    }
+
+    TEST_CASE("WheelOdometry", "[WheelOdometry]")
+    {
+        WheelOdometry odom(DiffDrive(0.033, 0.16));
+        REQUIRE(odom.updates() == 0);
+
+        // both wheels turn half a revolution: straight ahead by pi r
+        odom.update(WheelState{M_PI, M_PI}, WheelState{1.0, 1.0});
+        REQUIRE(odom.updates() == 1);
+        REQUIRE(almost_equal(odom.pose().x, 0.033 * M_PI));
+        REQUIRE(almost_equal(odom.pose().y, 0.0));
+        REQUIRE(almost_equal(odom.twist().xdot, 0.033));
+        REQUIRE(almost_equal(odom.wheel_angles().left, M_PI));
+
+        // the same angles again add no motion
+        odom.update(WheelState{M_PI, M_PI}, WheelState{0.0, 0.0});
+        REQUIRE(almost_equal(odom.pose().x, 0.033 * M_PI));
+        REQUIRE(almost_equal(odom.twist().xdot, 0.0));
+
+        // a new pose keeps the wheel angles, so only later motion is added to it
+        odom.set_pose(Pose2D{1.0, 2.0, M_PI / 2});
+        odom.update(WheelState{2 * M_PI, 2 * M_PI}, WheelState{1.0, 1.0});
+        REQUIRE(almost_equal(odom.pose().x, 1.0));
+        REQUIRE(almost_equal(odom.pose().y, 2.0 + 0.033 * M_PI));
+        REQUIRE(almost_equal(odom.pose().theta, M_PI / 2));
+    }
+
+    TEST_CASE("WheelOdometry with gyro", "[WheelOdometry]")
+    {
+        WheelOdometry odom(DiffDrive(0.033, 0.16));
+        REQUIRE_THROWS_AS(odom.set_gyro_weight(1.5), std::invalid_argument);
+
+        // standing still with a gyro which reads 0.01 rad/s: the reading is all bias
+        for (int i = 0; i < 200; i++)
+        {
+            odom.add_gyro(0.01, i * 0.01);
+            odom.update(WheelState{0.0, 0.0}, WheelState{0.0, 0.0});
+        }
+        REQUIRE(almost_equal(odom.gyro_bias(), 0.01, 1e-6));
+        REQUIRE(almost_equal(odom.pose().theta, 0.0));
+
+        // over the next second the wheels slip and report twice the true rotation of
+        // 0.5 rad, which the gyro measures on top of its bias
+        odom.set_gyro_weight(1.0);
+        odom.add_gyro(0.51, 2.99);
+        const double wheel_turn = 1.0 * 0.16 / 0.033 / 2.0;
+        odom.update(WheelState{-wheel_turn, wheel_turn}, WheelState{0.0, 0.0});
+        REQUIRE(almost_equal(odom.pose().theta, 0.5, 1e-5));
+
+        // with half the weight, half of each
+        odom.set_gyro_weight(0.5);
+        odom.add_gyro(0.51, 3.99);
+        odom.update(WheelState{-2 * wheel_turn, 2 * wheel_turn}, WheelState{0.0, 0.0});
+        REQUIRE(almost_equal(odom.pose().theta, 1.25, 1e-5));
+    }
+
+    TEST_CASE("WheelOdometry with gyro at another rate", "[WheelOdometry]")
+    {
+        // joint states at 200 Hz, and a gyro with a bias of 0.01 rad/s read at 100 Hz,
+        // 3 ms after every other joint state
+        WheelOdometry odom(DiffDrive(0.033, 0.16));
+        odom.set_gyro_weight(1.0);
+        const double wheel_rate = 0.5 * 0.16 / 0.033 / 2.0;
+        double next_gyro = 0.003;
+
+        // the robot stands still for 2 s, then turns in place at 0.5 rad/s for 1 s. The
+        // encoders only tick every 10 ms, so every other joint state repeats the angles
+        for (int k = 1; k <= 600; k++)
+        {
+            const double t = k * 0.005;
+            for (; next_gyro <= t; next_gyro += 0.01)
+            {
+                odom.add_gyro(next_gyro > 2.0 ? 0.51 : 0.01, next_gyro);
+            }
+            const double angle = k > 400 ? wheel_rate * 0.005 * ((k - 400) - k % 2) : 0.0;
+
+            // the wheels report the same angles while the gyro reads the turn
+            odom.update(WheelState{-angle, angle}, WheelState{-wheel_rate, wheel_rate});
+            if (k == 400)
+            {
+                REQUIRE(almost_equal(odom.gyro_bias(), 0.01, 1e-9));
+            }
+        }
+
+        // the turn was not taken for bias, and none of the heading it read was lost
+        REQUIRE(almost_equal(odom.gyro_bias(), 0.01, 1e-9));
+        REQUIRE(almost_equal(odom.pose().theta, 0.5, 1e-6));
+
+        // once the robot stands still again, only the readings after it stopped are bias
+        for (int k = 601; k <= 1000; k++)
+        {
+            const double t = k * 0.005;
+            for (; next_gyro <= t; next_gyro += 0.01)
+            {
+                odom.add_gyro(0.01, next_gyro);
+            }
+            odom.update(WheelState{-wheel_rate, wheel_rate}, WheelState{0.0, 0.0});
+        }
+        REQUIRE(almost_equal(odom.gyro_bias(), 0.01, 1e-3));
+    }
+
+    TEST_CASE("PoseExtrapolator", "[PoseExtrapolator]")
+    {
+        REQUIRE_THROWS_AS(PoseExtrapolator(-1.0), std::invalid_argument);
+
+        // an estimate made when the odometry was at (1, 0) facing +y
+        PoseExtrapolator at_once;
+        at_once.correct(Pose2D{2.0, 1.0, M_PI / 2}, Pose2D{1.0, 0.0, M_PI / 2}, 0.0);
+
+        // half a meter of odometry since then is applied on top of the estimate
+        const Pose2D p = at_once.predict(Pose2D{1.0, 0.5, M_PI / 2}, 0.1);
+        REQUIRE(almost_equal(p.x, 2.0));
+        REQUIRE(almost_equal(p.y, 1.5));
+        REQUIRE(almost_equal(p.theta, M_PI / 2));
+
+        // a correction is applied a fraction at a time over the blend time
+        PoseExtrapolator blended(1.0);
+        blended.correct(Pose2D{1.0, 0.0, 0.0}, Pose2D{}, 0.0);
+        const Pose2D start = blended.predict(Pose2D{}, 0.0);
+        REQUIRE(almost_equal(start.x, 0.0));
+        const Pose2D half = blended.predict(Pose2D{}, 0.5);
+        REQUIRE(almost_equal(half.x, 0.5));
+        const Pose2D done = blended.predict(Pose2D{}, 2.0);
+        REQUIRE(almost_equal(done.x, 1.0));
+        REQUIRE(almost_equal(blended.target().translation().x, 1.0));
+
+        // rotations blend the short way around
+        PoseExtrapolator wrap(1.0);
+        wrap.correct(Pose2D{0.0, 0.0, 3.0}, Pose2D{}, 0.0);
+        wrap.correct(Pose2D{0.0, 0.0, -3.0}, Pose2D{}, 10.0);
+        const Pose2D mid = wrap.predict(Pose2D{}, 10.5);
+        REQUIRE(almost_equal(std::abs(mid.theta), M_PI, 1e-9));
+    }
+
+    TEST_CASE("MovingObstacles", "[MovingObstacles]")
+    {
+        MovingObstacleParams bad;
+        bad.speed = -1.0;
+        REQUIRE_THROWS_AS(MovingObstacles(bad), std::invalid_argument);
+
+        MovingObstacleParams params;
+        params.speed = 1.0;
+        params.turn_stddev = 0.5;
+        params.x_length = 2.0;
+        params.y_length = 2.0;
+        MovingObstacles movers(params);
+        movers.add_patrol(Vector2D{0.0, 0.0}, Vector2D{1.0, 0.0});
+        movers.add_random_walk(Vector2D{0.0, 0.5}, 0.0);
+        REQUIRE(movers.size() == 2);
+        const Vector2D *storage = movers.positions().data();
+
+        // a patrol turns around at its goal and carries on back towards its start
+        std::mt19937 rng(7);
+        movers.step(0.75, rng);
+        REQUIRE(almost_equal(movers.positions().at(0).x, 0.75));
+        movers.step(0.5, rng);
+        REQUIRE(almost_equal(movers.positions().at(0).x, 0.75));
+        movers.step(1.0, rng);
+        REQUIRE(almost_equal(movers.positions().at(0).x, 0.25));
+
+        // a random walk never leaves the arena, and the positions are updated in place
+        for (int i = 0; i < 10000; i++)
+        {
+            movers.step(0.05, rng);
+            const Vector2D &p = movers.positions().at(1);
+            REQUIRE(std::abs(p.x) <= 0.9 + 1e-12);
+            REQUIRE(std::abs(p.y) <= 0.9 + 1e-12);
+        }
+        REQUIRE(movers.positions().data() == storage);
+
+        // the same seed gives the same walk
+        MovingObstacles a(params), b(params);
+        a.add_random_walk(Vector2D{}, 1.0);
+        b.add_random_walk(Vector2D{}, 1.0);
+        std::mt19937 rng_a(3), rng_b(3);
+        for (int i = 0; i < 100; i++)
+        {
+            a.step(0.1, rng_a);
+            b.step(0.1, rng_b);
+        }
+        REQUIRE(almost_equal(a.positions().at(0).x, b.positions().at(0).x));
+        REQUIRE(almost_equal(a.positions().at(0).y, b.positions().at(0).y));
+    }
+
+    TEST_CASE("ExplorationPlanner", "[ExplorationPlanner]")
+    {
+        ExplorationParams bad;
+        bad.cell_size = 0.0;
+        REQUIRE_THROWS_AS(ExplorationPlanner(bad), std::invalid_argument);
+
+        ExplorationParams params;
+        params.x_length = 4.0;
+        params.y_length = 4.0;
+        params.sensor_range = 1.0;
+        ExplorationPlanner planner(params);
+        REQUIRE(almost_equal(planner.explored_fraction(), 0.0));
+
+        // standing at the origin explores about a unit circle of the 16 m^2 arena
+        planner.observe(Pose2D{0.0, 0.0, 0.0});
+        REQUIRE(planner.explored_fraction() > 0.15);
+        REQUIRE(planner.explored_fraction() < 0.25);
+
+        // an uncertain landmark is worth more than a well known one
+        const std::array<double, 3> certain{0.0, 0.0, 0.0};
+        LandmarkBelief known{Vector2D{0.0, 0.0}, {0.01, 0.0, 0.01}};
+        LandmarkBelief unknown{Vector2D{0.0, 0.0}, {1.0, 0.0, 1.0}};
+        REQUIRE(planner.information_gain(Vector2D{}, certain, {unknown}) >
+                planner.information_gain(Vector2D{}, certain, {known}));
+        REQUIRE(almost_equal(planner.information_gain(Vector2D{}, certain, {unknown}), std::log(2.0)));
+
+        // and an uncertain robot learns more from a well known landmark
+        const std::array<double, 3> lost{1.0, 0.0, 1.0};
+        REQUIRE(planner.information_gain(Vector2D{}, lost, {known}) >
+                planner.information_gain(Vector2D{}, certain, {known}) + 0.5);
+
+        // with the area around the robot explored, it heads for the unexplored arena,
+        // but not through the landmark in its way
+        const std::array<double, 9> pose_cov{0.0, 0.0, 0.0, 0.0, 0.01, 0.0, 0.0, 0.0, 0.01};
+        const Waypoint w = planner.plan(Pose2D{0.0, 0.0, 0.0}, pose_cov, {});
+        REQUIRE(w.gain > 0.0);
+        REQUIRE(distance(w.position, Vector2D{}) > 0.49);
+        for (const auto &c : planner.candidates(Pose2D{0.0, 0.0, 0.0}, pose_cov, {}))
+        {
+            REQUIRE(c.score <= w.score);
+        }
+        LandmarkBelief in_way{w.position * 0.5, {0.01, 0.0, 0.01}};
+        for (const auto &c : planner.candidates(Pose2D{0.0, 0.0, 0.0}, pose_cov, {in_way}))
+        {
+            REQUIRE_FALSE(almost_equal(distance(c.position, w.position), 0.0));
+        }
+
+        // every waypoint stays inside the arena
+        for (const auto &c : planner.candidates(Pose2D{1.5, 1.5, 0.0}, pose_cov, {}))
+        {
+            REQUIRE(std::abs(c.position.x) <= 1.75);
+            REQUIRE(std::abs(c.position.y) <= 1.75);
+        }
+
+        // once everything is explored and known there is nowhere worth going
+        for (double x = -2.0; x <= 2.0; x += 0.5)
+        {
+            for (double y = -2.0; y <= 2.0; y += 0.5)
+            {
+                planner.observe(Pose2D{x, y, 0.0});
+            }
+        }
+        REQUIRE(almost_equal(planner.explored_fraction(), 1.0));
+        const Waypoint done = planner.plan(Pose2D{0.0, 0.0, 0.0}, pose_cov, {known});
+        REQUIRE(almost_equal(done.gain, 0.0));
+    }
+
+    TEST_CASE("Scan log", "[ScanLog]")
+    {
+        // one obstacle straight ahead, another behind it and one out of range
+        RecordedScan scan;
+        scan.stamp = 1.5;
+        scan.pose = Pose2D{1.0, 2.0, M_PI / 2};
+        scan.obstacles = {Vector2D{1.0, 3.0}, Vector2D{1.0, 4.0}, Vector2D{1.0, 20.0}};
+        LidarParams lidar;
+        std::mt19937 rng(1);
+        simulate_lidar(scan.pose, scan.obstacles, 0.038, lidar, rng, scan.ranges);
+        scan.angle_increment = lidar.angle_increment;
+
+        std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+        write_scan_log_header(ss, 0.038);
+        write_recorded_scan(ss, scan);
+        write_recorded_scan(ss, scan);
+        const std::string full = ss.str();
+
+        std::stringstream in(full, std::ios::in | std::ios::binary);
+        const ScanLog log = read_scan_log(in);
+        REQUIRE(almost_equal(log.obstacle_radius, 0.038));
+        REQUIRE(log.scans.size() == 2);
+        REQUIRE(almost_equal(log.scans.at(1).stamp, 1.5));
+        REQUIRE(almost_equal(log.scans.at(1).pose.theta, M_PI / 2));
+        REQUIRE(log.scans.at(1).ranges == scan.ranges);
+        REQUIRE(log.scans.at(1).obstacles.size() == 3);
+        REQUIRE(almost_equal(log.scans.at(1).obstacles.at(2).y, 20.0));
+
+        // an interrupted recording keeps the complete scans
+        std::stringstream cut(full.substr(0, full.size() - 10), std::ios::in | std::ios::binary);
+        REQUIRE(read_scan_log(cut).scans.size() == 1);
+        std::stringstream bad("TWLD", std::ios::in | std::ios::binary);
+        REQUIRE_THROWS_AS(read_scan_log(bad), std::runtime_error);
+
+        // only the obstacle in front is visible, one meter ahead of the sensor
+        const auto visible = visible_obstacles(log.scans.at(0), log.obstacle_radius, 0.01);
+        REQUIRE(visible.size() == 1);
+        REQUIRE(almost_equal(visible.at(0).x, 1.0));
+        REQUIRE(almost_equal(visible.at(0).y, 0.0));
+        // it spans only a few beams
+        REQUIRE(visible_obstacles(log.scans.at(0), log.obstacle_radius, 0.01, 20).empty());
+
+        // each obstacle matches one detection, the closest
+        const DetectionScore score = score_detections(
+            {Vector2D{1.02, 0.0}, Vector2D{1.0, 0.01}, Vector2D{3.0, 0.0}},
+            {Vector2D{1.0, 0.0}, Vector2D{0.0, 1.0}}, 0.05);
+        REQUIRE(score.true_positives == 1);
+        REQUIRE(score.false_positives == 2);
+        REQUIRE(score.false_negatives == 1);
+        REQUIRE(almost_equal(score.precision(), 1.0 / 3.0));
+        REQUIRE(almost_equal(score.recall(), 0.5));
+        REQUIRE(almost_equal(DetectionScore{}.precision(), 1.0));
+    }
+
+    TEST_CASE("Resource monitor", "[ResourceMonitor]")
+    {
+        // the name may hold spaces and parentheses
+        const ProcStat stat = parse_proc_stat(
+            "1234 (slam (main) 1) S 1 1234 1234 0 -1 4194560 500 0 0 0 250 50 0 0 20 0 3 0 100",
+            100.0);
+        REQUIRE(stat.name == "slam (main) 1");
+        REQUIRE(almost_equal(stat.user_s, 2.5));
+        REQUIRE(almost_equal(stat.system_s, 0.5));
+        REQUIRE(stat.threads == 3);
+        REQUIRE_THROWS_AS(parse_proc_stat("1234 (slam) S 1", 100.0), std::runtime_error);
+        REQUIRE_THROWS_AS(parse_proc_stat("", 100.0), std::runtime_error);
+
+        ResourceMonitor monitor;
+        const size_t scans = monitor.add_subscription("/scan");
+        const size_t odom = monitor.add_publisher("odom");
+        for (int i = 0; i < 10; i++)
+        {
+            monitor.count(scans);
+        }
+        monitor.count(odom);
+
+        // keep a core busy long enough to span several clock ticks
+        const Stopwatch busy;
+        volatile double sink = 0.0;
+        while (busy.elapsed_s() < 0.1)
+        {
+            sink = sink + std::sqrt(busy.elapsed_us());
+        }
+
+        const ResourceReport report = monitor.report();
+        REQUIRE(report.interval_s >= 0.1);
+        REQUIRE(report.cpu_percent > 0.0);
+        REQUIRE(report.total_cpu_s > 0.0);
+        REQUIRE(report.rss_kb > 0);
+        REQUIRE(not report.threads.empty());
+        REQUIRE(report.topics.size() == 2);
+        REQUIRE(report.topics.at(0).topic == "/scan");
+        REQUIRE(not report.topics.at(0).published);
+        REQUIRE(report.topics.at(0).messages == 10);
+        REQUIRE(almost_equal(report.topics.at(0).rate_hz, 10 / report.interval_s));
+        REQUIRE(report.topics.at(1).published);
+        REQUIRE(not report.summary().empty());
+        REQUIRE(report.key_values().size() == 6 + report.threads.size() + 2);
+
+        // counts start over with every report
+        REQUIRE(monitor.report().topics.at(0).messages == 0);
+    }
+
+    TEST_CASE("Scan rate controller", "[ScanRateController]")
+    {
+        ScanRateParams params;
+        params.min_rate = 1.0;
+        params.max_rate = 5.0;
+        ScanRateController controller(params);
+
+        // full rate until both an uncertainty and a speed are known
+        REQUIRE(almost_equal(controller.demand(0.0), 1.0));
+        controller.set_uncertainty(0.0, 0.01, 0.01);
+        REQUIRE(almost_equal(controller.rate(0.0), 5.0));
+        controller.set_speed(0.0, 0.0, 0.0);
+        REQUIRE(almost_equal(controller.demand(0.0), 0.0));
+        REQUIRE(almost_equal(controller.rate(0.0), 1.0));
+
+        // the largest of the demands wins, each placed between its thresholds
+        controller.set_speed(0.0, -0.06, 0.0);
+        REQUIRE(almost_equal(controller.demand(0.0), 0.5));
+        controller.set_speed(0.0, 0.0, 1.0);
+        REQUIRE(almost_equal(controller.demand(0.0), 1.0));
+        controller.set_speed(0.0, 0.0, 0.0);
+
+        // the position uses its most uncertain direction, here along x = y
+        std::array<double, 9> cov{};
+        cov.at(4) = 0.0015;
+        cov.at(5) = 0.0021;
+        cov.at(8) = 0.0015;
+        controller.set_pose_covariance(0.0, cov);
+        REQUIRE(almost_equal(controller.demand(0.0), (0.06 - 0.02) / (0.1 - 0.02)));
+        controller.set_uncertainty(0.0, 0.01, 0.01);
+
+        // a 5 Hz sensor is processed at 1 Hz while confident and slow
+        size_t accepted = 0;
+        for (int i = 0; i < 50; i++)
+        {
+            const double stamp = 0.2 * i;
+            controller.set_uncertainty(stamp, 0.01, 0.01);
+            controller.set_speed(stamp, 0.0, 0.0);
+            accepted += controller.accept(stamp);
+        }
+        REQUIRE(accepted == 10);
+        REQUIRE(controller.accepted() == 10);
+        REQUIRE(controller.skipped() == 40);
+
+        // and at every scan while uncertain
+        controller.reset_counts();
+        for (int i = 50; i < 100; i++)
+        {
+            const double stamp = 0.2 * i;
+            controller.set_uncertainty(stamp, 0.2, 0.01);
+            controller.set_speed(stamp, 0.0, 0.0);
+            controller.accept(stamp);
+        }
+        REQUIRE(controller.accepted() == 50);
+        REQUIRE(controller.skipped() == 0);
+
+        // old estimates are not trusted
+        controller.set_uncertainty(20.0, 0.01, 0.01);
+        controller.set_speed(20.0, 0.0, 0.0);
+        REQUIRE(almost_equal(controller.demand(21.0), 0.0));
+        REQUIRE(almost_equal(controller.demand(22.5), 1.0));
+
+        params.timeout = 0.5;
+        REQUIRE_THROWS_AS(ScanRateController(params), std::invalid_argument);
+        params.timeout = 2.0;
+        params.max_rate = 0.5;
+        REQUIRE_THROWS_AS(ScanRateController(params), std::invalid_argument);
+        params.max_rate = 5.0;
+        params.fast_speed = 0.0;
+        REQUIRE_THROWS_AS(ScanRateController(params), std::invalid_argument);
+    }
+
+    TEST_CASE("Thread pool", "[ThreadPool]")
+    {
+        REQUIRE_THROWS_AS(ThreadPool(0), std::invalid_argument);
+
+        ThreadPool pool(4);
+        REQUIRE(pool.size() == 4);
+
+        // every item is visited once, in contiguous chunks numbered in order
+        std::vector<int> visits(10, 0);
+        std::vector<std::pair<size_t, size_t>> chunks(4, {0, 0});
+        pool.parallel_for(
+            visits.size(),
+            [&](size_t chunk, size_t begin, size_t end)
+            {
+                chunks.at(chunk) = {begin, end};
+                for (size_t i = begin; i < end; i++)
+                {
+                    visits.at(i)++;
+                }
+            });
+        REQUIRE(visits == std::vector<int>(10, 1));
+        REQUIRE(chunks == std::vector<std::pair<size_t, size_t>>{{0, 3}, {3, 6}, {6, 8}, {8, 10}});
+
+        // chunks without items are not run
+        size_t calls = 0;
+        std::mutex calls_mutex;
+        pool.parallel_for(2, [&](size_t, size_t, size_t)
+                          { const std::lock_guard<std::mutex> lock(calls_mutex); calls++; });
+        REQUIRE(calls == 2);
+        pool.parallel_for(0, [&](size_t, size_t, size_t) { calls++; });
+        REQUIRE(calls == 2);
+
+        // an exception of a worker reaches the caller once every chunk has finished, and
+        // the pool can be used again
+        std::atomic<size_t> finished{0};
+        REQUIRE_THROWS_AS(
+            pool.parallel_for(
+                8,
+                [&](size_t chunk, size_t, size_t)
+                {
+                    finished++;
+                    if (chunk == 2)
+                    {
+                        throw std::runtime_error("chunk 2");
+                    }
+                }),
+            std::runtime_error);
+        REQUIRE(finished == 4);
+        std::atomic<size_t> sum{0};
+        pool.parallel_for(100, [&](size_t, size_t begin, size_t end)
+                          { for (size_t i = begin; i < end; i++) { sum += i; } });
+        REQUIRE(sum == 4950);
+
+        // a pool of one thread runs the work on the caller
+        ThreadPool single(1);
+        std::thread::id ran_on;
+        single.parallel_for(5, [&](size_t, size_t, size_t) { ran_on = std::this_thread::get_id(); });
+        REQUIRE(ran_on == std::this_thread::get_id());
+    }
 }